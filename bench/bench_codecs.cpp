@@ -0,0 +1,151 @@
+#include "bench_common.h"
+#include "compressor/image_metrics.h"
+#include "compressor/image_processor.h"
+#include "compressor/video_processor.h"
+#include <format>
+#include <random>
+
+namespace media_handler::bench {
+
+    using compressor::ImageProcessor;
+    using compressor::VideoProcessor;
+
+    /// @brief Time ImageProcessor::compress on one generated input; reports MP/s and input bytes/s,
+    /// and with `report_ratio` the output/input size.
+    template <class Generate>
+    static void run_image(benchmark::State& state, const std::string& ext, Generate generate, const utils::Config& cfg = {},
+        bool report_ratio = false) {
+        const int w = static_cast<int>(state.range(0));
+        const int h = static_cast<int>(state.range(1));
+        auto in = cached_input(state, std::format("in_{}x{}{}", w, h, ext), [&](const fs::path& f) { return generate(f, w, h); });
+        if (in.empty()) return;
+
+        ImageProcessor proc(cfg, null_logger());
+        const auto out = scratch_dir() / std::format("out_{}x{}{}", w, h, ext);
+        for (auto _ : state) {
+            auto r = proc.compress(in, out);
+            if (!r.success) { state.SkipWithError(r.message.c_str()); return; }
+        }
+
+        const double iters = static_cast<double>(state.iterations());
+        state.counters["MP/s"] = benchmark::Counter(w * static_cast<double>(h) / 1e6 * iters, benchmark::Counter::kIsRate);
+        state.SetBytesProcessed(static_cast<std::int64_t>(fs::file_size(in) * state.iterations()));
+        if (report_ratio) state.counters["ratio"] = static_cast<double>(fs::file_size(out)) / fs::file_size(in);
+    }
+
+    static void BM_CompressJpeg(benchmark::State& state) {
+        run_image(state, ".jpg", [](const fs::path& f, int w, int h) { return tools::write_jpeg(f, w, h, 95, 1); });
+    }
+
+    static void BM_CompressPng(benchmark::State& state) {
+        run_image(state, ".png", [](const fs::path& f, int w, int h) { return tools::write_png(f, w, h, 2); });
+    }
+
+    static void BM_CompressHeic(benchmark::State& state) {
+        run_image(state, ".heic", [](const fs::path& f, int w, int h) { return tools::write_heic(f, w, h, 90, 3); });
+    }
+
+    /// @brief VGA, 1080p and 12 MP (typical phone photo).
+    static void image_sizes(benchmark::internal::Benchmark* b) {
+        b->Args({ 640, 480 })->Args({ 1920, 1080 })->Args({ 4000, 3000 })->Unit(benchmark::kMillisecond)->UseRealTime();
+    }
+
+    BENCHMARK(BM_CompressJpeg)->Apply(image_sizes);
+    BENCHMARK(BM_CompressPng)->Apply(image_sizes);
+    BENCHMARK(BM_CompressHeic)->Apply(image_sizes);
+
+    /// @brief One quality-95 JPEG inside the trim box through each jpeg_mode (arg 2: 0 = reencode,
+    /// 1 = lossless, 2 = requantize); reports output/input size next to the time.
+    static void BM_JpegMode(benchmark::State& state) {
+        static constexpr const char* modes[] = { "reencode", "lossless", "requantize" };
+        const auto mode = modes[state.range(2)];
+        state.SetLabel(mode);
+        utils::Config cfg;
+        cfg.jpeg_mode = mode;
+        run_image(state, ".jpg", [](const fs::path& f, int w, int h) { return tools::write_jpeg(f, w, h, 95, 1); }, cfg, true);
+    }
+
+    BENCHMARK(BM_JpegMode)->ArgsProduct({ { 1920 }, { 1080 }, { 0, 1, 2 } })->Unit(benchmark::kMillisecond)->UseRealTime();
+
+    /// @brief A quality-95 JPEG re-encoded under each jpeg_profile (arg 2: 0 = fast, 1 = balanced,
+    /// 2 = max-compression), inside the trim box and downscaled from 12 MP; reports output/input size.
+    static void BM_JpegProfile(benchmark::State& state) {
+        static constexpr const char* profiles[] = { "fast", "balanced", "max-compression" };
+        const auto profile = profiles[state.range(2)];
+        state.SetLabel(profile);
+        utils::Config cfg;
+        cfg.jpeg_profile = profile;
+        run_image(state, ".jpg", [](const fs::path& f, int w, int h) { return tools::write_jpeg(f, w, h, 95, 1); }, cfg, true);
+    }
+
+    BENCHMARK(BM_JpegProfile)->ArgsProduct({ { 1920 }, { 1080 }, { 0, 1, 2 } })->Unit(benchmark::kMillisecond)->UseRealTime();
+    BENCHMARK(BM_JpegProfile)->ArgsProduct({ { 4000 }, { 3000 }, { 0, 1, 2 } })->Unit(benchmark::kMillisecond)->UseRealTime();
+
+    /// @brief A quality-95 JPEG re-encoded at a fixed quality and with a searched one (arg 2: 0 = quality 80,
+    /// 1 = jpeg_target_ssim 0.95, 2 = jpeg_target_bpp 1.0); the difference is the probe search. Reports output/input size.
+    static void BM_JpegTarget(benchmark::State& state) {
+        static constexpr const char* labels[] = { "quality-80", "ssim-0.95", "bpp-1.0" };
+        state.SetLabel(labels[state.range(2)]);
+        utils::Config cfg;
+        if (state.range(2) == 1) cfg.jpeg_target_ssim = 0.95;
+        if (state.range(2) == 2) cfg.jpeg_target_bpp = 1.0;
+        run_image(state, ".jpg", [](const fs::path& f, int w, int h) { return tools::write_jpeg(f, w, h, 95, 1); }, cfg, true);
+    }
+
+    BENCHMARK(BM_JpegTarget)->ArgsProduct({ { 1920 }, { 1080 }, { 0, 1, 2 } })->Unit(benchmark::kMillisecond)->UseRealTime();
+    BENCHMARK(BM_JpegTarget)->ArgsProduct({ { 4000 }, { 3000 }, { 0, 1, 2 } })->Unit(benchmark::kMillisecond)->UseRealTime();
+
+    /// @brief Luma SSIM of two noisy 1080p planes on each kernel (arg 0: SsimKernel); unsupported kernels are skipped.
+    static void BM_Ssim(benchmark::State& state) {
+        const auto kernel = static_cast<compressor::SsimKernel>(state.range(0));
+        state.SetLabel(compressor::to_string(kernel));
+        if (!compressor::ssim_kernel_supported(kernel)) { state.SkipWithError("kernel not supported on this CPU"); return; }
+        constexpr unsigned w = 1920, h = 1080;
+        std::vector<std::uint8_t> a(w * h), b(w * h);
+        std::mt19937 rng(7);
+        for (std::size_t i = 0; i < a.size(); ++i) {
+            a[i] = static_cast<std::uint8_t>((i % w + i / w) / 12 + rng() % 32);
+            b[i] = static_cast<std::uint8_t>(std::min<unsigned>(255, a[i] + rng() % 9));
+        }
+        for (auto _ : state) benchmark::DoNotOptimize(compressor::ssim({ a.data(), w, w, h }, { b.data(), w, w, h }, kernel));
+        state.counters["MP/s"] = benchmark::Counter(w * static_cast<double>(h) / 1e6 * state.iterations(), benchmark::Counter::kIsRate);
+    }
+
+    BENCHMARK(BM_Ssim)->DenseRange(0, 3)->Unit(benchmark::kMicrosecond);
+
+    /// @brief A quality-95 JPEG re-encoded with and without the SSIM check (arg 2: 0 = off, 1 = jpeg_verify_ssim 0.5,
+    /// which every output passes); the difference is the whole-image decode path plus one luma decode and score.
+    static void BM_JpegVerify(benchmark::State& state) {
+        state.SetLabel(state.range(2) ? "verify" : "no-verify");
+        utils::Config cfg;
+        if (state.range(2)) cfg.jpeg_verify_ssim = 0.5;
+        run_image(state, ".jpg", [](const fs::path& f, int w, int h) { return tools::write_jpeg(f, w, h, 95, 1); }, cfg);
+    }
+
+    BENCHMARK(BM_JpegVerify)->ArgsProduct({ { 1920 }, { 1080 }, { 0, 1 } })->Unit(benchmark::kMillisecond)->UseRealTime();
+    BENCHMARK(BM_JpegVerify)->ArgsProduct({ { 4000 }, { 3000 }, { 0, 1 } })->Unit(benchmark::kMillisecond)->UseRealTime();
+
+    /// @brief Time VideoProcessor::compress on a short generated clip; reports frames/s and MP/s.
+    static void BM_CompressVideo(benchmark::State& state) {
+        const int w = static_cast<int>(state.range(0));
+        const int h = static_cast<int>(state.range(1));
+        constexpr int frames = 60, fps = 30;
+        auto in = cached_input(state, std::format("in_{}x{}.mp4", w, h),
+            [&](const fs::path& f) { return tools::write_video(f, w, h, frames, fps, "libx264", 4); });
+        if (in.empty()) return;
+
+        VideoProcessor proc(utils::Config{}, null_logger());
+        const auto out = scratch_dir() / std::format("out_{}x{}.mp4", w, h);
+        for (auto _ : state) {
+            auto r = proc.compress(in, out);
+            if (!r.success) { state.SkipWithError(r.message.c_str()); return; }
+        }
+
+        const double iters = static_cast<double>(state.iterations());
+        state.counters["frames/s"] = benchmark::Counter(frames * iters, benchmark::Counter::kIsRate);
+        state.counters["MP/s"] = benchmark::Counter(w * static_cast<double>(h) * frames / 1e6 * iters, benchmark::Counter::kIsRate);
+    }
+
+    BENCHMARK(BM_CompressVideo)->Args({ 640, 360 })->Args({ 1280, 720 })->Args({ 1920, 1080 })->Unit(benchmark::kMillisecond)->UseRealTime();
+
+} // namespace media_handler::bench
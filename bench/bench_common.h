@@ -0,0 +1,86 @@
+#pragma once
+#include "tools/synthetic_media.h"
+#include "utils/config.h"
+#include <benchmark/benchmark.h>
+#include <cstdio>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <spdlog/spdlog.h>
+#include <spdlog/sinks/null_sink.h>
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+#include <malloc.h>
+#define MEDIA_HANDLER_HAVE_MALLINFO2 1
+#endif
+
+namespace media_handler::bench {
+
+    namespace fs = std::filesystem;
+
+    /// @brief Logger that drops everything, so benchmarks time the work and not the log queue.
+    inline std::shared_ptr<spdlog::logger> null_logger() {
+        static auto logger = std::make_shared<spdlog::logger>("bench", std::make_shared<spdlog::sinks::null_sink_mt>());
+        return logger;
+    }
+
+    /// @brief Scratch directory for generated inputs and outputs; recreated once per process.
+    inline const fs::path& scratch_dir() {
+        static const fs::path dir = [] {
+            auto d = fs::temp_directory_path() / "media_handler_bench";
+            std::error_code ec;
+            fs::remove_all(d, ec);
+            fs::create_directories(d);
+            return d;
+        }();
+        return dir;
+    }
+
+    /// @brief Current resident set size in bytes (Linux; 0 elsewhere). Deltas give a structure's footprint.
+    inline std::uint64_t current_rss() {
+#ifdef __linux__
+        unsigned long long pages = 0, resident = 0;
+        FILE* f = std::fopen("/proc/self/statm", "r");
+        if (!f) return 0;
+        const bool ok = std::fscanf(f, "%llu %llu", &pages, &resident) == 2;
+        std::fclose(f);
+        return ok ? resident * static_cast<std::uint64_t>(sysconf(_SC_PAGESIZE)) : 0;
+#else
+        return 0;
+#endif
+    }
+
+    /// @brief Bytes currently allocated from the heap (glibc mallinfo2, all arenas); falls back to RSS.
+    /// Unlike RSS it drops when memory is freed, so before/after deltas are a structure's live footprint.
+    inline std::uint64_t heap_in_use() {
+#ifdef MEDIA_HANDLER_HAVE_MALLINFO2
+        const auto mi = mallinfo2();
+        return mi.uordblks + mi.hblkhd;
+#else
+        return current_rss();
+#endif
+    }
+
+    /// @brief Generated input files, created on first use and reused by every iteration and benchmark.
+    /// Returns an empty path (after logging why through the state) if the generator is unavailable.
+    template <class Generate>
+    fs::path cached_input(benchmark::State& state, const std::string& name, Generate generate) {
+        static std::mutex m;
+        static std::map<std::string, fs::path> made;
+        std::lock_guard lock(m);
+        if (auto it = made.find(name); it != made.end()) return it->second;
+
+        auto file = scratch_dir() / name;
+        if (auto r = generate(file); !r) {
+            state.SkipWithError(r.error().c_str());
+            return {};
+        }
+        return made[name] = file;
+    }
+
+} // namespace media_handler::bench
@@ -0,0 +1,232 @@
+#include "bench_common.h"
+#include "compressor/compression_engine.h"
+#include "utils/progress_tracker.h"
+#include "utils/retry_log.h"
+#include "utils/log_event.h"
+#include <spdlog/formatter.h>
+#include <chrono>
+#include <format>
+#include <fstream>
+#include <map>
+
+namespace media_handler::bench {
+
+    using namespace media_handler::utils;
+
+    /// @brief Extension lookup done once per scanned file.
+    static void BM_IsSupported(benchmark::State& state) {
+        compressor::CompressionEngine engine(Config{});
+        const std::vector<fs::path> paths = {
+            "/photos/2023/IMG_0001.JPG", "/photos/2023/IMG_0002.heic", "/videos/clip.MOV",
+            "/docs/readme.txt", "/photos/scan.png", "/videos/old.avi", "/misc/archive.zip", "/photos/raw.dng"
+        };
+        std::size_t i = 0;
+        for (auto _ : state) {
+            benchmark::DoNotOptimize(engine.is_supported(paths[i++ % paths.size()]));
+        }
+    }
+    BENCHMARK(BM_IsSupported);
+
+    /// @brief Paths in a scratch subdirectory (RetryLog keys on canonical paths, so the files exist).
+    static const std::vector<fs::path>& retry_paths(std::size_t n) {
+        static std::vector<fs::path> paths;
+        if (paths.size() >= n) return paths;
+        const auto dir = scratch_dir() / "retry_in";
+        fs::create_directories(dir);
+        for (std::size_t i = paths.size(); i < n; ++i) {
+            auto p = dir / std::format("IMG_{:07}.jpg", i);
+            std::ofstream(p) << 'x';
+            paths.push_back(std::move(p));
+        }
+        return paths;
+    }
+
+    static void BM_RetryLog_MarkCompleted(benchmark::State& state) {
+        const auto n = static_cast<std::size_t>(state.range(0));
+        const auto& paths = retry_paths(n);
+        RetryLog log(scratch_dir() / "retry_mark", null_logger());
+        std::size_t i = 0;
+        for (auto _ : state) {
+            log.mark_completed(paths[i++ % n]);
+        }
+    }
+    BENCHMARK(BM_RetryLog_MarkCompleted)->Arg(1000);
+
+    static void BM_RetryLog_IsCompleted(benchmark::State& state) {
+        const auto n = static_cast<std::size_t>(state.range(0));
+        const auto& paths = retry_paths(n);
+        RetryLog log(scratch_dir() / "retry_lookup", null_logger());
+        for (std::size_t i = 0; i < n; ++i) log.mark_completed(paths[i]);
+
+        std::size_t i = 0;
+        for (auto _ : state) {
+            benchmark::DoNotOptimize(log.is_completed(paths[i++ % n]));
+        }
+    }
+    BENCHMARK(BM_RetryLog_IsCompleted)->Arg(1000)->Arg(10000);
+
+    /// @brief Full state rewrite, as done after every file.
+    static void BM_RetryLog_Save(benchmark::State& state) {
+        const auto n = static_cast<std::size_t>(state.range(0));
+        const auto& paths = retry_paths(n);
+        const auto dir = scratch_dir() / std::format("retry_save_{}", n);
+        fs::create_directories(dir);
+        RetryLog log(dir, null_logger());
+        for (std::size_t i = 0; i < n; ++i) log.mark_completed(paths[i]);
+
+        for (auto _ : state) {
+            log.save();
+        }
+        state.SetItemsProcessed(static_cast<std::int64_t>(n * state.iterations()));
+    }
+    BENCHMARK(BM_RetryLog_Save)->Arg(1000)->Arg(10000)->Unit(benchmark::kMicrosecond);
+
+    /// @brief State file with n completed entries, written directly (building it through mark_completed
+    /// would cost a weakly_canonical() per entry). Keys match RetryLog's normalized form; files need not exist.
+    static const fs::path& scale_state_dir(std::size_t n) {
+        static std::map<std::size_t, fs::path> made;
+        if (auto it = made.find(n); it != made.end()) return it->second;
+
+        const auto dir = scratch_dir() / std::format("retry_scale_{}", n);
+        fs::create_directories(dir);
+        const auto root = utils::path_to_utf8(fs::weakly_canonical(scratch_dir())) + "/library";
+        std::ofstream f(dir / ".mediahandler_state", std::ios::binary);
+        f << "{\n  \"completed\": [";
+        for (std::size_t i = 0; i < n; ++i)
+            f << (i ? ",\n    \"" : "\n    \"") << std::format("{}/{:04}/IMG_{:08}.jpg", root, i % 1000, i) << '"';
+        f << "\n  ],\n  \"failed\": []\n}";
+        return made[n] = dir;
+    }
+
+    static std::vector<fs::path> scale_lookup_paths(std::size_t n, std::size_t count) {
+        std::vector<fs::path> paths;
+        const auto root = fs::weakly_canonical(scratch_dir()) / "library";
+        for (std::size_t k = 0; k < count; ++k) {
+            const auto i = (k * 7919) % n; // Spread over the set.
+            paths.push_back(root / std::format("{:04}", i % 1000) / std::format("IMG_{:08}.jpg", i));
+        }
+        return paths;
+    }
+
+    /// @brief Startup cost of a large state file: parse + insert. Reports the in-memory footprint.
+    static void BM_RetryLog_LoadScale(benchmark::State& state) {
+        const auto n = static_cast<std::size_t>(state.range(0));
+        const auto& dir = scale_state_dir(n);
+        double footprint = 0.0;
+        for (auto _ : state) {
+            const auto heap0 = heap_in_use();
+            RetryLog log(dir, null_logger());
+            log.load();
+            const auto heap1 = heap_in_use();
+            footprint = heap1 > heap0 ? static_cast<double>(heap1 - heap0) : 0.0;
+            if (log.completed_count() != n) state.SkipWithError("state file did not round-trip");
+        }
+        state.SetItemsProcessed(static_cast<std::int64_t>(n * state.iterations()));
+        state.counters["file_MB"] = static_cast<double>(fs::file_size(dir / ".mediahandler_state")) / 1'048'576.0;
+        state.counters["heap_MB"] = footprint / 1'048'576.0;
+    }
+
+    /// @brief One full rewrite at scale. migrate() saves after every file, so a run of N files costs ~N/2 of these.
+    static void BM_RetryLog_SaveScale(benchmark::State& state) {
+        const auto n = static_cast<std::size_t>(state.range(0));
+        const auto src = scale_state_dir(n);
+        const auto dir = scratch_dir() / std::format("retry_scale_save_{}", n);
+        fs::create_directories(dir);
+        fs::copy_file(src / ".mediahandler_state", dir / ".mediahandler_state", fs::copy_options::overwrite_existing);
+        RetryLog log(dir, null_logger());
+        log.load();
+
+        double seconds = 0.0;
+        for (auto _ : state) {
+            const auto t0 = std::chrono::steady_clock::now();
+            log.save();
+            seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        }
+        state.SetItemsProcessed(static_cast<std::int64_t>(n * state.iterations()));
+        // Estimated time spent saving state over a whole run that grows the log from 0 to n entries.
+        state.counters["run_total_h"] = seconds / state.iterations() * static_cast<double>(n) / 2.0 / 3600.0;
+    }
+
+    /// @brief Resume-time lookups against a large set (includes path normalization).
+    static void BM_RetryLog_IsCompletedScale(benchmark::State& state) {
+        const auto n = static_cast<std::size_t>(state.range(0));
+        RetryLog log(scale_state_dir(n), null_logger());
+        log.load();
+        const auto paths = scale_lookup_paths(n, 4096);
+
+        std::size_t i = 0;
+        benchmark::IterationCount hits = 0;
+        for (auto _ : state) {
+            hits += log.is_completed(paths[i++ % paths.size()]);
+        }
+        if (hits != state.iterations()) state.SkipWithError("lookup missed a completed entry");
+        state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()));
+    }
+
+    // 10M entries need several GB for the parsed JSON; filter them out on small machines.
+    BENCHMARK(BM_RetryLog_LoadScale)->Arg(100'000)->Arg(1'000'000)->Arg(10'000'000)->Iterations(1)->Unit(benchmark::kMillisecond);
+    BENCHMARK(BM_RetryLog_SaveScale)->Arg(100'000)->Arg(1'000'000)->Arg(10'000'000)->Iterations(1)->Unit(benchmark::kMillisecond);
+    BENCHMARK(BM_RetryLog_IsCompletedScale)->Arg(100'000)->Arg(1'000'000)->Arg(10'000'000);
+
+    /// @brief begin_file + finish_file per file, from 1..N workers sharing one tracker.
+    static void BM_Tracker_BeginFinish(benchmark::State& state) {
+        static std::unique_ptr<ProgressTracker> tracker;
+        static fs::path in, out;
+        if (state.thread_index() == 0) {
+            in = scratch_dir() / "tracker_in.jpg";
+            out = scratch_dir() / "tracker_out.jpg";
+            std::ofstream(in) << std::string(4096, 'x');
+            std::ofstream(out) << std::string(1024, 'x');
+            tracker = std::make_unique<ProgressTracker>(0, null_logger());
+        }
+
+        static std::uint64_t heap0;
+        if (state.thread_index() == 0) heap0 = heap_in_use();
+
+        for (auto _ : state) {
+            auto token = tracker->begin_file(in, MediaKind::Image);
+            tracker->finish_file(token, out, true);
+        }
+
+        // All threads have left the loop; the tracker now holds threads * iterations FileStats.
+        if (state.thread_index() == 0) {
+            const auto files = static_cast<double>(state.iterations()) * state.threads();
+            const auto heap1 = heap_in_use();
+            state.counters["bytes/file"] = heap1 > heap0 ? static_cast<double>(heap1 - heap0) / files : 0.0;
+            tracker.reset();
+        }
+    }
+    // Fixed iterations: the tracker keeps one FileStats per file (64 threads = 1.28M entries).
+    BENCHMARK(BM_Tracker_BeginFinish)->Iterations(20'000)->ThreadRange(1, 64)->UseRealTime();
+
+    static void BM_Tracker_Snapshot(benchmark::State& state) {
+        ProgressTracker tracker(0, null_logger());
+        for (auto _ : state) {
+            benchmark::DoNotOptimize(tracker.snapshot());
+        }
+    }
+    BENCHMARK(BM_Tracker_Snapshot);
+
+    /// @brief Per-file OK line from event to formatted sink bytes; range(0) = 1 for the JSON log, 0 for text.
+    static void BM_LogLine(benchmark::State& state) {
+        const bool json = state.range(0) != 0;
+        auto formatter = Logger::formatter(json);
+        const std::string path = "/photos/2023/05/IMG_20230501_101500.jpg";
+        spdlog::memory_buf_t out;
+        for (auto _ : state) {
+            LogEvent event("file_ok");
+            event.field("file", path).field("kind", "image").field("size_in", 4'194'304).field("size_out", 1'258'291).field("elapsed_ms", 120);
+            const auto payload = event.format("[{}/{}] OK {} | {:.1f}MB -> {:.1f}MB ({:.0f}% saved) | {:.1f}MB/s | {}ms",
+                17, 1000, "IMG_20230501_101500.jpg", 4.0, 1.2, 70.0, 33.3, 120);
+            spdlog::details::log_msg msg("bench", spdlog::level::debug, spdlog::string_view_t(payload.data(), payload.size()));
+            out.clear();
+            formatter->format(msg, out);
+            benchmark::DoNotOptimize(out.data());
+        }
+        state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations()) * static_cast<std::int64_t>(out.size()));
+    }
+    BENCHMARK(BM_LogLine)->ArgName("json")->Arg(0)->Arg(1);
+
+} // namespace media_handler::bench
+
+BENCHMARK_MAIN();
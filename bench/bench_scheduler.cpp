@@ -0,0 +1,104 @@
+#include "bench_common.h"
+#include "fake_processor.h"
+#include "compressor/compression_engine.h"
+#include <algorithm>
+#include <chrono>
+#include <format>
+
+// Scheduling simulation: CompressionEngine::migrate with FakeProcessors, so the numbers are the engine's own
+// queue, tracker and bookkeeping cost rather than codec time. No file is opened; paths need not exist.
+
+namespace media_handler::bench {
+
+    using namespace std::chrono;
+    using tests::Distribution;
+    using tests::FakeProcessor;
+    using tests::FakeProfile;
+
+    namespace {
+        const std::vector<fs::path>& fake_files(std::size_t n) {
+            static std::map<std::size_t, std::vector<fs::path>> made;
+            auto& files = made[n];
+            if (files.empty()) {
+                files.reserve(n);
+                const auto root = scratch_dir() / "sim_in";
+                for (std::size_t i = 0; i < n; ++i)
+                    files.push_back(root / std::format("d{}", i % 256) / std::format("IMG_{:07}.jpg", i));
+            }
+            return files;
+        }
+
+        /// @brief Value at quantile q (0..1) of v; reorders v.
+        double quantile(std::vector<double>& v, double q) {
+            if (v.empty()) return 0.0;
+            auto k = static_cast<std::size_t>(q * (v.size() - 1));
+            std::nth_element(v.begin(), v.begin() + static_cast<std::ptrdiff_t>(k), v.end());
+            return v[k];
+        }
+    }
+
+    /// @brief range(0) fake files through range(1) workers; each call sleeps a log-normal time around
+    /// range(2) microseconds and holds ~256 KB. Reports makespan, per-file dispatch gap (time a worker
+    /// spends in the engine between two processor calls), processor-time tail and pool efficiency.
+    static void BM_SchedulerSimulation(benchmark::State& state) {
+        const auto n = static_cast<std::size_t>(state.range(0));
+        const auto threads = static_cast<unsigned>(state.range(1));
+        const auto median_us = static_cast<double>(state.range(2));
+        const auto& files = fake_files(n);
+
+        utils::Config cfg;
+        cfg.threads = threads;
+        cfg.input_dir = utils::path_to_utf8(scratch_dir() / "sim_in");
+        cfg.output_dir = utils::path_to_utf8(scratch_dir() / "sim_out");
+        cfg.heartbeat_interval = 0;
+        cfg.log_level = spdlog::level::warn;
+
+        auto fake = std::make_shared<FakeProcessor>(FakeProfile{
+            median_us > 0 ? Distribution::lognormal(median_us, 0.75) : Distribution::fixed(0),
+            Distribution::lognormal(256, 0.5) });
+        compressor::CompressionEngine engine(cfg, { fake, fake });
+
+        std::vector<double> gaps_us, busy_us;
+        double makespan = 0.0;
+        for (auto _ : state) {
+            fake->trace(n);
+            const auto t0 = steady_clock::now();
+            auto snap = engine.migrate(files, { .ignore_state = true });
+            makespan = duration<double>(steady_clock::now() - t0).count();
+            benchmark::DoNotOptimize(snap);
+
+            auto calls = fake->trace_result();
+            std::sort(calls.begin(), calls.end(), [](const auto& a, const auto& b) {
+                return a.thread != b.thread ? a.thread < b.thread : a.start < b.start;
+                });
+            gaps_us.clear();
+            busy_us.clear();
+            for (std::size_t i = 0; i < calls.size(); ++i) {
+                busy_us.push_back(duration<double, std::micro>(calls[i].end - calls[i].start).count());
+                if (i > 0 && calls[i].thread == calls[i - 1].thread)
+                    gaps_us.push_back(duration<double, std::micro>(calls[i].start - calls[i - 1].end).count());
+            }
+        }
+
+        double busy_total = 0.0;
+        for (double b : busy_us) busy_total += b;
+        state.counters["makespan_s"] = makespan;
+        state.counters["files/s"] = benchmark::Counter(static_cast<double>(n) * state.iterations(), benchmark::Counter::kIsRate);
+        state.counters["gap_p50_us"] = quantile(gaps_us, 0.50);
+        state.counters["gap_p99_us"] = quantile(gaps_us, 0.99);
+        state.counters["gap_max_us"] = quantile(gaps_us, 1.0);
+        state.counters["proc_p99_us"] = quantile(busy_us, 0.99);
+        state.counters["proc_max_us"] = quantile(busy_us, 1.0);
+        state.counters["efficiency"] = makespan > 0.0 ? busy_total / 1e6 / (makespan * threads) : 0.0;
+    }
+    BENCHMARK(BM_SchedulerSimulation)
+        ->Apply([](benchmark::internal::Benchmark* b) {
+            b->ArgNames({ "files", "threads", "median_us" });
+            for (int t : { 1, 4, 16, 64 }) b->Args({ 1'000'000, t, 0 }); // Pure engine overhead.
+            for (int t : { 16, 64 }) b->Args({ 1'000'000, t, 200 }); // Short jobs: queue and tracker contention.
+            })
+        ->Iterations(1)
+        ->UseRealTime()
+        ->Unit(benchmark::kMillisecond);
+
+} // namespace media_handler::bench
@@ -0,0 +1,58 @@
+#pragma once
+#include "utils/config.h"
+#include <cstdint>
+#include <expected>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <spdlog/spdlog.h>
+
+namespace media_handler::compressor {
+
+    /// @brief Page-cache state of the inputs at the start of each run.
+    enum class BenchCache {
+        Warm, // Inputs read once before each run.
+        Cold, // posix_fadvise(DONTNEED) on every input; directory metadata stays cached.
+        Drop  // sync + /proc/sys/vm/drop_caches (root only); falls back to Cold.
+    };
+
+    std::optional<BenchCache> parse_bench_cache(std::string_view name);
+
+    struct BenchOptions {
+        unsigned runs = 3;
+        BenchCache cache = BenchCache::Warm;
+    };
+
+    /// @brief One timed scan + migrate.
+    struct BenchRun {
+        double seconds = 0.0;
+        std::size_t files = 0; // Completed + failed.
+        std::uintmax_t bytes_in = 0;
+        std::uintmax_t bytes_out = 0;
+        std::uint64_t peak_rss = 0; // Bytes; per run where the OS allows resetting the high-water mark.
+    };
+
+    struct BenchStat {
+        double mean = 0.0;
+        double stddev = 0.0; // Sample standard deviation; 0 for a single run.
+    };
+
+    struct BenchSummary {
+        std::size_t runs = 0;
+        BenchStat files_per_sec;
+        BenchStat mb_per_sec; // Input MB (2^20 bytes) per second.
+        BenchStat ratio; // bytes_out / bytes_in.
+        BenchStat peak_rss_mb;
+    };
+
+    /// @brief Mean and standard deviation of each metric over the runs.
+    BenchSummary summarize(const std::vector<BenchRun>& runs);
+
+    /// @brief Scan cfg.input_dir and migrate into a scratch directory under cfg.output_dir, opts.runs times.
+    /// State is neither loaded nor saved, and the scratch output is removed before every run and at the end.
+    std::expected<BenchSummary, std::string> run_bench(const utils::Config& cfg, const BenchOptions& opts,
+        std::shared_ptr<spdlog::logger> logger);
+
+} // namespace media_handler::compressor
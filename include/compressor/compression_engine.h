@@ -1,6 +1,8 @@
 #pragma once
 #include "utils/config.h"
 #include "utils/utils.h"
+#include "utils/progress_tracker.h"
+#include "compressor/media_processor.h"
 #include <filesystem>
 #include <vector>
 #include <array>
@@ -14,21 +16,34 @@ namespace media_handler::compressor {
     struct MigrateOptions {
         bool retry = false;
         bool organize = false;
+        bool ignore_state = false; // Neither read nor write .mediahandler_state (benchmark runs).
+    };
+
+    /// @brief Processors the engine dispatches to. Null members get the real implementations
+    /// (ImageProcessor / VideoProcessor); tests and simulations inject fakes.
+    struct Processors {
+        std::shared_ptr<MediaProcessor> image; // Images and raw-copied audio.
+        std::shared_ptr<MediaProcessor> video;
     };
 
     class CompressionEngine {
     public:
-        explicit CompressionEngine(const utils::Config& cfg); // No implicit conversions
+        explicit CompressionEngine(const utils::Config& cfg, Processors processors = {}); // No implicit conversions
 
         /// @brief Scan directory for supported media files
         std::vector<std::filesystem::path> scan_media_files(const std::filesystem::path& input_dir) const;
 
+        /// @brief Determines whether the given filesystem path is supported by this object.
+        bool is_supported(const std::filesystem::path& p) const;
+
         /// @brief Migrate media files using a pool of worker threads
-        void migrate(const std::vector<std::filesystem::path>& files, const MigrateOptions& opts = {});
+        /// @return Final tracker counters; empty when nothing was processed (organize mode, nothing to do).
+        utils::ProgressTracker::Snapshot migrate(const std::vector<std::filesystem::path>& files, const MigrateOptions& opts = {});
 
     private:
         utils::Config config;
         std::shared_ptr<spdlog::logger> logger;
+        Processors processors;
 
         // Supported types
 
@@ -39,8 +54,12 @@ namespace media_handler::compressor {
         // Will be copied raw: 
         static constexpr std::array<const char*, 4> other_exts = { ".mp3", ".aac", ".wav", ".flac" };
 
-        /// @brief Determines whether the given filesystem path is supported by this object.
-        bool is_supported(const std::filesystem::path& p) const;
+        /// @brief Media kind for a lowercase extension (used to split per-kind metrics).
+        static utils::MediaKind kind_of(std::string_view ext) {
+            if (ext_matches(video_exts, ext)) return utils::MediaKind::Video;
+            if (ext_matches(image_exts, ext)) return utils::MediaKind::Image;
+            return utils::MediaKind::Other;
+        }
 
         /// @brief Scan over extensions array
         static bool ext_matches(const auto& arr, std::string_view ext) {
@@ -0,0 +1,28 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace media_handler::compressor {
+
+    constexpr std::size_t DCT_BLOCK = 64; // Coefficients per 8x8 block.
+
+    /// @brief Per-coefficient factor that moves a block from one quantization table to another:
+    /// new = round(old * source_step / target_step).
+    struct RequantTable {
+        alignas(16) float scale[DCT_BLOCK];
+    };
+
+    /// @brief Build the factors for two quantization tables given in the same (natural) order.
+    RequantTable make_requant_table(const std::uint16_t* source_steps, const std::uint16_t* target_steps);
+
+    /// @brief Requantize `blocks` consecutive 8x8 blocks of coefficients in place, with the widest
+    /// kernel this build supports. Results match requantize_blocks_scalar() exactly.
+    void requantize_blocks(std::int16_t* coefficients, std::size_t blocks, const RequantTable& table);
+
+    /// @brief Portable reference kernel.
+    void requantize_blocks_scalar(std::int16_t* coefficients, std::size_t blocks, const RequantTable& table);
+
+    /// @brief Name of the kernel requantize_blocks() uses: "sse2", "neon" or "scalar".
+    const char* requantize_kernel();
+
+} // namespace media_handler::compressor
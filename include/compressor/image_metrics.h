@@ -0,0 +1,45 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace media_handler::compressor {
+
+    /// @brief An 8-bit luma plane; row y starts at pixels + y * stride.
+    struct LumaView {
+        const std::uint8_t* pixels = nullptr;
+        std::size_t stride = 0;
+        unsigned width = 0;
+        unsigned height = 0;
+    };
+
+    /// @brief Implementations of the metric inner loops: luma is bit-exact on all of them, SSIM equal to float rounding.
+    enum class SsimKernel { Scalar, Sse41, Avx2, Neon };
+
+    const char* to_string(SsimKernel kernel);
+
+    /// @brief Whether this build and CPU can run `kernel`.
+    bool ssim_kernel_supported(SsimKernel kernel);
+
+    /// @brief The widest kernel the CPU supports, detected once per process.
+    SsimKernel best_ssim_kernel();
+
+    /// @brief Luma of interleaved 8-bit pixels with the JFIF (BT.601 full-range) weights libjpeg encodes with.
+    /// `components` is 1 (copied) or 3 (RGB); anything else (CMYK) has no luma and leaves `out` empty.
+    void luma_plane(const std::uint8_t* pixels, std::size_t stride, unsigned width, unsigned height, int components,
+        std::vector<std::uint8_t>& out);
+
+    /// @brief luma_plane() on a given kernel, falling back to scalar where it is unsupported.
+    void luma_plane(const std::uint8_t* pixels, std::size_t stride, unsigned width, unsigned height, int components,
+        std::vector<std::uint8_t>& out, SsimKernel kernel);
+
+    /// @brief Mean SSIM of two equally sized luma planes over 8x8 windows stepped 4 pixels apart
+    /// (x264's layout: each window is the sum of four 4x4 blocks, so every block is summed once).
+    /// 1 for identical planes, 0 for mismatched sizes; a plane smaller than two blocks either way is one window.
+    /// Runs on best_ssim_kernel().
+    double ssim(const LumaView& a, const LumaView& b);
+
+    /// @brief ssim() on a given kernel, falling back to scalar where it is unsupported; for tests and benchmarks.
+    double ssim(const LumaView& a, const LumaView& b, SsimKernel kernel);
+
+} // namespace media_handler::compressor
@@ -2,6 +2,7 @@
 #include "utils/config.h"
 #include "utils/process_result.h"
 #include "compressor/compression_engine.h"
+#include "compressor/media_processor.h"
 #include <png.h>
 #include <cstdio>
 #include <vector>
@@ -15,18 +16,20 @@ namespace media_handler::compressor {
 	constexpr int PHOTO_TRIM_WIDTH = 1920; 
 	constexpr int PHOTO_TRIM_HEIGHT = 1080;
 
-	class ImageProcessor {
+	class ImageProcessor final : public MediaProcessor {
 	public:
 		ImageProcessor(const utils::Config& cfg, std::shared_ptr<spdlog::logger> logger);
 		
 		/// @brief Compress an image file (jpg, png, heic)
-		ProcessResult compress(const std::filesystem::path& input, const std::filesystem::path& output);
+		ProcessResult compress(const std::filesystem::path& input, const std::filesystem::path& output) override;
 
 	private:
 		utils::Config config;
 		std::shared_ptr<spdlog::logger> logger;
 
 		/// @brief Compresses an image and writes it as a JPEG file to the specified output path.
+		/// Photos larger than PHOTO_TRIM_WIDTH x PHOTO_TRIM_HEIGHT are decoded at a reduced DCT scale and
+		/// area-resampled down to fit.
 		ProcessResult compress_jpeg(const std::filesystem::path& input, const std::filesystem::path& output);
 
 		/// @brief Compresses a PNG file from the specified input path and writes the compressed result to the specified output path.
@@ -0,0 +1,45 @@
+#pragma once
+#include "utils/config.h"
+#include <cstddef>
+#include <cstdio>
+#include <expected>
+#include <functional>
+#include <string>
+#include <vector>
+#include <jpeglib.h>
+
+namespace media_handler::compressor {
+
+    /// @brief Interleaved pixels to encode; row y starts at pixels + y * stride.
+    struct StripImage {
+        const JSAMPLE* pixels = nullptr;
+        std::size_t stride = 0;
+        JDIMENSION width = 0;
+        JDIMENSION height = 0;
+        int components = 3;
+        J_COLOR_SPACE color_space = JCS_RGB;
+    };
+
+    /// @brief Writes APP segments (EXIF, XMP) into the output, after jpeg_start_compress().
+    using JpegMarkerWriter = std::function<void(j_compress_ptr)>;
+
+    /// @brief Encode `image` as one JPEG at `quality` and `profile` in a single scanline pass on the calling thread;
+    /// unlike the strip encoder, every profile is honoured. `markers` may be empty.
+    /// @param out Receives the file; it is grown as needed and may be left larger than the result.
+    /// @return Bytes of `out` holding the JPEG, or the libjpeg error.
+    std::expected<std::size_t, std::string> encode_jpeg_image(const StripImage& image, int quality, utils::JpegProfile profile,
+        const JpegMarkerWriter& markers, std::vector<JOCTET>& out);
+
+    /// @brief Encode `image` as one baseline JPEG at `quality` and `profile`, split into horizontal strips of
+    /// whole MCU rows that are encoded concurrently, `threads` at most (the first on the calling thread).
+    /// Every strip restarts its entropy coder at each MCU row (DRI), so the strips' entropy-coded segments
+    /// can be joined with renumbered RSTn markers. Huffman tables are the standard ones, shared by all strips,
+    /// which rules out optimized tables and progressive scans: MaxCompression is encoded as Balanced.
+    /// Pixels decode exactly as from a single-threaded encode with the same settings.
+    /// CPU time of the helper threads is charged to the current file (WorkContext::attributed_cpu).
+    /// @param out Receives the file; it is grown as needed and may be left larger than the result.
+    /// @return Bytes of `out` holding the JPEG, or the libjpeg error.
+    std::expected<std::size_t, std::string> encode_jpeg_strips(const StripImage& image, int quality, utils::JpegProfile profile,
+        unsigned threads, const JpegMarkerWriter& markers, std::vector<JOCTET>& out);
+
+} // namespace media_handler::compressor
@@ -0,0 +1,126 @@
+#pragma once
+#include "utils/config.h"
+#include <algorithm>
+#include <csetjmp>
+#include <cstdio>
+#include <new>
+#include <vector>
+#include <jpeglib.h>
+#include <jerror.h>
+
+namespace media_handler::compressor {
+
+    /// @brief libjpeg error manager that longjmps back to the caller instead of calling exit().
+    struct JpegErrorHandler {
+        struct jpeg_error_mgr pub; // must be first member
+        jmp_buf setjmp_buffer;
+        char message[JMSG_LENGTH_MAX];
+    };
+
+    inline void jpeg_error_exit_safe(j_common_ptr cinfo) {
+        auto* err = reinterpret_cast<JpegErrorHandler*>(cinfo->err);
+        (*cinfo->err->format_message)(cinfo, err->message);
+        longjmp(err->setjmp_buffer, 1);
+    }
+
+    // Suppresses libjpeg trace spam that would otherwise go to stderr
+    inline void jpeg_emit_message_safe(j_common_ptr /*cinfo*/, int /*msg_level*/) {
+        // Intentionally suppressed. Fatal errors are handled by jpeg_error_exit_safe.
+    }
+
+    /// @brief libjpeg destination that encodes into a std::vector, doubling it when full. Unlike
+    /// jpeg_mem_dest it never swaps in a buffer of its own, so the vector stays reusable even after an error.
+    struct VectorDestination {
+        jpeg_destination_mgr pub; // must be first member
+        std::vector<JOCTET>* out = nullptr;
+        std::size_t written = 0;
+
+        VectorDestination(j_compress_ptr cinfo, std::vector<JOCTET>& buffer) : out(&buffer) {
+            pub.init_destination = init;
+            pub.empty_output_buffer = grow;
+            pub.term_destination = term;
+            cinfo->dest = &pub;
+        }
+
+    private:
+        static VectorDestination& self(j_compress_ptr cinfo) { return *reinterpret_cast<VectorDestination*>(cinfo->dest); }
+
+        static void init(j_compress_ptr cinfo) {
+            auto& d = self(cinfo);
+            d.out->resize(std::max<std::size_t>(d.out->capacity(), 1 << 16));
+            d.pub.next_output_byte = d.out->data();
+            d.pub.free_in_buffer = d.out->size();
+        }
+
+        static boolean grow(j_compress_ptr cinfo) {
+            auto& d = self(cinfo);
+            const auto used = d.out->size();
+            bool out_of_memory = false;
+            try {
+                d.out->resize(used * 2);
+            }
+            catch (const std::bad_alloc&) {
+                out_of_memory = true; // longjmp from inside the handler would skip ending the exception.
+            }
+            if (out_of_memory) ERREXIT1(cinfo, JERR_OUT_OF_MEMORY, 0); // Exceptions must not unwind through libjpeg.
+            d.pub.next_output_byte = d.out->data() + used;
+            d.pub.free_in_buffer = d.out->size() - used;
+            return TRUE;
+        }
+
+        static void term(j_compress_ptr cinfo) {
+            auto& d = self(cinfo);
+            d.written = d.out->size() - d.pub.free_in_buffer;
+        }
+    };
+
+    /// @brief Offset just past the SOS segment, where entropy-coded data begins (0 if the headers are
+    /// malformed). `sof` receives the offset of the SOF segment's 16-bit height field.
+    inline std::size_t scan_data_offset(const JOCTET* p, std::size_t n, std::size_t& sof) {
+        std::size_t pos = 2; // SOI
+        while (pos + 4 <= n && p[pos] == 0xFF) {
+            const int marker = p[pos + 1];
+            const std::size_t length = (static_cast<std::size_t>(p[pos + 2]) << 8) | p[pos + 3];
+            if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC)
+                sof = pos + 5; // FF Cn, Lf, P, then Y.
+            pos += 2 + length;
+            if (marker == 0xDA) return pos <= n ? pos : 0;
+        }
+        return 0;
+    }
+
+    /// @brief Encoder parameters for `profile`, in place of jpeg_set_defaults(): call once the image size,
+    /// components and colour space are set, and before jpeg_set_quality().
+    inline void apply_jpeg_profile(j_compress_ptr cinfo, utils::JpegProfile profile) {
+#ifdef JPEG_C_PARAM_SUPPORTED
+        // mozjpeg's own defaults already aim for maximum compression; the profile has to be chosen first.
+        jpeg_c_set_int_param(cinfo, JINT_COMPRESS_PROFILE,
+            profile == utils::JpegProfile::MaxCompression ? JCP_MAX_COMPRESSION : JCP_FASTEST);
+#endif
+        jpeg_set_defaults(cinfo);
+        switch (profile) {
+        case utils::JpegProfile::Fast:
+            cinfo->dct_method = JDCT_IFAST;
+            break;
+        case utils::JpegProfile::MaxCompression:
+            cinfo->optimize_coding = TRUE;
+            jpeg_simple_progression(cinfo);
+#ifdef JPEG_C_PARAM_SUPPORTED
+            if (jpeg_c_bool_param_supported(cinfo, JBOOLEAN_TRELLIS_QUANT))
+                jpeg_c_set_bool_param(cinfo, JBOOLEAN_TRELLIS_QUANT, TRUE);
+#endif
+            break;
+        case utils::JpegProfile::Balanced:
+            break;
+        }
+    }
+
+    /// @brief Decoder parameters for `profile`; call after jpeg_read_header().
+    inline void apply_jpeg_profile(j_decompress_ptr cinfo, utils::JpegProfile profile) {
+        if (profile == utils::JpegProfile::Fast) {
+            cinfo->dct_method = JDCT_IFAST;
+            cinfo->do_fancy_upsampling = FALSE; // Replicate chroma instead of interpolating it.
+        }
+    }
+
+} // namespace media_handler::compressor
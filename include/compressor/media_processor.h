@@ -0,0 +1,17 @@
+#pragma once
+#include "utils/process_result.h"
+#include <filesystem>
+
+namespace media_handler::compressor {
+
+    /// @brief Per-kind compressor the engine dispatches to.
+    /// One instance is shared by all workers, so compress() must be safe to call concurrently.
+    class MediaProcessor {
+    public:
+        virtual ~MediaProcessor() = default;
+
+        /// @brief Compress input into output.
+        virtual utils::ProcessResult compress(const std::filesystem::path& input, const std::filesystem::path& output) = 0;
+    };
+
+} // namespace media_handler::compressor
@@ -0,0 +1,58 @@
+#pragma once
+#include "compressor/image_metrics.h"
+#include "compressor/jpeg_strip_encoder.h"
+#include "utils/config.h"
+#include <cstdint>
+#include <expected>
+#include <string>
+#include <vector>
+
+namespace media_handler::compressor {
+
+    /// @brief Qualities a search may pick from: below 20 blocking dominates, above 95 files balloon for nothing.
+    constexpr int SEARCH_QUALITY_MIN = 20;
+    constexpr int SEARCH_QUALITY_MAX = 95;
+
+    /// @brief Side of the full-resolution tiles a probe is assembled from; a multiple of the 16-pixel MCU.
+    constexpr unsigned PROBE_TILE = 32;
+
+    /// @brief Probe size: 64 tiles. Images up to twice this are searched whole.
+    constexpr std::uint64_t PROBE_PIXELS = 64 * PROBE_TILE * PROBE_TILE;
+
+    /// @brief What to pick the JPEG quality for; at most one member is set, 0 = unset.
+    struct QualityTarget {
+        double ssim = 0.0; // Lowest quality whose luma SSIM reaches this.
+        double bpp = 0.0; // Highest quality whose output stays within this many bits per pixel.
+
+        bool enabled() const { return ssim > 0.0 || bpp > 0.0; }
+
+        static QualityTarget from(const utils::Config& config) { return { config.jpeg_target_ssim, config.jpeg_target_bpp }; }
+    };
+
+    /// @brief The quality a search settled on and what the probe measured there.
+    struct QualitySearch {
+        int quality = 0;
+        double ssim = 0.0; // Probe luma SSIM at `quality` (SSIM targets only).
+        double bpp = 0.0; // Probe bits per pixel at `quality` (luma only for SSIM targets).
+        int probes = 0; // Probe encodes run.
+        bool reached = true; // False when even the end of the quality range misses the target.
+    };
+
+    /// @brief Binary-search the JPEG quality for `image` that meets `target`, on a probe of at most PROBE_PIXELS,
+    /// so the whole search costs a fraction of one full-size encode. The probe is a mosaic of PROBE_TILE tiles
+    /// cut at full resolution from a grid spread over the image: unlike a downsampled copy, it keeps the
+    /// noise and fine detail that decide both the SSIM and the bit rate at a given quality.
+    /// SSIM targets encode the probe's luma as grayscale (the same luma table a colour encode uses) and
+    /// score its decode; bpp targets encode the probe in colour with `profile` and count entropy-coded bytes.
+    /// @return The chosen quality, or an error for an empty image or no target, an SSIM target on CMYK (no luma),
+    /// or a libjpeg failure.
+    std::expected<QualitySearch, std::string> search_jpeg_quality(const StripImage& image, const QualityTarget& target,
+        utils::JpegProfile profile);
+
+    /// @brief Luma SSIM of an encoded JPEG against the `source` luma it was encoded from. Only the Y channel is
+    /// decoded, into `scratch`, which skips the chroma IDCTs and colour conversion of a full decode.
+    /// @return The score, or an error for a JPEG that fails to decode, has no luma (CMYK) or differs in size.
+    std::expected<double, std::string> encoded_luma_ssim(const LumaView& source, const JOCTET* jpeg, std::size_t size,
+        std::vector<JSAMPLE>& scratch);
+
+} // namespace media_handler::compressor
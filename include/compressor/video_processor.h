@@ -1,6 +1,7 @@
 #pragma once
 #include "utils/utils.h"
 #include "utils/process_result.h"
+#include "compressor/media_processor.h"
 #include <filesystem>
 #include <memory>
 #include <spdlog/spdlog.h>
@@ -16,12 +17,12 @@ using namespace media_handler::utils;
 
 namespace media_handler::compressor {
 
-    class VideoProcessor {
+    class VideoProcessor final : public MediaProcessor {
     public:
         VideoProcessor(const utils::Config& cfg, std::shared_ptr<spdlog::logger> logger);
 
         /// @brief Compress a video file
-        ProcessResult compress(const std::filesystem::path& input, const std::filesystem::path& output);
+        ProcessResult compress(const std::filesystem::path& input, const std::filesystem::path& output) override;
 
     private:
         const utils::Config config;
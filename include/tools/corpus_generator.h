@@ -0,0 +1,53 @@
+#pragma once
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace media_handler::tools {
+
+    /// @brief What to generate. The same spec and seed always produce byte-identical files.
+    struct CorpusSpec {
+        std::filesystem::path root;
+        std::uint32_t seed = 1;
+
+        std::size_t jpeg = 40;
+        std::size_t png = 8;
+        std::size_t heic = 8;
+        std::size_t video = 4;
+        std::size_t corrupt = 3; // Valid header, damaged body.
+        std::size_t truncated = 3; // Valid file cut short.
+
+        std::vector<std::pair<int, int>> resolutions = { { 1280, 720 }, { 1920, 1080 }, { 4032, 3024 } };
+        std::vector<std::pair<int, int>> video_resolutions = { { 640, 360 }, { 1280, 720 } };
+        std::vector<double> video_seconds = { 1.0, 3.0 };
+        std::vector<std::string> video_codecs = { "libx264" };
+        int video_fps = 30;
+        int jpeg_quality = 92;
+
+        int depth = 2; // Maximum subdirectory nesting below root.
+        int fanout = 3; // Subdirectories per level.
+        int year_from = 2015; // EXIF / creation dates are drawn from [year_from, year_to].
+        int year_to = 2024;
+    };
+
+    /// @brief One generated file, as listed in the manifest.
+    struct CorpusFile {
+        std::filesystem::path path; // Relative to the corpus root.
+        std::string kind; // "jpeg" / "png" / "heic" / "video"
+        std::string defect; // "" / "corrupt" / "truncated"
+        std::string date; // "YYYY:MM:DD HH:MM:SS" embedded in EXIF / creation_time
+        std::uintmax_t size = 0;
+    };
+
+    /// @brief Parse "WIDTHxHEIGHT" (e.g. "1920x1080").
+    std::optional<std::pair<int, int>> parse_resolution(const std::string& text);
+
+    /// @brief Generate the corpus under spec.root and write manifest.ndjson next to it.
+    /// Fails on the first file an encoder cannot produce (e.g. no HEVC encoder in libheif).
+    std::expected<std::vector<CorpusFile>, std::string> generate_corpus(const CorpusSpec& spec);
+
+} // namespace media_handler::tools
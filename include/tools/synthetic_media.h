@@ -0,0 +1,35 @@
+#pragma once
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace media_handler::tools {
+
+    /// @brief Deterministic photo-like RGB24 content: smooth gradients, edges and seeded noise,
+    /// so encoders see realistic entropy rather than flat colour.
+    std::vector<std::uint8_t> synthetic_rgb(int width, int height, std::uint32_t seed, int frame = 0);
+
+    /// @brief EXIF APP1 payload ("Exif\0\0" + TIFF) with DateTime and DateTimeOriginal set.
+    /// @param date "YYYY:MM:DD HH:MM:SS"
+    std::vector<std::uint8_t> make_exif(const std::string& date);
+
+    /// @brief Write a baseline JPEG of synthetic content, with an EXIF date if one is given.
+    std::expected<void, std::string> write_jpeg(const std::filesystem::path& file, int width, int height,
+        int quality, std::uint32_t seed, const std::string& exif_date = {});
+
+    /// @brief Write an 8-bit RGB PNG of synthetic content.
+    std::expected<void, std::string> write_png(const std::filesystem::path& file, int width, int height, std::uint32_t seed);
+
+    /// @brief Write a HEIC of synthetic content (needs a libheif HEVC encoder), with an EXIF date if one is given.
+    std::expected<void, std::string> write_heic(const std::filesystem::path& file, int width, int height,
+        int quality, std::uint32_t seed, const std::string& exif_date = {});
+
+    /// @brief Write a video-only clip of moving synthetic content. The container is chosen from the
+    /// extension; codec is an FFmpeg encoder name (e.g. "libx264", "mpeg4").
+    /// @param creation_time ISO 8601 container creation_time tag; empty = none.
+    std::expected<void, std::string> write_video(const std::filesystem::path& file, int width, int height,
+        int frames, int fps, const std::string& codec, std::uint32_t seed, const std::string& creation_time = {});
+
+} // namespace media_handler::tools
@@ -13,6 +13,8 @@ namespace media_handler::utils {
         Config cfg; // Final config after overwrites
         bool retry_failed = false;
         bool organize_by_date = false;
+        unsigned bench_runs = 0; // --bench N: timed runs into a scratch output; 0 = normal migration.
+        std::string bench_cache = "warm"; // warm / cold / drop
         bool show_help = false;
     };
 
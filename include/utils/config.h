@@ -3,12 +3,36 @@
 #include <filesystem>
 #include <expected>
 #include <memory>
+#include <cstdint>
+#include <optional>
+#include <string_view>
 #include <spdlog/spdlog.h>
 
 #define CONFIG_FILE "config.json"
 
 namespace media_handler::utils {
 
+    /// @brief How JPEG sources are compressed.
+    enum class JpegMode : std::uint8_t {
+        Reencode, // Decode to pixels and encode at PHOTO_QUALITY.
+        Lossless, // Keep the DCT coefficients; redo only the entropy coding (optimized Huffman, progressive).
+        Requantize, // Rescale the DCT coefficients onto the PHOTO_QUALITY tables without decoding to pixels.
+        Auto, // Lossless when the source is already quantized at least as coarsely as PHOTO_QUALITY, else Requantize.
+    };
+
+    /// @brief "reencode", "lossless", "requantize" or "auto".
+    std::optional<JpegMode> parse_jpeg_mode(std::string_view name);
+
+    /// @brief Speed/size trade-off of every JPEG the processors decode and encode.
+    enum class JpegProfile : std::uint8_t {
+        Fast, // IFAST DCT both ways, no fancy chroma upsampling.
+        Balanced, // libjpeg defaults: ISLOW DCT, fancy upsampling, standard Huffman tables.
+        MaxCompression, // Balanced plus optimized Huffman tables, progressive scans and trellis quantization if the library has it.
+    };
+
+    /// @brief "fast", "balanced" or "max-compression".
+    std::optional<JpegProfile> parse_jpeg_profile(std::string_view name);
+
 	/// @brief App configuration with default values
 	struct Config {
         // Video
@@ -22,6 +46,15 @@ namespace media_handler::utils {
         std::string audio_codec = "aac";
         std::string audio_bitrate = "192k";
 
+        // Image
+        std::string jpeg_mode = "reencode"; // reencode, lossless, requantize or auto (coefficient modes never resize)
+        std::string jpeg_profile = "balanced"; // fast, balanced or max-compression
+        double jpeg_min_savings = 0.0; // Copy a JPEG unchanged when its predicted saving is below this fraction; 0 = always compress (off)
+        double jpeg_target_ssim = 0.0; // Pick each re-encoded JPEG's quality to reach this luma SSIM; 0 = fixed quality
+        double jpeg_target_bpp = 0.0; // Or to stay within this many bits per pixel; 0 = fixed quality. At most one target is set
+        double jpeg_verify_ssim = 0.0; // Decode each re-encoded JPEG and retry or copy the source when its luma SSIM is below this; 0 = off
+        uint32_t jpeg_parallel_pixels = 16'000'000; // Encode JPEGs of at least this many pixels in strips, parallel on reserved idle workers; 0 = only when workers are idle
+
         // General
         std::string container = "mp4";
         std::string input_dir = "input";
@@ -29,6 +62,14 @@ namespace media_handler::utils {
         uint32_t threads = 4;
         bool json_log = false;
         spdlog::level::level_enum log_level = spdlog::level::info;
+        std::string metrics_file = ""; // Prometheus textfile output; empty = disabled
+        uint32_t metrics_interval = 15; // Seconds between metrics file rewrites
+        uint32_t heartbeat_interval = 30; // Seconds between progress lines; 0 = disabled
+        bool perf_counters = false; // Per-file/per-stage hardware counters via perf_event_open
+        std::string report_file = ""; // Per-file run report (.csv = CSV, otherwise NDJSON); empty = disabled
+        std::string event_log = ""; // Binary per-file event log (decode with media_handler_events); empty = disabled
+        std::string log_overflow = "block"; // Full log queue: block, drop-oldest or drop-new
+        std::string control_socket = ""; // Unix-domain socket for live status / pause / worker count; empty = disabled
 
         /// @brief Load configuration from JSON file
         static std::expected<Config, std::string> load(const std::filesystem::path& path, const std::shared_ptr<spdlog::logger>& logger);
@@ -0,0 +1,47 @@
+#pragma once
+#include <expected>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <spdlog/spdlog.h>
+
+namespace media_handler::utils {
+
+    /// @brief Line-based command server on a Unix-domain socket. A client sends one command line and gets one
+    /// response line back, then the connection is closed. Commands run one at a time on the server thread.
+    class ControlServer {
+    public:
+        /// @brief Turns a command (without the newline) into a response (without the newline).
+        using Handler = std::function<std::string(std::string_view command)>;
+
+        /// @brief Bind `path` (mode 0600) and start serving. A stale socket file from a crashed run is replaced;
+        /// a socket another process is still serving is an error.
+        static std::expected<std::unique_ptr<ControlServer>, std::string> start(const std::filesystem::path& path,
+            Handler handler, std::shared_ptr<spdlog::logger> logger);
+
+        /// @brief Send one command to a running server and return its response line.
+        static std::expected<std::string, std::string> request(const std::filesystem::path& path, std::string_view command);
+
+        ControlServer(int fd, std::filesystem::path path, Handler handler, std::shared_ptr<spdlog::logger> logger);
+
+        /// @brief Stop serving (waits for a command in progress) and remove the socket file.
+        ~ControlServer();
+
+        ControlServer(const ControlServer&) = delete;
+        ControlServer& operator=(const ControlServer&) = delete;
+
+    private:
+        int fd;
+        std::filesystem::path path;
+        Handler handler;
+        std::shared_ptr<spdlog::logger> logger;
+        std::jthread worker; // Last member: started after everything above is initialized.
+
+        void run(std::stop_token stop);
+        void serve(int client);
+    };
+
+} // namespace media_handler::utils
@@ -0,0 +1,76 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <spdlog/spdlog.h>
+
+namespace media_handler::utils {
+
+    enum class EventType : std::uint16_t {
+        FileStart = 1, // text = file name
+        FileOk = 2, // a = bytes in, b = bytes out, c = elapsed ms, text = file name
+        FileFail = 3, // a = bytes in, c = elapsed ms, text = file name
+        FileSkip = 4, // text = file name
+        VideoBitrate = 5, // a = source kbps, b = target kbps, c = max kbps
+        FilePassthrough = 6, // a = bytes in, b = bytes out, c = elapsed ms, text = file name
+    };
+
+    /// @brief One fixed-size binary event. Written to the log file as-is (host byte order).
+    struct EventRecord {
+        std::uint64_t time_ns = 0; // System clock, ns since the Unix epoch.
+        std::uint32_t thread = 0; // Small per-process thread number (1, 2, ...).
+        EventType type = EventType::FileStart;
+        std::uint16_t text_len = 0;
+        std::uint64_t a = 0;
+        std::uint64_t b = 0;
+        std::uint32_t c = 0;
+        std::uint32_t d = 0;
+        char text[24] = {}; // Last bytes of the file name; not NUL-terminated.
+    };
+    static_assert(sizeof(EventRecord) == 64, "EventRecord must stay one cache line");
+
+    /// @brief Binary per-file event log: each worker appends fixed-size records to its own lock-free ring,
+    /// and a background thread drains the rings to disk. Nothing is formatted on the worker path;
+    /// media_handler_events turns the file into text or JSON.
+    class EventLog {
+    public:
+        static constexpr std::size_t RING_RECORDS = 4096; // Per thread (256 KB).
+
+        /// @brief Create (truncate) the log file and start draining. Returns false and logs why on failure.
+        static bool start(const std::filesystem::path& file, const std::shared_ptr<spdlog::logger>& logger);
+
+        /// @brief Drain all rings, stop the background thread and close the file.
+        static void stop();
+
+        static bool enabled() { return active.load(std::memory_order_relaxed); }
+
+        /// @brief Append an event for the calling thread. Never blocks: a full ring drops the record (counted).
+        static void emit(EventType type, std::string_view text = {},
+            std::uint64_t a = 0, std::uint64_t b = 0, std::uint32_t c = 0, std::uint32_t d = 0);
+
+        /// @brief Records written to disk / dropped on full rings since start().
+        static std::uint64_t written();
+        static std::uint64_t dropped();
+
+        /// @brief Per-thread rings allocated: live emitting threads, plus exited ones not yet drained.
+        static std::size_t rings();
+
+    private:
+        static inline std::atomic<bool> active{ false };
+    };
+
+    /// @brief Read every record of a binary event log, in file order (time order within each drain).
+    std::expected<std::vector<EventRecord>, std::string> read_events(const std::filesystem::path& file);
+
+    /// @brief One human-readable line, e.g. "2024-05-01T10:00:00.123456Z [T3] OK    IMG_0001.jpg 4.1MB -> 1.2MB 120ms".
+    std::string format_event_text(const EventRecord& e);
+
+    /// @brief One JSON object with typed fields per event type.
+    std::string format_event_json(const EventRecord& e);
+
+} // namespace media_handler::utils
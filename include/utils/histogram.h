@@ -0,0 +1,50 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace media_handler::utils {
+
+    /// @brief Lock-free latency histogram with fixed Prometheus-style bucket bounds (seconds).
+    class LatencyHistogram {
+    public:
+        static constexpr std::array<double, 16> bounds = {
+            0.001, 0.005, 0.01, 0.05, 0.1, 0.25, 0.5, 1.0,
+            2.5, 5.0, 10.0, 30.0, 60.0, 300.0, 900.0, 3600.0
+        };
+
+        /// @brief Point-in-time copy. Buckets are non-cumulative; the last one is +Inf.
+        struct Snapshot {
+            std::array<std::uint64_t, bounds.size() + 1> buckets{};
+            std::uint64_t count = 0;
+            double sum_seconds = 0.0;
+        };
+
+        /// @brief Record one observation.
+        void observe(std::chrono::nanoseconds d) {
+            const double s = std::chrono::duration<double>(d).count();
+            std::size_t i = 0;
+            while (i < bounds.size() && s > bounds[i]) ++i;
+
+            buckets[i].fetch_add(1, std::memory_order_relaxed);
+            sum_ns.fetch_add(static_cast<std::uint64_t>(d.count() > 0 ? d.count() : 0), std::memory_order_relaxed);
+            count.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        Snapshot snapshot() const {
+            Snapshot s;
+            for (std::size_t i = 0; i < buckets.size(); ++i)
+                s.buckets[i] = buckets[i].load(std::memory_order_relaxed);
+            s.count = count.load(std::memory_order_relaxed);
+            s.sum_seconds = sum_ns.load(std::memory_order_relaxed) / 1e9;
+            return s;
+        }
+
+    private:
+        std::array<std::atomic<std::uint64_t>, bounds.size() + 1> buckets{};
+        std::atomic<std::uint64_t> count{ 0 };
+        std::atomic<std::uint64_t> sum_ns{ 0 };
+    };
+
+} // namespace media_handler::utils
@@ -0,0 +1,94 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace media_handler::utils {
+
+    /// @brief Contention counters of one named lock (or blocking queue), shared by every instance with that name.
+    class LockStats {
+    public:
+        /// @brief Values read from the counters.
+        struct Snapshot {
+            std::string name;
+            std::uint64_t acquisitions = 0;
+            std::uint64_t contended = 0; // Acquisitions that had to wait.
+            std::chrono::nanoseconds wait{}; // Total time spent waiting to acquire.
+            std::chrono::nanoseconds max_wait{};
+            std::chrono::nanoseconds hold{}; // Total time held (0 for queues).
+        };
+
+        explicit LockStats(std::string name) : name(std::move(name)) {}
+
+        /// @brief Stats registered under a name; created on first use and kept for the life of the process.
+        static std::shared_ptr<LockStats> get(const std::string& name);
+
+        /// @brief Every registered lock that has been acquired at least once, in registration order.
+        static std::vector<Snapshot> all();
+
+        /// @brief Zero every registered lock (e.g. between benchmark runs).
+        static void reset_all();
+
+        void record_acquire(std::chrono::nanoseconds waited, bool was_contended);
+        void record_hold(std::chrono::nanoseconds held);
+
+        Snapshot snapshot() const;
+        void reset();
+
+    private:
+        std::string name;
+        std::atomic<std::uint64_t> acquisitions{ 0 };
+        std::atomic<std::uint64_t> contended{ 0 };
+        std::atomic<std::int64_t> wait_ns{ 0 };
+        std::atomic<std::int64_t> max_wait_ns{ 0 };
+        std::atomic<std::int64_t> hold_ns{ 0 };
+    };
+
+    /// @brief std::mutex that records wait time, hold time and acquisition count under a name.
+    /// Satisfies Lockable, so it works with lock_guard, unique_lock and condition_variable_any
+    /// (time asleep in a condition wait is not counted as hold time).
+    class InstrumentedMutex {
+    public:
+        explicit InstrumentedMutex(const std::string& name) : stats(LockStats::get(name)) {}
+
+        InstrumentedMutex(const InstrumentedMutex&) = delete;
+        InstrumentedMutex& operator=(const InstrumentedMutex&) = delete;
+
+        void lock() {
+            if (m.try_lock()) {
+                // Uncontended fast path: one clock read for the hold start.
+                acquired = std::chrono::steady_clock::now();
+                stats->record_acquire(std::chrono::nanoseconds(0), false);
+                return;
+            }
+            const auto t0 = std::chrono::steady_clock::now();
+            m.lock();
+            acquired = std::chrono::steady_clock::now();
+            stats->record_acquire(acquired - t0, true);
+        }
+
+        bool try_lock() {
+            if (!m.try_lock()) return false;
+            acquired = std::chrono::steady_clock::now();
+            stats->record_acquire(std::chrono::nanoseconds(0), false);
+            return true;
+        }
+
+        void unlock() {
+            // Only the owner writes 'acquired', so reading it before releasing is race-free.
+            const auto held = std::chrono::steady_clock::now() - acquired;
+            m.unlock();
+            stats->record_hold(held);
+        }
+
+    private:
+        std::mutex m;
+        std::shared_ptr<LockStats> stats;
+        std::chrono::steady_clock::time_point acquired;
+    };
+
+} // namespace media_handler::utils
@@ -0,0 +1,188 @@
+#pragma once
+#include <algorithm>
+#include <charconv>
+#include <concepts>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <string_view>
+#include <spdlog/spdlog.h>
+#include "utils/utils.h"
+
+namespace media_handler::utils {
+
+    /// @brief Appends JSON tokens to any buffer with append(const char*, const char*) (spdlog::memory_buf_t,
+    /// FixedBuffer). Strings are escaped per RFC 8259; nothing here allocates.
+    template <class Buffer>
+    class JsonWriter {
+    public:
+        explicit JsonWriter(Buffer& out) : out(out) {}
+
+        void raw(std::string_view s) { out.append(s.data(), s.data() + s.size()); }
+
+        /// @brief Quoted, escaped string. Bytes >= 0x80 are passed through (UTF-8 stays UTF-8).
+        void string(std::string_view s) {
+            raw("\"");
+            escaped(s);
+            raw("\"");
+        }
+
+        /// @brief String contents without the quotes, for values assembled from several pieces.
+        void escaped(std::string_view s) {
+            static constexpr char hex[] = "0123456789abcdef";
+            const char* run = s.data();
+            const char* end = s.data() + s.size();
+            for (const char* p = run; p != end; ++p) {
+                const auto ch = static_cast<unsigned char>(*p);
+                if (ch >= 0x20 && ch != '"' && ch != '\\') continue;
+                out.append(run, p);
+                run = p + 1;
+                switch (ch) {
+                case '"': raw("\\\""); break;
+                case '\\': raw("\\\\"); break;
+                case '\n': raw("\\n"); break;
+                case '\r': raw("\\r"); break;
+                case '\t': raw("\\t"); break;
+                default: {
+                    const char esc[6] = { '\\', 'u', '0', '0', hex[ch >> 4], hex[ch & 0xF] };
+                    out.append(esc, esc + 6);
+                }
+                }
+            }
+            out.append(run, end);
+        }
+
+        template <std::integral T>
+            requires (!std::same_as<T, bool>)
+        void number(T v) {
+            char buf[24];
+            const auto r = std::to_chars(buf, buf + sizeof(buf), v);
+            out.append(buf, r.ptr);
+        }
+
+        /// @brief Shortest round-trip form; NaN and infinities (not valid JSON) become null.
+        void number(double v) {
+            if (v != v || v - v != 0.0) { raw("null"); return; }
+            char buf[32];
+            const auto r = std::to_chars(buf, buf + sizeof(buf), v);
+            out.append(buf, r.ptr);
+        }
+
+        void boolean(bool v) { raw(v ? "true" : "false"); }
+
+        /// @brief `"key": ` preceded by ", " unless it is the first key written by this writer.
+        void key(std::string_view k) {
+            if (fields++ > 0) raw(", ");
+            string(k);
+            raw(": ");
+        }
+
+    private:
+        Buffer& out;
+        std::size_t fields = 0;
+    };
+
+    /// @brief Fixed-capacity character buffer. An append that does not fit is dropped and marks the buffer full.
+    template <std::size_t N>
+    class FixedBuffer {
+    public:
+        void append(const char* first, const char* last) {
+            const auto n = static_cast<std::size_t>(last - first);
+            if (n > N - len) { overflow = true; return; }
+            std::memcpy(data_ + len, first, n);
+            len += n;
+        }
+
+        char* data() { return data_; }
+        const char* data() const { return data_; }
+        std::size_t size() const { return len; }
+        std::size_t capacity() const { return N; }
+        bool overflowed() const { return overflow; }
+
+        /// @brief Drop everything after `n` bytes and clear the overflow mark.
+        void truncate(std::size_t n) { len = std::min(len, n); overflow = false; }
+
+    private:
+        char data_[N];
+        std::size_t len = 0;
+        bool overflow = false;
+    };
+
+    /// @brief Structured log line: an event name plus typed fields, and the usual human-readable message.
+    /// The JSON log writes the fields as top-level keys next to "message"; the text log shows only the message.
+    /// Built on the stack, so nothing is allocated before the record reaches spdlog:
+    ///     LogEvent("file_ok").field("file", name).field("size_in", bytes).log(*logger, spdlog::level::debug, "OK {}", name);
+    class LogEvent {
+    public:
+        static constexpr std::size_t CAPACITY = 1024;
+
+        /// @brief Leading byte of a structured payload; the fields end at the next one and the message follows.
+        /// Field text is JSON-escaped, so it can never contain the separator itself.
+        static constexpr char SEPARATOR = '\x1f';
+
+        explicit LogEvent(std::string_view event) : json(buf) {
+            buf.append(&SEPARATOR, &SEPARATOR + 1);
+            json.key("event");
+            json.string(event);
+        }
+
+        LogEvent& field(std::string_view key, std::string_view value) { return put(key, [&] { json.string(value); }); }
+        LogEvent& field(std::string_view key, const char* value) { return field(key, std::string_view(value)); }
+        LogEvent& field(std::string_view key, double value) { return put(key, [&] { json.number(value); }); }
+        LogEvent& field(std::string_view key, bool value) { return put(key, [&] { json.boolean(value); }); }
+
+        template <std::integral T>
+            requires (!std::same_as<T, bool>)
+        LogEvent& field(std::string_view key, T value) { return put(key, [&] { json.number(value); }); }
+
+        /// @brief Format the message and hand the record to the logger (no-op below its level). Loggers not made
+        /// by Logger::create() have formatters that know nothing of fields, so they get the message alone.
+        template <class... Args>
+        void log(spdlog::logger& logger, spdlog::level::level_enum level, std::format_string<Args...> fmt, Args&&... args) {
+            if (!logger.should_log(level)) return;
+            std::string_view payload = format(fmt, std::forward<Args>(args)...);
+            if (!Logger::structured(logger)) payload.remove_prefix(message_offset);
+            logger.log(level, spdlog::string_view_t(payload.data(), payload.size()));
+        }
+
+        /// @brief The complete payload: separator, fields, separator, message. Call once; a message longer
+        /// than the space left is cut short.
+        template <class... Args>
+        std::string_view format(std::format_string<Args...> fmt, Args&&... args) {
+            buf.append(&SEPARATOR, &SEPARATOR + 1);
+            message_offset = buf.size();
+            const auto room = static_cast<std::ptrdiff_t>(buf.capacity() - buf.size());
+            const auto r = std::format_to_n(buf.data() + buf.size(), room, fmt, std::forward<Args>(args)...);
+            const auto n = static_cast<std::size_t>(std::min<std::ptrdiff_t>(r.size, room));
+            return { buf.data(), buf.size() + n };
+        }
+
+        /// @brief Split a payload made by log() into its JSON fields and message. False for ordinary messages.
+        static bool split(std::string_view payload, std::string_view& fields, std::string_view& message) {
+            if (payload.empty() || payload.front() != SEPARATOR) return false;
+            const auto end = payload.find(SEPARATOR, 1);
+            if (end == std::string_view::npos) return false;
+            fields = payload.substr(1, end - 1);
+            message = payload.substr(end + 1);
+            return true;
+        }
+
+    private:
+        /// @brief Write one field, or none at all if it does not fit (leaving room for the message).
+        template <class WriteValue>
+        LogEvent& put(std::string_view key, WriteValue write) {
+            const auto before = buf.size();
+            json.key(key);
+            write();
+            if (buf.overflowed() || buf.size() > CAPACITY - MESSAGE_RESERVE) buf.truncate(before);
+            return *this;
+        }
+
+        static constexpr std::size_t MESSAGE_RESERVE = 256;
+
+        FixedBuffer<CAPACITY> buf;
+        JsonWriter<FixedBuffer<CAPACITY>> json;
+        std::size_t message_offset = 0;
+    };
+
+} // namespace media_handler::utils
@@ -0,0 +1,47 @@
+#pragma once
+#include "utils/progress_tracker.h"
+#include <filesystem>
+#include <chrono>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <spdlog/spdlog.h>
+
+namespace media_handler::utils {
+
+    /// @brief Periodically writes tracker metrics in Prometheus text format for node_exporter's textfile collector.
+    class MetricsExporter {
+    public:
+        /// @brief Starts the export thread. The tracker must outlive the exporter.
+        MetricsExporter(const ProgressTracker& tracker, std::filesystem::path file, std::chrono::seconds interval, std::shared_ptr<spdlog::logger> logger);
+
+        /// @brief Stops the export thread and writes a final snapshot.
+        ~MetricsExporter();
+
+        MetricsExporter(const MetricsExporter&) = delete;
+        MetricsExporter& operator=(const MetricsExporter&) = delete;
+
+        /// @brief Write the current snapshot now (tmp file + rename, so readers never see a partial file).
+        /// Safe to call from any thread: writes are serialized with the export thread's.
+        void write() const;
+
+        /// @brief Render a snapshot in Prometheus text exposition format.
+        static std::string render(const ProgressTracker::Snapshot& s);
+
+    private:
+        const ProgressTracker& tracker;
+        std::filesystem::path file;
+        std::chrono::seconds interval;
+        std::shared_ptr<spdlog::logger> logger;
+
+        std::mutex mutex;
+        std::condition_variable_any cv;
+        mutable std::mutex write_mutex; // One writer at a time on the shared tmp file.
+        std::jthread worker; // Last member: started after everything above is initialized.
+
+        void run(std::stop_token stop);
+    };
+
+} // namespace media_handler::utils
@@ -0,0 +1,42 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <spdlog/spdlog.h>
+
+namespace media_handler::utils {
+
+    /// @brief Hardware counter readings. Counters the CPU/kernel does not expose stay 0.
+    struct PerfValues {
+        std::uint64_t cycles = 0;
+        std::uint64_t instructions = 0;
+        std::uint64_t cache_misses = 0;
+        std::uint64_t branch_misses = 0;
+
+        PerfValues operator-(const PerfValues& o) const {
+            return { cycles - o.cycles, instructions - o.instructions, cache_misses - o.cache_misses, branch_misses - o.branch_misses };
+        }
+
+        PerfValues& operator+=(const PerfValues& o) {
+            cycles += o.cycles; instructions += o.instructions;
+            cache_misses += o.cache_misses; branch_misses += o.branch_misses;
+            return *this;
+        }
+
+        double ipc() const { return cycles > 0 ? static_cast<double>(instructions) / cycles : 0.0; }
+    };
+
+    /// @brief Opt-in per-thread hardware counters via perf_event_open (Linux only).
+    /// Counts the calling thread in user space; codec threads spawned by FFmpeg are not included.
+    class PerfCounters {
+    public:
+        /// @brief Probe and switch counters on for the process. Returns false (and logs why) if perf events are not permitted.
+        static bool enable(const std::shared_ptr<spdlog::logger>& logger);
+
+        /// @brief True once enable() succeeded.
+        static bool enabled();
+
+        /// @brief Current counter values of the calling thread (opens its counter group on first use).
+        static PerfValues read();
+    };
+
+} // namespace media_handler::utils
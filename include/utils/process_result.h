@@ -5,8 +5,10 @@ namespace media_handler::utils {
     struct ProcessResult {
         bool success;
         std::string message;
+        bool passthrough = false; // Source copied unchanged because compressing it was predicted not to pay off.
 
         static ProcessResult OK() { return { true,  "" }; }
         static ProcessResult Error(std::string msg) { return { false, std::move(msg) }; }
+        static ProcessResult Passthrough(std::string reason) { return { true, std::move(reason), true }; }
     };
 }
\ No newline at end of file
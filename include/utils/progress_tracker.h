@@ -6,18 +6,46 @@
 #include <mutex>
 #include <memory>
 #include <filesystem>
+#include <array>
+#include <optional>
+#include <set>
 #include <spdlog/spdlog.h>
+#include "utils/histogram.h"
+#include "utils/lock_stats.h"
+#include "utils/resource_usage.h"
+#include "utils/work_context.h"
 
 namespace media_handler::utils {
 
+    class RunReport;
+
+    /// @brief Media category used to split per-kind metrics.
+    enum class MediaKind : std::uint8_t { Image, Video, Other };
+    inline constexpr std::size_t media_kind_count = 3;
+
+    /// @brief Lowercase label for metrics and reports ("image", "video", "other").
+    const char* to_string(MediaKind kind);
+
     /// @brief File metrics captured during processing.
     struct FileStats {
         std::string filename;
+        std::string path; // Full input path (UTF-8), for run reports.
+        MediaKind kind = MediaKind::Other;
         std::uintmax_t size_in = 0; // Input bytes.
         std::uintmax_t size_out = 0; // Output bytes (0 if failed).
         std::chrono::milliseconds elapsed = {};
+        std::chrono::nanoseconds cpu_time = {}; // Worker thread CPU + attributed helper threads.
+        std::uint64_t io_read = 0; // Bytes read by the worker thread while processing.
+        std::uint64_t io_written = 0; // Bytes written by the worker thread while processing.
+        std::uint64_t peak_rss_delta = 0; // Growth of the process RSS high-water mark (approximate; shared by all workers).
+        PerfValues perf{}; // Worker-thread hardware counters (only with --perf-counters).
+        std::uint64_t pixels = 0; // Source pixels (images).
+        std::uint64_t frames = 0; // Decoded frames (video).
+        std::array<std::chrono::nanoseconds, stage_count> stage_wall{}; // Wall time per processor stage.
+        double ssim = 0.0; // Output luma SSIM against the source (only with --jpeg-verify-ssim; 0 = not measured).
         bool success = false;
         bool skipped = false;
+        bool passthrough = false; // Copied unchanged; error holds the reason.
         std::string error;
     };
 
@@ -25,14 +53,50 @@ namespace media_handler::utils {
     class ProgressTracker {
     public:
 
+        /// @brief Counter and gauge values read from the tracker's atomics.
+        struct Snapshot {
+            std::size_t total = 0;
+            std::size_t completed = 0;
+            std::size_t failed = 0;
+            std::size_t skipped = 0;
+            std::size_t passthrough = 0;
+            std::uintmax_t bytes_in = 0;
+            std::uintmax_t bytes_out = 0;
+            std::uintmax_t bytes_planned = 0; // Input bytes scheduled via add_planned().
+            std::uintmax_t bytes_done = 0; // Input bytes finished (any outcome).
+            std::size_t queue_depth = 0;
+            std::size_t busy_workers = 0;
+            std::size_t workers = 0;
+            std::array<LatencyHistogram::Snapshot, media_kind_count> processing_time{};
+            std::array<double, media_kind_count> cpu_seconds{};
+            LatencyHistogram::Snapshot state_commit{};
+            std::chrono::steady_clock::duration uptime{};
+        };
+
+        /// @brief Marks the calling worker busy for the lifetime of the scope.
+        class WorkerScope {
+        public:
+            explicit WorkerScope(ProgressTracker& t) : tracker(t) { tracker.busy_workers.fetch_add(1, std::memory_order_relaxed); }
+            ~WorkerScope() { tracker.busy_workers.fetch_sub(1, std::memory_order_relaxed); }
+            WorkerScope(const WorkerScope&) = delete;
+            WorkerScope& operator=(const WorkerScope&) = delete;
+        private:
+            ProgressTracker& tracker;
+        };
+
         ProgressTracker(std::size_t total_files, std::shared_ptr<spdlog::logger> logger);
 
         /// @brief Register file as started; returns token for finishFile().
-        std::size_t begin_file(const std::filesystem::path& file);
+        /// Samples the calling thread's resource counters, so finish_file() must run on the same thread.
+        std::size_t begin_file(const std::filesystem::path& file, MediaKind kind = MediaKind::Other);
 
-        /// @brief Record result and emit one-line log: size, %, MB/s, ms.
+        /// @brief Add a scheduled file's input size to the byte-weighted progress total.
+        void add_planned(MediaKind kind, std::uintmax_t bytes);
+
+        /// @brief Record result and emit one-line debug log: size, %, MB/s, ms.
+        /// @param passthrough The processor copied the source unchanged; error holds why.
         void finish_file(std::size_t token, const std::filesystem::path& output,
-            bool success, const std::string& error = {});
+            bool success, const std::string& error = {}, bool passthrough = false);
 
         /// @brief Record file as skipped (completed in prior run).
         void skip_file(const std::filesystem::path& file);
@@ -40,18 +104,78 @@ namespace media_handler::utils {
         /// @brief Print GB / % saved / elapsed summary. Call after all workers join.
         void print_summary() const;
 
+        /// @brief Live progress: what the heartbeat logs and the control socket's status command returns.
+        struct Progress {
+            std::size_t files_done = 0; // OK + failed + skipped + passthrough.
+            std::size_t total = 0;
+            std::uintmax_t bytes_done = 0;
+            std::uintmax_t bytes_planned = 0;
+            double percent = 0.0; // Byte-weighted.
+            double mb_per_s = 0.0; // Input bytes since the run started.
+            std::optional<std::chrono::seconds> eta; // Empty until every remaining kind has a rate.
+            std::vector<std::pair<std::string, std::chrono::seconds>> in_flight; // Longest-running first.
+            std::size_t in_flight_count = 0; // May exceed in_flight.size().
+        };
+
+        /// @brief Compute progress, listing at most max_in_flight running files by name.
+        Progress progress(std::size_t max_in_flight) const;
+
+        /// @brief Log one progress line: byte-weighted %, throughput, per-kind ETA and in-flight files.
+        void log_heartbeat() const;
+
+        /// @brief Lock-free read of counters, gauges and histograms (safe while workers run).
+        Snapshot snapshot() const;
+
+        /// @brief Number of files still waiting in the work queue.
+        void set_queue_depth(std::size_t depth) { queue_depth.store(depth, std::memory_order_relaxed); }
+
+        /// @brief Number of worker threads in the pool.
+        void set_workers(std::size_t count) { workers.store(count, std::memory_order_relaxed); }
+
+        /// @brief Stream a record of every finished file to this report (not owned; must outlive the tracker's use).
+        void set_report(RunReport* r) { report = r; }
+
+        /// @brief Time taken to persist run state (lock wait + RetryLog::save()).
+        void record_state_commit(std::chrono::nanoseconds d) { state_commit.observe(d); }
+
     private:
         std::size_t total;
         std::shared_ptr<spdlog::logger> logger;
 
-        mutable std::mutex mutex;
+        mutable InstrumentedMutex mutex{ "tracker" };
         std::vector<FileStats> stats;
         std::vector<std::chrono::steady_clock::time_point> start_times;
+        std::vector<ResourceSample> start_usage;
+        std::set<std::size_t> in_flight; // Tokens begun but not yet finished.
+        RunReport* report = nullptr;
+
+        /// @brief Byte-weighted, exponentially decayed throughput per media kind (guarded by mutex).
+        struct KindRate {
+            double bytes = 0.0;
+            double seconds = 0.0;
+        };
+        std::array<KindRate, media_kind_count> rates{};
+
+        // Per-kind stage totals (wall time + counters), guarded by mutex.
+        std::array<std::array<StageStats, stage_count>, media_kind_count> stage_totals{};
 
 		// std::atomic counters for summary stats - updated by workers without locking entire struct.
         std::atomic<std::size_t> completed{ 0 };
         std::atomic<std::size_t> failed{ 0 };
         std::atomic<std::size_t> skipped{ 0 };
+        std::atomic<std::size_t> passed_through{ 0 };
+
+        // Metrics - read by snapshot() without taking the mutex.
+        std::atomic<std::uintmax_t> bytes_in{ 0 };
+        std::atomic<std::uintmax_t> bytes_out{ 0 };
+        std::array<std::atomic<std::uintmax_t>, media_kind_count> planned_bytes{};
+        std::array<std::atomic<std::uintmax_t>, media_kind_count> done_bytes{};
+        std::atomic<std::size_t> queue_depth{ 0 };
+        std::atomic<std::size_t> busy_workers{ 0 };
+        std::atomic<std::size_t> workers{ 0 };
+        std::array<LatencyHistogram, media_kind_count> processing_time;
+        std::array<std::atomic<std::uint64_t>, media_kind_count> cpu_ns{};
+        LatencyHistogram state_commit;
 
         std::chrono::steady_clock::time_point run_start;
     };
@@ -0,0 +1,71 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace media_handler::utils {
+
+    /// @brief One file row of a run report (see RunReport).
+    struct ReportFile {
+        std::string path;
+        std::string kind;
+        std::string outcome; // "ok" / "failed" / "skipped" / "passthrough"
+        std::uintmax_t size_in = 0;
+        std::uintmax_t size_out = 0;
+        double elapsed_ms = 0.0;
+        std::string error;
+    };
+
+    /// @brief A run report read back from NDJSON or CSV.
+    struct Report {
+        std::vector<ReportFile> files;
+        std::optional<double> wall_seconds; // From the summary record, if the run finished.
+    };
+
+    /// @brief Read a report written by RunReport; the format is detected from the first line.
+    std::expected<Report, std::string> load_report(const std::filesystem::path& file);
+
+    /// @brief Per-kind totals of successfully processed files in both runs.
+    struct KindDelta {
+        std::string kind;
+        std::size_t files_a = 0, files_b = 0;
+        double mb_per_s_a = 0.0, mb_per_s_b = 0.0; // Input MB per busy worker-second.
+        double saved_pct_a = 0.0, saved_pct_b = 0.0; // 1 - out/in, in percent.
+        double throughput_change_pct = 0.0;
+        double saved_change_points = 0.0;
+    };
+
+    /// @brief A file present (and OK) in both runs that took longer in the second.
+    struct SlowerFile {
+        std::string path;
+        double elapsed_ms_a = 0.0, elapsed_ms_b = 0.0;
+        double change_pct = 0.0;
+    };
+
+    /// @brief Result of comparing a baseline run (a) with a candidate run (b).
+    struct Comparison {
+        std::vector<KindDelta> kinds;
+        std::optional<double> wall_change_pct; // Candidate wall time vs baseline, when both have summaries.
+        std::vector<SlowerFile> slower; // Largest absolute slowdown first.
+        std::vector<std::string> newly_failed; // OK in a, failed in b.
+        std::vector<std::string> regressions; // One line per threshold breach.
+    };
+
+    /// @brief Options for compare_reports().
+    struct CompareOptions {
+        double threshold_pct = 5.0; // Throughput drop / savings loss / per-file slowdown that counts.
+        double min_slowdown_ms = 10.0; // Ignore per-file slowdowns below this (timer noise).
+        std::size_t max_slower = 20;
+    };
+
+    /// @brief Diff two runs of the same corpus; files are matched by path.
+    Comparison compare_reports(const Report& a, const Report& b, const CompareOptions& opts = {});
+
+    /// @brief Human-readable table of a comparison.
+    std::string format_comparison(const Comparison& c, const CompareOptions& opts = {});
+
+} // namespace media_handler::utils
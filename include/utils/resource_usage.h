@@ -0,0 +1,40 @@
+#pragma once
+#include "utils/perf_counters.h"
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace media_handler::utils {
+
+    /// @brief Resource counters of the calling thread, sampled before and after each file.
+    struct ResourceSample {
+        std::chrono::nanoseconds cpu{}; // Thread CPU time (CLOCK_THREAD_CPUTIME_ID).
+        std::uint64_t read_bytes = 0; // rchar from /proc/thread-self/io (includes page-cache hits).
+        std::uint64_t write_bytes = 0; // wchar from /proc/thread-self/io.
+        std::uint64_t peak_rss = 0; // Process high-water RSS in bytes (ru_maxrss).
+        PerfValues perf{}; // Hardware counters of this thread (zero unless PerfCounters is enabled).
+
+        /// @brief Sample the calling thread. Counters that are unavailable on this platform stay 0.
+        static ResourceSample now();
+    };
+
+    /// @brief Attributes CPU of threads a library spawns (e.g. FFmpeg codec threads) to the current file.
+    /// Threads that appear between construction and adopt() are assumed to be ours; another worker
+    /// opening a codec at the same moment can be misattributed. Linux only; no-op elsewhere.
+    class HelperThreadCpu {
+    public:
+        /// @brief Snapshot the threads that already exist.
+        HelperThreadCpu();
+
+        /// @brief Claim threads created since construction (call after the codecs are opened).
+        void adopt();
+
+        /// @brief Add adopted threads' CPU to WorkContext::current() (call before the codecs are freed).
+        void collect();
+
+    private:
+        std::vector<long> baseline;
+        std::vector<long> adopted;
+    };
+
+} // namespace media_handler::utils
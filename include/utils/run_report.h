@@ -0,0 +1,52 @@
+#pragma once
+#include "utils/progress_tracker.h"
+#include <array>
+#include <expected>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace media_handler::utils {
+
+    /// @brief Machine-readable per-file run report, streamed as files finish.
+    /// NDJSON (one {"type":"file"} object per line, then one {"type":"summary"}) or CSV with a
+    /// trailing "summary" row, chosen by the file extension. Read back by media_handler_compare.
+    class RunReport {
+    public:
+        enum class Format { NDJson, Csv };
+
+        /// @brief Create (truncate) the report. ".csv" selects CSV; anything else NDJSON.
+        static std::expected<std::unique_ptr<RunReport>, std::string> open(const std::filesystem::path& file);
+
+        RunReport(std::ofstream out, Format format);
+
+        /// @brief Append one finished (or failed) file. Thread-safe; flushed per line so a crash keeps what was done.
+        void append(const FileStats& s);
+
+        /// @brief Append the aggregate record. Call once, after all workers are done.
+        void write_summary(const ProgressTracker::Snapshot& snap);
+
+        /// @brief "ok" / "failed" / "skipped" / "passthrough"
+        static const char* outcome(const FileStats& s);
+
+        /// @brief CSV column names, shared with the report reader.
+        static constexpr const char* CSV_HEADER =
+            "type,path,kind,outcome,size_in,size_out,elapsed_ms,cpu_ms,decode_ms,resize_ms,encode_ms,transcode_ms,metadata_ms,ssim,error";
+
+    private:
+        /// @brief Per-kind totals of the appended files, for the summary record.
+        struct KindTotals {
+            std::size_t ok = 0, failed = 0, skipped = 0, passthrough = 0;
+            std::uintmax_t bytes_in = 0, bytes_out = 0;
+            double busy_seconds = 0.0; // Sum of per-file elapsed time.
+        };
+
+        std::mutex mutex;
+        std::ofstream out;
+        Format format;
+        std::array<KindTotals, media_kind_count> kinds{};
+    };
+
+} // namespace media_handler::utils
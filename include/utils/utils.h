@@ -1,8 +1,13 @@
 #pragma once
 #include <spdlog/spdlog.h>
+#include <atomic>
+#include <cstdio>
 #include <memory>
 #include <fstream>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <vector>
 #include "config.h"
 
 namespace media_handler::utils {
@@ -28,12 +33,24 @@ namespace media_handler::utils {
 #endif
     }
 
+	/// @brief Read a whole file into `out` with one read, reusing its capacity. False if it cannot be read.
+    inline bool read_file_into(const std::filesystem::path& p, std::vector<unsigned char>& out) {
+        std::error_code ec;
+        const auto size = std::filesystem::file_size(p, ec);
+        if (ec) return false;
+        FILE* f = fopen_path(p, "rb");
+        if (!f) return false;
+        out.resize(static_cast<std::size_t>(size));
+        const bool ok = std::fread(out.data(), 1, out.size(), f) == out.size();
+        std::fclose(f);
+        return ok;
+    }
+
 	/// @brief Used to read a file into a byte vector, handling UTF-8 paths correctly
     inline std::vector<unsigned char> read_file_bytes(const std::filesystem::path& p) {
-        std::ifstream f(p, std::ios::binary);
-        if (!f) return {};
-        return { std::istreambuf_iterator<char>(f),
-                 std::istreambuf_iterator<char>() };
+        std::vector<unsigned char> bytes;
+        if (!read_file_into(p, bytes)) return {};
+        return bytes;
     }
 
 	/// @brief Utility functions for path handling and config file discovery
@@ -46,6 +63,16 @@ namespace media_handler::utils {
         static std::filesystem::path find_config_file(const std::string& filename = CONFIG_FILE);
     };
 
+    /// @brief What a logging call does when the shared async queue is full.
+    enum class LogOverflow : std::uint8_t {
+        Block, // Wait for a free slot: nothing is lost, but a slow console stalls the workers.
+        DropOldest, // Overwrite the oldest queued message.
+        DropNew, // Discard the message being logged.
+    };
+
+    /// @brief "block", "drop-oldest" or "drop-new".
+    std::optional<LogOverflow> parse_log_overflow(std::string_view name);
+
 	/// @brief Wrapper for spdlog logger creation
     class Logger {
     public:        
@@ -57,5 +84,49 @@ namespace media_handler::utils {
 
 		/// @brief Flush all loggers
 		static void flush_all();
+
+		/// @brief True for loggers made by create(), whose sinks write LogEvent fields.
+		static bool structured(const spdlog::logger& logger);
+
+		/// @brief Line formatter used by create(): the text pattern, or JSON objects with LogEvent fields as keys.
+		static std::unique_ptr<spdlog::formatter> formatter(bool json_format);
+
+		/// @brief Overflow policy of every logger made by create(), including existing ones. Default: Block.
+		static void set_overflow(LogOverflow policy);
+
+		/// @brief Messages lost since the process started.
+		struct Drops {
+			std::uint64_t oldest = 0; // Overwritten in a full queue.
+			std::uint64_t newest = 0; // Discarded because the queue was full.
+			std::uint64_t suppressed = 0; // Held back by LogSite rate limits.
+		};
+		static Drops drops();
+    };
+
+    /// @brief Rate limit for one repetitive log statement: a token bucket that lets `burst` messages through
+    /// at once and then `per_second`. Declare it static next to the statement it guards:
+    ///     static LogSite site(10, 1.0);
+    ///     if (auto held = site.allow()) logger->warn("... {}", x, LogSite::note(*held));
+    class LogSite {
+    public:
+        LogSite(std::uint32_t burst, double per_second);
+
+        /// @brief Empty if this occurrence must not be logged (it is counted instead); otherwise the number
+        /// of occurrences suppressed since the last one that was logged. Lock-free.
+        std::optional<std::uint64_t> allow();
+
+        /// @brief " (N similar suppressed)", or "" for 0.
+        static std::string note(std::uint64_t suppressed);
+
+        /// @brief Suppressed across all sites since the process started.
+        static std::uint64_t suppressed_total() { return total.load(std::memory_order_relaxed); }
+
+    private:
+        std::int64_t interval_ns;
+        std::int64_t window_ns; // How far ahead of now the bucket may be booked: (burst - 1) intervals.
+        std::atomic<std::int64_t> next_ns{ 0 }; // Theoretical time of the next allowed message.
+        std::atomic<std::uint64_t> pending{ 0 }; // Suppressed since the last allowed message.
+
+        static inline std::atomic<std::uint64_t> total{ 0 };
     };
 } //namespace media_handler::utils
\ No newline at end of file
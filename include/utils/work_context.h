@@ -0,0 +1,134 @@
+#pragma once
+#include "utils/perf_counters.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <utility>
+
+namespace media_handler::utils {
+
+    /// @brief Processor stages timed per file.
+    enum class Stage : std::uint8_t { Decode, Resize, Encode, Transcode, Metadata };
+    inline constexpr std::size_t stage_count = 5;
+
+    inline const char* to_string(Stage stage) {
+        switch (stage) {
+        case Stage::Decode:    return "decode";
+        case Stage::Resize:    return "resize";
+        case Stage::Encode:    return "encode";
+        case Stage::Transcode: return "transcode";
+        default:               return "metadata";
+        }
+    }
+
+    /// @brief Wall time and hardware counters accumulated by one stage.
+    struct StageStats {
+        std::chrono::nanoseconds wall{};
+        PerfValues perf{};
+    };
+
+    /// @brief Per-thread accounting for the file the calling worker is processing.
+    /// Processors add to it; ProgressTracker resets it in begin_file() and reads it in finish_file().
+    struct WorkContext {
+        std::chrono::nanoseconds attributed_cpu{}; // CPU of helper threads (e.g. FFmpeg codec threads) owned by this file.
+        std::uint64_t pixels = 0; // Source pixels decoded (images).
+        std::uint64_t frames = 0; // Frames decoded (video).
+        double ssim = 0.0; // Luma SSIM of the output against its source, when verified.
+        std::array<StageStats, stage_count> stages{};
+
+        void reset() { *this = WorkContext{}; }
+
+        static WorkContext& current() {
+            thread_local WorkContext ctx;
+            return ctx;
+        }
+    };
+
+    /// @brief Pipeline workers left without a file because the queue has run dry, published by the engine.
+    /// Processors borrow their cores for parallel work inside the file they hold by reserving them, so files
+    /// running at once share the idle cores instead of each claiming all of them.
+    struct IdleWorkers {
+        /// @brief Idle cores held by one file; handed back by release() or on destruction.
+        class Reservation {
+        public:
+            Reservation() = default;
+            explicit Reservation(std::size_t n) : n(n) {}
+            Reservation(Reservation&& other) noexcept : n(std::exchange(other.n, 0)) {}
+            Reservation& operator=(Reservation&& other) noexcept {
+                if (this != &other) { release(); n = std::exchange(other.n, 0); }
+                return *this;
+            }
+            ~Reservation() { release(); }
+
+            std::size_t size() const { return n; }
+            void release() {
+                if (n) borrowed().fetch_sub(std::exchange(n, 0), std::memory_order_relaxed);
+            }
+
+        private:
+            std::size_t n = 0;
+        };
+
+        /// @brief Idle cores not yet reserved by a file.
+        static std::size_t get() {
+            const auto idle = count().load(std::memory_order_relaxed);
+            const auto taken = borrowed().load(std::memory_order_relaxed);
+            return idle > taken ? idle - taken : 0;
+        }
+        static void set(std::size_t n) { count().store(n, std::memory_order_relaxed); }
+
+        /// @brief Take up to `max` of the unreserved idle cores; the reservation may hold fewer, or none.
+        static Reservation reserve(std::size_t max) {
+            auto taken = borrowed().load(std::memory_order_relaxed);
+            while (true) {
+                const auto idle = count().load(std::memory_order_relaxed);
+                const auto n = std::min(max, idle > taken ? idle - taken : 0);
+                if (n == 0) return {};
+                if (borrowed().compare_exchange_weak(taken, taken + n, std::memory_order_relaxed)) return Reservation(n);
+            }
+        }
+
+    private:
+        static std::atomic<std::size_t>& count() {
+            static std::atomic<std::size_t> n{ 0 };
+            return n;
+        }
+        static std::atomic<std::size_t>& borrowed() {
+            static std::atomic<std::size_t> n{ 0 };
+            return n;
+        }
+    };
+
+    /// @brief Start point of a stage. Trivially destructible, so it is safe in code that
+    /// longjmps out of libjpeg/libpng errors; prefer StageTimer elsewhere.
+    struct StageMark {
+        std::chrono::steady_clock::time_point start;
+        PerfValues perf;
+
+        static StageMark now() { return { std::chrono::steady_clock::now(), PerfCounters::read() }; }
+
+        /// @brief Charge the time (and counters) since now() to a stage of the current file.
+        void finish(Stage stage) const {
+            auto& s = WorkContext::current().stages[static_cast<std::size_t>(stage)];
+            s.wall += std::chrono::steady_clock::now() - start;
+            if (PerfCounters::enabled()) s.perf += PerfCounters::read() - perf;
+        }
+    };
+
+    /// @brief Times a processor stage of the current file: wall time always, hardware counters when enabled.
+    class StageTimer {
+    public:
+        explicit StageTimer(Stage stage) : stage(stage), mark(StageMark::now()) {}
+        ~StageTimer() { mark.finish(stage); }
+
+        StageTimer(const StageTimer&) = delete;
+        StageTimer& operator=(const StageTimer&) = delete;
+
+    private:
+        Stage stage;
+        StageMark mark;
+    };
+
+} // namespace media_handler::utils
@@ -0,0 +1,192 @@
+#include "compressor/bench_mode.h"
+#include "compressor/compression_engine.h"
+#include "utils/lock_stats.h"
+#include "utils/resource_usage.h"
+#include "utils/utils.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <format>
+#include <fstream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace media_handler::compressor {
+
+    namespace fs = std::filesystem;
+    using namespace media_handler::utils;
+
+    namespace {
+        /// @brief Read every input once so the run starts with them in the page cache.
+        void warm_inputs(const std::vector<fs::path>& files) {
+            std::vector<char> buf(1 << 20);
+            for (const auto& f : files) {
+                FILE* in = fopen_path(f, "rb");
+                if (!in) continue;
+                while (std::fread(buf.data(), 1, buf.size(), in) == buf.size()) {}
+                std::fclose(in);
+            }
+        }
+
+        /// @brief Ask the kernel to drop the inputs' cached pages. Returns false if unsupported.
+        bool evict_inputs(const std::vector<fs::path>& files) {
+#if defined(_WIN32) || defined(__APPLE__)
+            (void)files;
+            return false;
+#else
+            for (const auto& f : files) {
+                int fd = ::open(f.c_str(), O_RDONLY | O_CLOEXEC);
+                if (fd < 0) continue;
+                ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+                ::close(fd);
+            }
+            return true;
+#endif
+        }
+
+        /// @brief Drop the whole page cache, dentries and inodes. Needs root.
+        bool drop_page_cache() {
+#ifdef __linux__
+            ::sync();
+            std::ofstream f("/proc/sys/vm/drop_caches");
+            f << "3\n";
+            f.flush();
+            return static_cast<bool>(f);
+#else
+            return false;
+#endif
+        }
+
+        /// @brief Reset the process high-water RSS (Linux 4.0+), so each run reports its own peak.
+        bool reset_peak_rss() {
+#ifdef __linux__
+            std::ofstream f("/proc/self/clear_refs");
+            f << "5\n";
+            f.flush();
+            return static_cast<bool>(f);
+#else
+            return false;
+#endif
+        }
+
+        /// @brief Process high-water RSS in bytes: VmHWM where available, else ru_maxrss.
+        std::uint64_t peak_rss() {
+#ifdef __linux__
+            std::ifstream f("/proc/self/status");
+            std::string line;
+            while (std::getline(f, line))
+                if (line.starts_with("VmHWM:")) return std::strtoull(line.c_str() + 6, nullptr, 10) * 1024;
+#endif
+            return ResourceSample::now().peak_rss;
+        }
+
+        BenchStat stat_of(const std::vector<double>& v) {
+            BenchStat s;
+            if (v.empty()) return s;
+            for (double x : v) s.mean += x;
+            s.mean /= static_cast<double>(v.size());
+            if (v.size() < 2) return s;
+            double sq = 0.0;
+            for (double x : v) sq += (x - s.mean) * (x - s.mean);
+            s.stddev = std::sqrt(sq / static_cast<double>(v.size() - 1));
+            return s;
+        }
+    }
+
+    std::optional<BenchCache> parse_bench_cache(std::string_view name) {
+        if (name == "warm") return BenchCache::Warm;
+        if (name == "cold") return BenchCache::Cold;
+        if (name == "drop") return BenchCache::Drop;
+        return std::nullopt;
+    }
+
+    BenchSummary summarize(const std::vector<BenchRun>& runs) {
+        std::vector<double> fps, mbps, ratio, rss;
+        for (const auto& r : runs) {
+            fps.push_back(r.seconds > 0.0 ? r.files / r.seconds : 0.0);
+            mbps.push_back(r.seconds > 0.0 ? r.bytes_in / 1'048'576.0 / r.seconds : 0.0);
+            ratio.push_back(r.bytes_in > 0 ? static_cast<double>(r.bytes_out) / r.bytes_in : 0.0);
+            rss.push_back(r.peak_rss / 1'048'576.0);
+        }
+        return { runs.size(), stat_of(fps), stat_of(mbps), stat_of(ratio), stat_of(rss) };
+    }
+
+    std::expected<BenchSummary, std::string> run_bench(const Config& cfg, const BenchOptions& opts,
+        std::shared_ptr<spdlog::logger> logger) {
+        if (opts.runs == 0) return std::unexpected("bench needs at least one run");
+
+        // Outputs go to a directory only the benchmark owns, on the same filesystem as the real output.
+        const fs::path scratch = fs::path(cfg.output_dir) / ".media_handler_bench";
+        Config run_cfg = cfg;
+        run_cfg.output_dir = path_to_utf8(scratch);
+
+        CompressionEngine engine(run_cfg);
+        const auto inputs = engine.scan_media_files(cfg.input_dir);
+        if (inputs.empty()) return std::unexpected(std::format("no media files in {}", cfg.input_dir));
+
+        BenchCache cache = opts.cache;
+        if (cache == BenchCache::Drop && !drop_page_cache()) {
+            logger->warn("Bench: cannot write /proc/sys/vm/drop_caches (needs root) - evicting inputs with posix_fadvise instead");
+            cache = BenchCache::Cold;
+        }
+        if (cache == BenchCache::Cold && !evict_inputs(inputs)) {
+            logger->warn("Bench: page-cache eviction is not supported on this platform - results are warm-cache");
+            cache = BenchCache::Warm;
+        }
+        const bool per_run_rss = reset_peak_rss();
+        if (!per_run_rss) logger->warn("Bench: cannot reset peak RSS - reported values are cumulative across runs");
+
+        const MigrateOptions migrate_opts{ .ignore_state = true };
+        std::vector<BenchRun> runs;
+        runs.reserve(opts.runs);
+
+        for (unsigned i = 0; i < opts.runs; ++i) {
+            std::error_code ec;
+            fs::remove_all(scratch, ec);
+            fs::create_directories(scratch, ec);
+            if (ec) return std::unexpected(std::format("cannot create {}: {}", path_to_utf8(scratch), ec.message()));
+
+            switch (cache) {
+            case BenchCache::Warm: warm_inputs(inputs); break;
+            case BenchCache::Cold: evict_inputs(inputs); break;
+            case BenchCache::Drop: drop_page_cache(); break;
+            }
+            LockStats::reset_all();
+            if (per_run_rss) reset_peak_rss();
+
+            const auto t0 = std::chrono::steady_clock::now();
+            const auto files = engine.scan_media_files(cfg.input_dir);
+            const auto snap = engine.migrate(files, migrate_opts);
+            const auto t1 = std::chrono::steady_clock::now();
+
+            BenchRun run;
+            run.seconds = std::chrono::duration<double>(t1 - t0).count();
+            run.files = snap.completed + snap.failed;
+            run.bytes_in = snap.bytes_in;
+            run.bytes_out = snap.bytes_out;
+            run.peak_rss = peak_rss();
+            runs.push_back(run);
+
+            const auto one = summarize({ run });
+            logger->info("[BENCH] run {}/{}: {} files in {:.2f}s | {:.1f} files/s | {:.1f} MB/s | ratio {:.3f} | peak RSS {:.0f} MB",
+                i + 1, opts.runs, run.files, run.seconds, one.files_per_sec.mean, one.mb_per_sec.mean, one.ratio.mean, one.peak_rss_mb.mean);
+        }
+
+        std::error_code ec;
+        fs::remove_all(scratch, ec);
+
+        const auto s = summarize(runs);
+        const char* cache_name = cache == BenchCache::Warm ? "warm" : cache == BenchCache::Cold ? "cold" : "drop";
+        logger->info("=== BENCH SUMMARY ({} run(s), {} cache, {} threads) ===", s.runs, cache_name, cfg.threads);
+        logger->info("  Files/s   : {:.2f} +/- {:.2f}", s.files_per_sec.mean, s.files_per_sec.stddev);
+        logger->info("  MB/s in   : {:.2f} +/- {:.2f}", s.mb_per_sec.mean, s.mb_per_sec.stddev);
+        logger->info("  Ratio     : {:.4f} +/- {:.4f}", s.ratio.mean, s.ratio.stddev);
+        logger->info("  Peak RSS  : {:.0f} +/- {:.0f} MB", s.peak_rss_mb.mean, s.peak_rss_mb.stddev);
+        return s;
+    }
+
+} // namespace media_handler::compressor
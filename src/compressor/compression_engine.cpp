@@ -4,6 +4,12 @@
 #include "utils/retry_log.h"
 #include "utils/organizer.h"
 #include "utils/progress_tracker.h"
+#include "utils/metrics_exporter.h"
+#include "utils/perf_counters.h"
+#include "utils/lock_stats.h"
+#include "utils/run_report.h"
+#include "utils/event_log.h"
+#include "utils/control_server.h"
 #include "utils/utils.h"
 #include <algorithm>
 #include <format>
@@ -13,17 +19,28 @@
 #include <mutex>
 #include <condition_variable>
 #include <atomic>
+#include <optional>
+#include <charconv>
+#include <nlohmann/json.hpp>
 
 namespace media_handler::compressor {
 
     namespace fs = std::filesystem;
     using namespace media_handler::utils;
 
-    CompressionEngine::CompressionEngine(const Config& cfg)
+    /// @brief Lowercase extension including the dot (".jpg").
+    static std::string lower_ext(const fs::path& p) {
+        auto ext = p.extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return std::tolower(c); });
+        return ext;
+    }
+
+    CompressionEngine::CompressionEngine(const Config& cfg, Processors processors)
         : config(cfg)
         , logger(cfg.json_log
             ? Logger::create_json("Engine", cfg.log_level)
-            : Logger::create("Engine", cfg.log_level)) {}
+            : Logger::create("Engine", cfg.log_level))
+        , processors(std::move(processors)) {}
 
     bool CompressionEngine::is_supported(const fs::path& p) const {
         auto ext = p.extension().string();
@@ -57,34 +74,36 @@ namespace media_handler::compressor {
         return files;
     }
 
-    void CompressionEngine::migrate(const std::vector<fs::path>& files, const MigrateOptions& opts) {
+    ProgressTracker::Snapshot CompressionEngine::migrate(const std::vector<fs::path>& files, const MigrateOptions& opts) {
 
-        if (files.empty()) { logger->info("No files to process"); return; }
+        if (files.empty()) { logger->info("No files to process"); return {}; }
 
         // Organize-only mode: move files into output_dir/<YYYY>/ with no compression.
         if (opts.organize && !opts.retry) {
             Organizer organizer(logger);
             for (const auto& file : files) {
                 auto result = organizer.organize(file, config.output_dir);
+                static LogSite site(20, 2.0);
                 if (!result.success)
-                    logger->warn("Organize failed for {}: {}", path_to_utf8(file.filename()), result.error);
+                    if (auto held = site.allow())
+                        logger->warn("Organize failed for {}: {}{}", path_to_utf8(file.filename()), result.error, LogSite::note(*held));
             }
             logger->info("Organize complete");
-            return;
+            return {};
         }
 
         // Load state from prior run.
         // Normal run: skip completed files (resume after crash).
         // Retry run: process only files marked failed in prior run.
         RetryLog retry_log(config.output_dir, logger);
-        retry_log.load();
+        if (!opts.ignore_state) retry_log.load();
 
         std::vector<fs::path> work_files;
         work_files.reserve(files.size());
         std::size_t pre_skipped = 0;
 
         if (opts.retry) {
-            if (retry_log.failed_count() == 0) { logger->info("Retry: no failed files recorded"); return; }
+            if (retry_log.failed_count() == 0) { logger->info("Retry: no failed files recorded"); return {}; }
             for (const auto& f : files)
                 if (retry_log.is_failed(f)) work_files.push_back(f);
             logger->info("Retry: {} file(s)", work_files.size());
@@ -101,7 +120,7 @@ namespace media_handler::compressor {
             if (pre_skipped > 0) logger->info("Resuming: {} already done", pre_skipped);
         }
 
-        if (work_files.empty()) { logger->info("Nothing to do"); return; }
+        if (work_files.empty()) { logger->info("Nothing to do"); return {}; }
 
         unsigned int num_threads = config.threads;
         if (num_threads == 0) num_threads = std::thread::hardware_concurrency();
@@ -109,7 +128,31 @@ namespace media_handler::compressor {
 
         logger->info("Starting migration of {} files using {} threads", work_files.size(), num_threads);
 
+        if (config.perf_counters) PerfCounters::enable(logger); // Falls back to wall time only if not permitted.
+
         ProgressTracker tracker(work_files.size(), logger);
+        tracker.set_workers(num_threads);
+
+        std::unique_ptr<RunReport> report;
+        if (!config.report_file.empty()) {
+            auto opened = RunReport::open(config.report_file);
+            if (opened) {
+                report = std::move(*opened);
+                tracker.set_report(report.get());
+            }
+            else {
+                logger->error("{} - continuing without a run report", opened.error());
+            }
+        }
+
+        const bool event_log = !config.event_log.empty() && EventLog::start(config.event_log, logger);
+
+        // Byte-weighted progress: a 2GB video must count for more than a 2MB photo.
+        for (const auto& f : work_files) {
+            std::error_code ec;
+            auto size = fs::file_size(f, ec);
+            if (!ec) tracker.add_planned(kind_of(lower_ext(f)), size);
+        }
 
         // Mark skipped files explicitly in the tracker so counts are correct.
         for (const auto& f : files) {
@@ -123,18 +166,130 @@ namespace media_handler::compressor {
         // Queue is fully populated before workers start.
         std::queue<fs::path> work;
         for (const auto& f : work_files) work.push(f);
+        tracker.set_queue_depth(work.size());
+
+        // Declared after the tracker so it stops (and writes its final snapshot) first.
+        std::optional<MetricsExporter> exporter;
+        if (!config.metrics_file.empty()) {
+            exporter.emplace(tracker, config.metrics_file, std::chrono::seconds(config.metrics_interval), logger);
+            logger->info("Writing metrics to {} every {}s", config.metrics_file, config.metrics_interval);
+        }
+
+        // Periodic progress line; per-file lines are debug-level.
+        std::jthread heartbeat;
+        if (config.heartbeat_interval > 0) {
+            heartbeat = std::jthread([&tracker, interval = std::chrono::seconds(config.heartbeat_interval)](std::stop_token st) {
+                std::mutex m;
+                std::condition_variable_any wake;
+                std::unique_lock lock(m);
+                while (!wake.wait_for(lock, st, interval, [&st] { return st.stop_requested(); }))
+                    tracker.log_heartbeat();
+                });
+        }
 
-        std::mutex queue_mutex; // Protects the work queue and 'done' flag.
-        std::condition_variable cv; // Workers sleep here until work is available.
+        InstrumentedMutex queue_mutex{ "queue" }; // Protects the work queue, 'done' and the dispatch gate below.
+        std::condition_variable_any cv; // Workers sleep here until work is available.
         bool done = false; // Set by main thread once no more files will be added.
-        std::mutex state_mutex; // Serializes RetryLog and Organizer calls.
+        InstrumentedMutex state_mutex{ "state" }; // Serializes RetryLog and Organizer calls.
+
+        // Dispatch gate, adjusted at runtime through the control socket. In-flight files always run to completion.
+        bool paused = false; // No new file is started while set.
+        std::size_t active_limit = num_threads; // Workers allowed to hold a file at once (<= pool size).
+        std::size_t active = 0; // Workers holding a file.
+
+        // Once the queue is empty, cores of workers without a file can go to the files still running
+        // (e.g. parallel JPEG strip encoding). Call with queue_mutex held.
+        auto publish_idle = [&work, &paused, &active_limit, &active] {
+            IdleWorkers::set(work.empty() && !paused && active < active_limit ? active_limit - active : 0);
+            };
 
         std::latch finished(static_cast<std::ptrdiff_t>(num_threads));
 
-        ImageProcessor image_proc(config, logger);
-        VideoProcessor video_proc(config, logger);
+        auto image_proc = processors.image ? processors.image : std::make_shared<ImageProcessor>(config, logger);
+        auto video_proc = processors.video ? processors.video : std::make_shared<VideoProcessor>(config, logger);
+
+        // Record the outcome and persist state; the full commit (lock wait + save) feeds the state-commit histogram.
+        auto commit_state = [&retry_log, &state_mutex, &tracker, &opts](const fs::path& file, bool ok) {
+            const auto t0 = std::chrono::steady_clock::now();
+            std::lock_guard lock(state_mutex);
+            if (ok) retry_log.mark_completed(file);
+            else retry_log.mark_failed(file);
+            if (!opts.ignore_state) retry_log.save();
+            tracker.record_state_commit(std::chrono::steady_clock::now() - t0);
+            };
+
+        // Live control: status, pause/resume, worker count and state flush, one command line per connection.
+        auto control_command = [&](std::string_view command) -> std::string {
+            nlohmann::json r;
+            const auto space = command.find(' ');
+            const auto verb = command.substr(0, space);
+            const auto arg = space == std::string_view::npos ? std::string_view() : command.substr(space + 1);
+
+            if (verb == "status") {
+                const auto p = tracker.progress(32);
+                const auto snap = tracker.snapshot();
+                r = { {"ok", true}, {"total", p.total}, {"done", p.files_done}, {"completed", snap.completed},
+                    {"failed", snap.failed}, {"skipped", snap.skipped}, {"passthrough", snap.passthrough}, {"bytes_done", p.bytes_done}, {"bytes_planned", p.bytes_planned},
+                    {"percent", p.percent}, {"mb_per_s", p.mb_per_s}, {"eta_s", p.eta ? nlohmann::json(p.eta->count()) : nlohmann::json()},
+                    {"in_flight_count", p.in_flight_count}, {"in_flight", nlohmann::json::array()} };
+                for (const auto& [name, running] : p.in_flight)
+                    r["in_flight"].push_back({ {"file", name}, {"seconds", running.count()} });
+                std::lock_guard lock(queue_mutex);
+                r["paused"] = paused;
+                r["workers"] = active_limit;
+                r["pool"] = num_threads;
+                r["active"] = active;
+                r["queued"] = work.size();
+            }
+            else if (verb == "pause" || verb == "resume") {
+                {
+                    std::lock_guard lock(queue_mutex);
+                    paused = verb == "pause";
+                    publish_idle();
+                }
+                cv.notify_all();
+                logger->info("Control: dispatch {}", verb == "pause" ? "paused" : "resumed");
+                r = { {"ok", true}, {"paused", verb == "pause"} };
+            }
+            else if (verb == "workers") {
+                std::size_t n = 0;
+                const auto [end, ec] = std::from_chars(arg.data(), arg.data() + arg.size(), n);
+                if (ec != std::errc() || end != arg.data() + arg.size() || n == 0 || n > num_threads)
+                    return nlohmann::json{ {"ok", false}, {"error", std::format("workers takes a count from 1 to {} (the pool size)", num_threads)} }.dump();
+                {
+                    std::lock_guard lock(queue_mutex);
+                    active_limit = n;
+                    publish_idle();
+                }
+                cv.notify_all();
+                tracker.set_workers(n); // ETA follows the active count.
+                logger->info("Control: active workers set to {} of {}", n, num_threads);
+                r = { {"ok", true}, {"workers", n} };
+            }
+            else if (verb == "flush") {
+                if (!opts.ignore_state) {
+                    std::lock_guard lock(state_mutex);
+                    retry_log.save();
+                }
+                if (exporter) exporter->write();
+                Logger::flush_all();
+                r = { {"ok", true} };
+            }
+            else {
+                r = { {"ok", false}, {"error", "unknown command; use status, pause, resume, workers <n> or flush"} };
+            }
+            return r.dump();
+            };
+
+        // Destroyed before everything the handler touches.
+        std::unique_ptr<ControlServer> control;
+        if (!config.control_socket.empty()) {
+            auto started = ControlServer::start(config.control_socket, control_command, logger);
+            if (started) control = std::move(*started);
+            else logger->error("{} - continuing without a control socket", started.error());
+        }
 
-        auto worker = [this, &work, &queue_mutex, &cv, &done, &finished, &image_proc, &video_proc, &retry_log, &state_mutex, &tracker, &opts]()
+        auto worker = [this, &work, &queue_mutex, &cv, &done, &paused, &active_limit, &active, &publish_idle, &finished, &image_proc, &video_proc, &commit_state, &tracker, &opts]()
             {
                 //Wrap the whole loop in a try/catch so OS exceptions can't terminate threads
                 try {
@@ -142,14 +297,40 @@ namespace media_handler::compressor {
                         fs::path file;
 
                         {
-                            std::unique_lock<std::mutex> lock(queue_mutex);
-                            cv.wait(lock, [&] { return !work.empty() || done; });
-                            if (done && work.empty()) break;
+                            std::unique_lock lock(queue_mutex);
+                            cv.wait(lock, [&] { return work.empty() ? done : !paused && active < active_limit; });
+                            if (work.empty()) break;
                             file = std::move(work.front());
                             work.pop();
+                            ++active;
+                            publish_idle();
+                            tracker.set_queue_depth(work.size());
+                            if (work.empty()) cv.notify_all(); // Workers held back by the gate can exit now.
                         }
 
+                        // Hand the dispatch slot back however this file ends (continue, exception).
+                        struct Slot {
+                            InstrumentedMutex& m;
+                            std::condition_variable_any& cv;
+                            std::size_t& active;
+                            const decltype(publish_idle)& publish;
+                            ~Slot() {
+                                { std::lock_guard lock(m); --active; publish(); }
+                                cv.notify_one();
+                            }
+                        } slot{ queue_mutex, cv, active, publish_idle };
+
+                        ProgressTracker::WorkerScope busy(tracker);
+
+                        // Hoisted so the handlers below can close a file that threw mid-compress.
+                        std::size_t token = 0;
+                        bool open = false;
+                        fs::path output;
+
                         try {
+                            const auto ext = lower_ext(file);
+                            const auto kind = kind_of(ext);
+
                             fs::path relative;
                             try {
                                 relative = fs::relative(file, config.input_dir);
@@ -158,7 +339,7 @@ namespace media_handler::compressor {
                                 relative = file.filename();
                             }
 
-                            fs::path output = config.output_dir / relative;
+                            output = config.output_dir / relative;
                             try {
                                 if (!fs::exists(output.parent_path())) {
                                     fs::create_directories(output.parent_path());
@@ -166,59 +347,52 @@ namespace media_handler::compressor {
                             }
                             catch (const std::exception& e) {
                                 logger->error("[THREAD] Filesystem error creating directories for {}: {}", path_to_utf8(output.parent_path()), e.what());
-                                std::lock_guard lock(state_mutex);
-                                retry_log.mark_failed(file);
-                                retry_log.save();
-                                tracker.finish_file(tracker.begin_file(file), output, false, "mkdir failed");
+                                tracker.finish_file(tracker.begin_file(file, kind), output, false, "mkdir failed");
+                                commit_state(file, false);
                                 continue;
                             }
 
-                            logger->info("[THREAD] Processing: {}", path_to_utf8(relative));
+                            logger->debug("[THREAD] Processing: {}", path_to_utf8(relative));
 
                             if (fs::exists(output) && fs::is_regular_file(output) && fs::is_regular_file(file)) {
                                 const auto src_size = fs::file_size(file);
                                 const auto dst_size = fs::file_size(output);
 
                                 if (dst_size < src_size) {
-                                    logger->info("[THREAD] Skipping (already compressed): {} ({} < {})", path_to_utf8(relative), dst_size, src_size);
-                                    tracker.finish_file(tracker.begin_file(file), output, true, "skipped (already compressed)");
+                                    logger->debug("[THREAD] Skipping (already compressed): {} ({} < {})", path_to_utf8(relative), dst_size, src_size);
+                                    tracker.finish_file(tracker.begin_file(file, kind), output, true, "skipped (already compressed)");
                                     continue;
                                 }
 
-                                logger->info("[THREAD] Overwriting (destination larger/equal): {}", path_to_utf8(relative));
+                                logger->debug("[THREAD] Overwriting (destination larger/equal): {}", path_to_utf8(relative));
                             }
 
-                            auto token = tracker.begin_file(file);
-
-                            auto ext = file.extension().string();
-                            std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return std::tolower(c); });
+                            token = tracker.begin_file(file, kind);
+                            open = true;
 
                             ProcessResult res;
                             if (ext_matches(video_exts, ext))
-                                res = video_proc.compress(file, output);
+                                res = video_proc->compress(file, output);
                             else
-                                res = image_proc.compress(file, output);
+                                res = image_proc->compress(file, output);
 
-                            tracker.finish_file(token, output, res.success, res.message);
-
-                            {
-                                std::lock_guard lock(state_mutex);
-                                if (res.success) retry_log.mark_completed(file);
-                                else retry_log.mark_failed(file);
-                                retry_log.save();
-                            }
+                            open = false;
+                            tracker.finish_file(token, output, res.success, res.message, res.passthrough);
+                            commit_state(file, res.success);
                         }
                         catch (const std::exception& e) {
-                            logger->error("[THREAD] Exception on {}: {}", path_to_utf8(file), e.what());
-                            std::lock_guard lock(state_mutex);
-                            retry_log.mark_failed(file);
-                            retry_log.save();
+                            static LogSite site(20, 2.0);
+                            if (auto held = site.allow())
+                                logger->error("[THREAD] Exception on {}: {}{}", path_to_utf8(file), e.what(), LogSite::note(*held));
+                            if (open) tracker.finish_file(token, output, false, e.what());
+                            commit_state(file, false);
                         }
                         catch (...) {
-                            logger->error("[THREAD] Unknown exception on {}", path_to_utf8(file));
-                            std::lock_guard lock(state_mutex);
-                            retry_log.mark_failed(file);
-                            retry_log.save();
+                            static LogSite site(20, 2.0);
+                            if (auto held = site.allow())
+                                logger->error("[THREAD] Unknown exception on {}{}", path_to_utf8(file), LogSite::note(*held));
+                            if (open) tracker.finish_file(token, output, false, "unknown exception");
+                            commit_state(file, false);
                         }
                     }
                 }
@@ -246,19 +420,37 @@ namespace media_handler::compressor {
         }
 
         {
-            std::lock_guard<std::mutex> lock(queue_mutex);
+            std::lock_guard lock(queue_mutex);
             done = true;
         }
         cv.notify_all();
 
         finished.wait();
+        control.reset();
+        IdleWorkers::set(0);
+
+        if (heartbeat.joinable()) {
+            heartbeat.request_stop();
+            heartbeat.join();
+        }
 
         tracker.print_summary();
 
+        if (event_log) {
+            EventLog::stop();
+            logger->info("Event log: {} record(s) written, {} dropped", EventLog::written(), EventLog::dropped());
+        }
+
+        if (report) {
+            report->write_summary(tracker.snapshot());
+            logger->info("Run report written to {}", config.report_file);
+        }
+
         if (retry_log.failed_count() > 0)
             logger->warn("{} file(s) failed — run with --retry", retry_log.failed_count());
 
         logger->info("Migration complete");
+        return tracker.snapshot();
     }
 
 } // namespace media_handler::compressor
\ No newline at end of file
@@ -0,0 +1,79 @@
+#include "compressor/dct_requantize.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MH_REQUANT_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define MH_REQUANT_NEON 1
+#endif
+
+namespace media_handler::compressor {
+
+    RequantTable make_requant_table(const std::uint16_t* source_steps, const std::uint16_t* target_steps) {
+        RequantTable t;
+        for (std::size_t k = 0; k < DCT_BLOCK; ++k)
+            t.scale[k] = static_cast<float>(source_steps[k]) / static_cast<float>(std::max<std::uint16_t>(target_steps[k], 1));
+        return t;
+    }
+
+    // All kernels multiply in single precision and round to nearest-even, then saturate to 16 bits,
+    // so every path produces the same coefficients.
+
+    void requantize_blocks_scalar(std::int16_t* coefficients, std::size_t blocks, const RequantTable& table) {
+        for (std::size_t b = 0; b < blocks; ++b, coefficients += DCT_BLOCK) {
+            for (std::size_t k = 0; k < DCT_BLOCK; ++k) {
+                const float v = std::nearbyint(static_cast<float>(coefficients[k]) * table.scale[k]);
+                coefficients[k] = static_cast<std::int16_t>(std::clamp(v, -32768.0f, 32767.0f));
+            }
+        }
+    }
+
+#if defined(MH_REQUANT_SSE2)
+
+    void requantize_blocks(std::int16_t* coefficients, std::size_t blocks, const RequantTable& table) {
+        for (std::size_t b = 0; b < blocks; ++b, coefficients += DCT_BLOCK) {
+            for (std::size_t k = 0; k < DCT_BLOCK; k += 8) {
+                auto* p = reinterpret_cast<__m128i*>(coefficients + k);
+                const __m128i c = _mm_loadu_si128(p);
+                // Sign-extend 8 x int16 into two 4 x int32 halves.
+                const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(c, c), 16);
+                const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(c, c), 16);
+                const __m128 flo = _mm_mul_ps(_mm_cvtepi32_ps(lo), _mm_load_ps(table.scale + k));
+                const __m128 fhi = _mm_mul_ps(_mm_cvtepi32_ps(hi), _mm_load_ps(table.scale + k + 4));
+                // cvtps rounds to nearest-even under the default MXCSR; packs saturates like the scalar clamp.
+                _mm_storeu_si128(p, _mm_packs_epi32(_mm_cvtps_epi32(flo), _mm_cvtps_epi32(fhi)));
+            }
+        }
+    }
+
+    const char* requantize_kernel() { return "sse2"; }
+
+#elif defined(MH_REQUANT_NEON)
+
+    void requantize_blocks(std::int16_t* coefficients, std::size_t blocks, const RequantTable& table) {
+        for (std::size_t b = 0; b < blocks; ++b, coefficients += DCT_BLOCK) {
+            for (std::size_t k = 0; k < DCT_BLOCK; k += 8) {
+                const int16x8_t c = vld1q_s16(coefficients + k);
+                const float32x4_t flo = vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(c))), vld1q_f32(table.scale + k));
+                const float32x4_t fhi = vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(c))), vld1q_f32(table.scale + k + 4));
+                vst1q_s16(coefficients + k, vcombine_s16(vqmovn_s32(vcvtnq_s32_f32(flo)), vqmovn_s32(vcvtnq_s32_f32(fhi))));
+            }
+        }
+    }
+
+    const char* requantize_kernel() { return "neon"; }
+
+#else
+
+    void requantize_blocks(std::int16_t* coefficients, std::size_t blocks, const RequantTable& table) {
+        requantize_blocks_scalar(coefficients, blocks, table);
+    }
+
+    const char* requantize_kernel() { return "scalar"; }
+
+#endif
+
+} // namespace media_handler::compressor
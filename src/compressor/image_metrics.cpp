@@ -0,0 +1,508 @@
+#include "compressor/image_metrics.h"
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#include <immintrin.h>
+#define MH_SSIM_X86 1
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define MH_TARGET(isa) // MSVC compiles every intrinsic without per-function flags.
+#else
+#define MH_TARGET(isa) __attribute__((target(isa)))
+#endif
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define MH_SSIM_NEON 1
+#endif
+
+namespace media_handler::compressor {
+
+    namespace {
+        // SSIM stabilizers for 8-bit samples: (K1 * 255)^2 and (K2 * 255)^2 with K1 = 0.01, K2 = 0.03.
+        constexpr double C1 = (0.01 * 255) * (0.01 * 255);
+        constexpr double C2 = (0.03 * 255) * (0.03 * 255);
+
+        // The same constants scaled for a 64-sample window computed from raw sums: means carry a factor of 64
+        // on both sides of the luminance term, and sample (n - 1) variances a factor of 64 * 63.
+        constexpr float WINDOW_C1 = static_cast<float>(C1 * 64 * 64);
+        constexpr float WINDOW_C2 = static_cast<float>(C2 * 64 * 63);
+
+        // jccolor.c's fixed-point luma weights FIX(0.29900), FIX(0.58700), FIX(0.11400), with its rounding.
+        // For 16-bit multiply-add the green weight is split in two halves paired with red and with blue.
+        constexpr std::uint32_t LUMA_R = 19595, LUMA_G = 38470, LUMA_B = 7471, LUMA_HALF = 32768;
+        constexpr std::int16_t LUMA_G_HALF = LUMA_G / 2;
+
+        void luma_row_scalar(const std::uint8_t* in, std::uint8_t* out, unsigned first, unsigned width) {
+            for (unsigned x = first; x < width; ++x) {
+                const std::uint8_t* p = in + x * 3;
+                out[x] = static_cast<std::uint8_t>((LUMA_R * p[0] + LUMA_G * p[1] + LUMA_B * p[2] + LUMA_HALF) >> 16);
+            }
+        }
+
+        /// @brief Per-4x4-block sums of one block row, one array per quantity so kernels load them as vectors:
+        /// a, b, a^2 + b^2 and a * b. 4x4 blocks of 8-bit samples keep every sum well inside 32 bits.
+        struct SumRow {
+            std::uint32_t* a;
+            std::uint32_t* b;
+            std::uint32_t* squares;
+            std::uint32_t* cross;
+        };
+
+        void block_sums_scalar(const std::uint8_t* a, std::size_t a_stride, const std::uint8_t* b, std::size_t b_stride,
+            unsigned first, unsigned blocks, const SumRow& out) {
+            for (unsigned x = first; x < blocks; ++x) {
+                std::uint32_t sa = 0, sb = 0, squares = 0, cross = 0;
+                for (int y = 0; y < 4; ++y) {
+                    const std::uint8_t* pa = a + y * a_stride + x * 4;
+                    const std::uint8_t* pb = b + y * b_stride + x * 4;
+                    for (int i = 0; i < 4; ++i) {
+                        const std::uint32_t va = pa[i], vb = pb[i];
+                        sa += va;
+                        sb += vb;
+                        squares += va * va + vb * vb;
+                        cross += va * vb;
+                    }
+                }
+                out.a[x] = sa;
+                out.b[x] = sb;
+                out.squares[x] = squares;
+                out.cross[x] = cross;
+            }
+        }
+
+        /// @brief SSIM of the 8x8 window whose four 4x4 blocks sum to these totals. The variance terms are
+        /// exact in 32-bit integers; only the final ratio is floating point, in the order the SIMD kernels use.
+        float window_ssim(std::uint32_t sa, std::uint32_t sb, std::uint32_t squares, std::uint32_t cross) {
+            const auto s1 = static_cast<std::int32_t>(sa), s2 = static_cast<std::int32_t>(sb);
+            const std::int32_t s1s2 = s1 * s2;
+            const std::int32_t sq = s1 * s1 + s2 * s2;
+            const std::int32_t vars = static_cast<std::int32_t>(squares) * 64 - sq;
+            const std::int32_t covar = static_cast<std::int32_t>(cross) * 64 - s1s2;
+            return (static_cast<float>(s1s2 * 2) + WINDOW_C1) * (static_cast<float>(covar * 2) + WINDOW_C2)
+                / ((static_cast<float>(sq) + WINDOW_C1) * (static_cast<float>(vars) + WINDOW_C2));
+        }
+
+        double window_row_scalar(const SumRow& above, const SumRow& current, unsigned first, unsigned windows) {
+            double total = 0;
+            for (unsigned x = first; x < windows; ++x) {
+                total += window_ssim(above.a[x] + above.a[x + 1] + current.a[x] + current.a[x + 1],
+                    above.b[x] + above.b[x + 1] + current.b[x] + current.b[x + 1],
+                    above.squares[x] + above.squares[x + 1] + current.squares[x] + current.squares[x + 1],
+                    above.cross[x] + above.cross[x + 1] + current.cross[x] + current.cross[x + 1]);
+            }
+            return total;
+        }
+
+#if defined(MH_SSIM_X86)
+
+        // SSE4.1 luma: four pixels per 16-byte load, shuffled into R G and G B word pairs for madd.
+        // The loads read 4 bytes past the pixels they use, so the vector loop stops short of the row end.
+        MH_TARGET("sse4.1") __m128i luma4_sse41(const std::uint8_t* in) {
+            const __m128i rg = _mm_setr_epi8(0, -1, 1, -1, 3, -1, 4, -1, 6, -1, 7, -1, 9, -1, 10, -1);
+            const __m128i gb = _mm_setr_epi8(1, -1, 2, -1, 4, -1, 5, -1, 7, -1, 8, -1, 10, -1, 11, -1);
+            const __m128i rg_weights = _mm_setr_epi16(LUMA_R, LUMA_G_HALF, LUMA_R, LUMA_G_HALF, LUMA_R, LUMA_G_HALF, LUMA_R, LUMA_G_HALF);
+            const __m128i gb_weights = _mm_setr_epi16(LUMA_G_HALF, LUMA_B, LUMA_G_HALF, LUMA_B, LUMA_G_HALF, LUMA_B, LUMA_G_HALF, LUMA_B);
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+            const __m128i sum = _mm_add_epi32(_mm_madd_epi16(_mm_shuffle_epi8(v, rg), rg_weights), _mm_madd_epi16(_mm_shuffle_epi8(v, gb), gb_weights));
+            return _mm_srli_epi32(_mm_add_epi32(sum, _mm_set1_epi32(LUMA_HALF)), 16);
+        }
+
+        MH_TARGET("sse4.1") void luma_row_sse41(const std::uint8_t* in, std::uint8_t* out, unsigned width) {
+            unsigned x = 0;
+            for (; x + 18 <= width; x += 16) {
+                const __m128i low = _mm_packus_epi32(luma4_sse41(in + x * 3), luma4_sse41(in + (x + 4) * 3));
+                const __m128i high = _mm_packus_epi32(luma4_sse41(in + (x + 8) * 3), luma4_sse41(in + (x + 12) * 3));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), _mm_packus_epi16(low, high));
+            }
+            luma_row_scalar(in, out, x, width);
+        }
+
+        // SSE4.1: four blocks (16 samples) per step. maddubs against ones gives pair sums, madd the quads;
+        // squares and products come from madd on widened samples, as pixel-pair sums joined by hadd.
+        MH_TARGET("sse4.1") void block_sums_sse41(const std::uint8_t* a, std::size_t a_stride, const std::uint8_t* b,
+            std::size_t b_stride, unsigned blocks, const SumRow& out) {
+            const __m128i ones8 = _mm_set1_epi8(1), ones16 = _mm_set1_epi16(1);
+            unsigned x = 0;
+            for (; x + 4 <= blocks; x += 4) {
+                __m128i pa = _mm_setzero_si128(), pb = _mm_setzero_si128();
+                __m128i sq_lo = _mm_setzero_si128(), sq_hi = _mm_setzero_si128();
+                __m128i cr_lo = _mm_setzero_si128(), cr_hi = _mm_setzero_si128();
+                for (int y = 0; y < 4; ++y) {
+                    const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + y * a_stride + x * 4));
+                    const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + y * b_stride + x * 4));
+                    pa = _mm_add_epi16(pa, _mm_maddubs_epi16(va, ones8));
+                    pb = _mm_add_epi16(pb, _mm_maddubs_epi16(vb, ones8));
+                    const __m128i a_lo = _mm_cvtepu8_epi16(va), a_hi = _mm_cvtepu8_epi16(_mm_srli_si128(va, 8));
+                    const __m128i b_lo = _mm_cvtepu8_epi16(vb), b_hi = _mm_cvtepu8_epi16(_mm_srli_si128(vb, 8));
+                    sq_lo = _mm_add_epi32(sq_lo, _mm_add_epi32(_mm_madd_epi16(a_lo, a_lo), _mm_madd_epi16(b_lo, b_lo)));
+                    sq_hi = _mm_add_epi32(sq_hi, _mm_add_epi32(_mm_madd_epi16(a_hi, a_hi), _mm_madd_epi16(b_hi, b_hi)));
+                    cr_lo = _mm_add_epi32(cr_lo, _mm_madd_epi16(a_lo, b_lo));
+                    cr_hi = _mm_add_epi32(cr_hi, _mm_madd_epi16(a_hi, b_hi));
+                }
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out.a + x), _mm_madd_epi16(pa, ones16));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out.b + x), _mm_madd_epi16(pb, ones16));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out.squares + x), _mm_hadd_epi32(sq_lo, sq_hi));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out.cross + x), _mm_hadd_epi32(cr_lo, cr_hi));
+            }
+            block_sums_scalar(a, a_stride, b, b_stride, x, blocks, out);
+        }
+
+        MH_TARGET("sse4.1") __m128i window_sum_sse41(const std::uint32_t* above, const std::uint32_t* current, unsigned x) {
+            const __m128i* a = reinterpret_cast<const __m128i*>(above + x);
+            const __m128i* a1 = reinterpret_cast<const __m128i*>(above + x + 1);
+            const __m128i* c = reinterpret_cast<const __m128i*>(current + x);
+            const __m128i* c1 = reinterpret_cast<const __m128i*>(current + x + 1);
+            return _mm_add_epi32(_mm_add_epi32(_mm_loadu_si128(a), _mm_loadu_si128(a1)), _mm_add_epi32(_mm_loadu_si128(c), _mm_loadu_si128(c1)));
+        }
+
+        MH_TARGET("sse4.1") double window_row_sse41(const SumRow& above, const SumRow& current, unsigned windows) {
+            const __m128 c1 = _mm_set1_ps(WINDOW_C1), c2 = _mm_set1_ps(WINDOW_C2);
+            __m128 acc = _mm_setzero_ps();
+            unsigned x = 0;
+            for (; x + 4 <= windows; x += 4) {
+                const __m128i s1 = window_sum_sse41(above.a, current.a, x);
+                const __m128i s2 = window_sum_sse41(above.b, current.b, x);
+                const __m128i squares = window_sum_sse41(above.squares, current.squares, x);
+                const __m128i cross = window_sum_sse41(above.cross, current.cross, x);
+                const __m128i s1s2 = _mm_mullo_epi32(s1, s2);
+                const __m128i sq = _mm_add_epi32(_mm_mullo_epi32(s1, s1), _mm_mullo_epi32(s2, s2));
+                const __m128i vars = _mm_sub_epi32(_mm_slli_epi32(squares, 6), sq);
+                const __m128i covar = _mm_sub_epi32(_mm_slli_epi32(cross, 6), s1s2);
+                const __m128 num = _mm_mul_ps(_mm_add_ps(_mm_cvtepi32_ps(_mm_slli_epi32(s1s2, 1)), c1),
+                    _mm_add_ps(_mm_cvtepi32_ps(_mm_slli_epi32(covar, 1)), c2));
+                const __m128 den = _mm_mul_ps(_mm_add_ps(_mm_cvtepi32_ps(sq), c1), _mm_add_ps(_mm_cvtepi32_ps(vars), c2));
+                acc = _mm_add_ps(acc, _mm_div_ps(num, den));
+            }
+            alignas(16) float lanes[4];
+            _mm_store_ps(lanes, acc);
+            return (static_cast<double>(lanes[0]) + lanes[1]) + (static_cast<double>(lanes[2]) + lanes[3])
+                + window_row_scalar(above, current, x, windows);
+        }
+
+        // AVX2 luma: the SSE4.1 scheme on two groups of four pixels 16 apart, so the in-lane packs come out in order.
+        MH_TARGET("avx2") __m256i luma8_avx2(const std::uint8_t* in) {
+            const __m256i rg = _mm256_setr_epi8(0, -1, 1, -1, 3, -1, 4, -1, 6, -1, 7, -1, 9, -1, 10, -1,
+                0, -1, 1, -1, 3, -1, 4, -1, 6, -1, 7, -1, 9, -1, 10, -1);
+            const __m256i gb = _mm256_setr_epi8(1, -1, 2, -1, 4, -1, 5, -1, 7, -1, 8, -1, 10, -1, 11, -1,
+                1, -1, 2, -1, 4, -1, 5, -1, 7, -1, 8, -1, 10, -1, 11, -1);
+            const __m256i rg_weights = _mm256_set1_epi32(static_cast<int>(LUMA_R | (static_cast<std::uint32_t>(LUMA_G_HALF) << 16)));
+            const __m256i gb_weights = _mm256_set1_epi32(static_cast<int>(LUMA_G_HALF | (LUMA_B << 16)));
+            const __m256i v = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in))),
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 16 * 3)), 1);
+            const __m256i sum = _mm256_add_epi32(_mm256_madd_epi16(_mm256_shuffle_epi8(v, rg), rg_weights),
+                _mm256_madd_epi16(_mm256_shuffle_epi8(v, gb), gb_weights));
+            return _mm256_srli_epi32(_mm256_add_epi32(sum, _mm256_set1_epi32(LUMA_HALF)), 16);
+        }
+
+        MH_TARGET("avx2") void luma_row_avx2(const std::uint8_t* in, std::uint8_t* out, unsigned width) {
+            unsigned x = 0;
+            for (; x + 34 <= width; x += 32) {
+                const __m256i low = _mm256_packus_epi32(luma8_avx2(in + x * 3), luma8_avx2(in + (x + 4) * 3));
+                const __m256i high = _mm256_packus_epi32(luma8_avx2(in + (x + 8) * 3), luma8_avx2(in + (x + 12) * 3));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + x), _mm256_packus_epi16(low, high));
+            }
+            luma_row_scalar(in, out, x, width);
+        }
+
+        // AVX2: eight blocks (32 samples) per step. 256-bit hadd works within 128-bit lanes, leaving the
+        // blocks in 0 1 4 5 | 2 3 6 7 order; one 64-bit permute restores it.
+        MH_TARGET("avx2") void block_sums_avx2(const std::uint8_t* a, std::size_t a_stride, const std::uint8_t* b,
+            std::size_t b_stride, unsigned blocks, const SumRow& out) {
+            const __m256i ones8 = _mm256_set1_epi8(1), ones16 = _mm256_set1_epi16(1);
+            unsigned x = 0;
+            for (; x + 8 <= blocks; x += 8) {
+                __m256i pa = _mm256_setzero_si256(), pb = _mm256_setzero_si256();
+                __m256i sq_lo = _mm256_setzero_si256(), sq_hi = _mm256_setzero_si256();
+                __m256i cr_lo = _mm256_setzero_si256(), cr_hi = _mm256_setzero_si256();
+                for (int y = 0; y < 4; ++y) {
+                    const std::uint8_t* ra = a + y * a_stride + x * 4;
+                    const std::uint8_t* rb = b + y * b_stride + x * 4;
+                    pa = _mm256_add_epi16(pa, _mm256_maddubs_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(ra)), ones8));
+                    pb = _mm256_add_epi16(pb, _mm256_maddubs_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(rb)), ones8));
+                    const __m256i a_lo = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ra)));
+                    const __m256i a_hi = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ra + 16)));
+                    const __m256i b_lo = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(rb)));
+                    const __m256i b_hi = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(rb + 16)));
+                    sq_lo = _mm256_add_epi32(sq_lo, _mm256_add_epi32(_mm256_madd_epi16(a_lo, a_lo), _mm256_madd_epi16(b_lo, b_lo)));
+                    sq_hi = _mm256_add_epi32(sq_hi, _mm256_add_epi32(_mm256_madd_epi16(a_hi, a_hi), _mm256_madd_epi16(b_hi, b_hi)));
+                    cr_lo = _mm256_add_epi32(cr_lo, _mm256_madd_epi16(a_lo, b_lo));
+                    cr_hi = _mm256_add_epi32(cr_hi, _mm256_madd_epi16(a_hi, b_hi));
+                }
+                constexpr int ORDER = _MM_SHUFFLE(3, 1, 2, 0);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out.a + x), _mm256_madd_epi16(pa, ones16));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out.b + x), _mm256_madd_epi16(pb, ones16));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out.squares + x), _mm256_permute4x64_epi64(_mm256_hadd_epi32(sq_lo, sq_hi), ORDER));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out.cross + x), _mm256_permute4x64_epi64(_mm256_hadd_epi32(cr_lo, cr_hi), ORDER));
+            }
+            block_sums_scalar(a, a_stride, b, b_stride, x, blocks, out);
+        }
+
+        MH_TARGET("avx2") __m256i window_sum_avx2(const std::uint32_t* above, const std::uint32_t* current, unsigned x) {
+            const __m256i* a = reinterpret_cast<const __m256i*>(above + x);
+            const __m256i* a1 = reinterpret_cast<const __m256i*>(above + x + 1);
+            const __m256i* c = reinterpret_cast<const __m256i*>(current + x);
+            const __m256i* c1 = reinterpret_cast<const __m256i*>(current + x + 1);
+            return _mm256_add_epi32(_mm256_add_epi32(_mm256_loadu_si256(a), _mm256_loadu_si256(a1)), _mm256_add_epi32(_mm256_loadu_si256(c), _mm256_loadu_si256(c1)));
+        }
+
+        MH_TARGET("avx2") double window_row_avx2(const SumRow& above, const SumRow& current, unsigned windows) {
+            const __m256 c1 = _mm256_set1_ps(WINDOW_C1), c2 = _mm256_set1_ps(WINDOW_C2);
+            __m256 acc = _mm256_setzero_ps();
+            unsigned x = 0;
+            for (; x + 8 <= windows; x += 8) {
+                const __m256i s1 = window_sum_avx2(above.a, current.a, x);
+                const __m256i s2 = window_sum_avx2(above.b, current.b, x);
+                const __m256i squares = window_sum_avx2(above.squares, current.squares, x);
+                const __m256i cross = window_sum_avx2(above.cross, current.cross, x);
+                const __m256i s1s2 = _mm256_mullo_epi32(s1, s2);
+                const __m256i sq = _mm256_add_epi32(_mm256_mullo_epi32(s1, s1), _mm256_mullo_epi32(s2, s2));
+                const __m256i vars = _mm256_sub_epi32(_mm256_slli_epi32(squares, 6), sq);
+                const __m256i covar = _mm256_sub_epi32(_mm256_slli_epi32(cross, 6), s1s2);
+                const __m256 num = _mm256_mul_ps(_mm256_add_ps(_mm256_cvtepi32_ps(_mm256_slli_epi32(s1s2, 1)), c1),
+                    _mm256_add_ps(_mm256_cvtepi32_ps(_mm256_slli_epi32(covar, 1)), c2));
+                const __m256 den = _mm256_mul_ps(_mm256_add_ps(_mm256_cvtepi32_ps(sq), c1), _mm256_add_ps(_mm256_cvtepi32_ps(vars), c2));
+                acc = _mm256_add_ps(acc, _mm256_div_ps(num, den));
+            }
+            alignas(32) float lanes[8];
+            _mm256_store_ps(lanes, acc);
+            double total = 0;
+            for (float lane : lanes) total += lane;
+            return total + window_row_scalar(above, current, x, windows);
+        }
+
+        bool cpu_has(SsimKernel kernel) {
+#if defined(_MSC_VER) && !defined(__clang__)
+            int r[4];
+            __cpuid(r, 0);
+            const int leaves = r[0];
+            __cpuid(r, 1);
+            if (kernel == SsimKernel::Sse41) return (r[2] & (1 << 19)) != 0;
+            // AVX2 also needs the OS to save YMM state (OSXSAVE, then XCR0 bits 1 and 2).
+            if (leaves < 7 || !(r[2] & (1 << 27)) || !(r[2] & (1 << 28)) || (_xgetbv(0) & 6) != 6) return false;
+            __cpuidex(r, 7, 0);
+            return (r[1] & (1 << 5)) != 0;
+#else
+            return kernel == SsimKernel::Sse41 ? __builtin_cpu_supports("sse4.1") : __builtin_cpu_supports("avx2");
+#endif
+        }
+
+#elif defined(MH_SSIM_NEON)
+
+        uint16x4_t luma4_neon(uint16x4_t r, uint16x4_t g, uint16x4_t b) {
+            const uint32x4_t sum = vmlal_n_u16(vmlal_n_u16(vmlal_n_u16(vdupq_n_u32(LUMA_HALF), r, LUMA_R), g, LUMA_G), b, LUMA_B);
+            return vshrn_n_u32(sum, 16);
+        }
+
+        uint8x8_t luma8_neon(uint8x8_t r, uint8x8_t g, uint8x8_t b) {
+            const uint16x8_t r16 = vmovl_u8(r), g16 = vmovl_u8(g), b16 = vmovl_u8(b);
+            return vmovn_u16(vcombine_u16(luma4_neon(vget_low_u16(r16), vget_low_u16(g16), vget_low_u16(b16)),
+                luma4_neon(vget_high_u16(r16), vget_high_u16(g16), vget_high_u16(b16))));
+        }
+
+        // NEON luma: vld3 deinterleaves 16 pixels into R, G and B.
+        void luma_row_neon(const std::uint8_t* in, std::uint8_t* out, unsigned width) {
+            unsigned x = 0;
+            for (; x + 16 <= width; x += 16) {
+                const uint8x16x3_t px = vld3q_u8(in + x * 3);
+                vst1q_u8(out + x, vcombine_u8(luma8_neon(vget_low_u8(px.val[0]), vget_low_u8(px.val[1]), vget_low_u8(px.val[2])),
+                    luma8_neon(vget_high_u8(px.val[0]), vget_high_u8(px.val[1]), vget_high_u8(px.val[2]))));
+            }
+            luma_row_scalar(in, out, x, width);
+        }
+
+        // NEON: four blocks (16 samples) per step; pairwise add-accumulate widens as it sums.
+        void block_sums_neon(const std::uint8_t* a, std::size_t a_stride, const std::uint8_t* b, std::size_t b_stride,
+            unsigned blocks, const SumRow& out) {
+            unsigned x = 0;
+            for (; x + 4 <= blocks; x += 4) {
+                uint16x8_t pa = vdupq_n_u16(0), pb = vdupq_n_u16(0);
+                uint32x4_t sq_lo = vdupq_n_u32(0), sq_hi = vdupq_n_u32(0), cr_lo = vdupq_n_u32(0), cr_hi = vdupq_n_u32(0);
+                for (int y = 0; y < 4; ++y) {
+                    const uint8x16_t va = vld1q_u8(a + y * a_stride + x * 4);
+                    const uint8x16_t vb = vld1q_u8(b + y * b_stride + x * 4);
+                    pa = vpadalq_u8(pa, va);
+                    pb = vpadalq_u8(pb, vb);
+                    sq_lo = vpadalq_u16(vpadalq_u16(sq_lo, vmull_u8(vget_low_u8(va), vget_low_u8(va))), vmull_u8(vget_low_u8(vb), vget_low_u8(vb)));
+                    sq_hi = vpadalq_u16(vpadalq_u16(sq_hi, vmull_high_u8(va, va)), vmull_high_u8(vb, vb));
+                    cr_lo = vpadalq_u16(cr_lo, vmull_u8(vget_low_u8(va), vget_low_u8(vb)));
+                    cr_hi = vpadalq_u16(cr_hi, vmull_high_u8(va, vb));
+                }
+                vst1q_u32(out.a + x, vpaddlq_u16(pa));
+                vst1q_u32(out.b + x, vpaddlq_u16(pb));
+                vst1q_u32(out.squares + x, vpaddq_u32(sq_lo, sq_hi));
+                vst1q_u32(out.cross + x, vpaddq_u32(cr_lo, cr_hi));
+            }
+            block_sums_scalar(a, a_stride, b, b_stride, x, blocks, out);
+        }
+
+        int32x4_t window_sum_neon(const std::uint32_t* above, const std::uint32_t* current, unsigned x) {
+            return vreinterpretq_s32_u32(vaddq_u32(vaddq_u32(vld1q_u32(above + x), vld1q_u32(above + x + 1)),
+                vaddq_u32(vld1q_u32(current + x), vld1q_u32(current + x + 1))));
+        }
+
+        double window_row_neon(const SumRow& above, const SumRow& current, unsigned windows) {
+            const float32x4_t c1 = vdupq_n_f32(WINDOW_C1), c2 = vdupq_n_f32(WINDOW_C2);
+            float32x4_t acc = vdupq_n_f32(0.0f);
+            unsigned x = 0;
+            for (; x + 4 <= windows; x += 4) {
+                const int32x4_t s1 = window_sum_neon(above.a, current.a, x);
+                const int32x4_t s2 = window_sum_neon(above.b, current.b, x);
+                const int32x4_t squares = window_sum_neon(above.squares, current.squares, x);
+                const int32x4_t cross = window_sum_neon(above.cross, current.cross, x);
+                const int32x4_t s1s2 = vmulq_s32(s1, s2);
+                const int32x4_t sq = vaddq_s32(vmulq_s32(s1, s1), vmulq_s32(s2, s2));
+                const int32x4_t vars = vsubq_s32(vshlq_n_s32(squares, 6), sq);
+                const int32x4_t covar = vsubq_s32(vshlq_n_s32(cross, 6), s1s2);
+                const float32x4_t num = vmulq_f32(vaddq_f32(vcvtq_f32_s32(vshlq_n_s32(s1s2, 1)), c1),
+                    vaddq_f32(vcvtq_f32_s32(vshlq_n_s32(covar, 1)), c2));
+                const float32x4_t den = vmulq_f32(vaddq_f32(vcvtq_f32_s32(sq), c1), vaddq_f32(vcvtq_f32_s32(vars), c2));
+                acc = vaddq_f32(acc, vdivq_f32(num, den));
+            }
+            return static_cast<double>(vaddvq_f32(acc)) + window_row_scalar(above, current, x, windows);
+        }
+
+#endif
+
+        SsimKernel detect_kernel() {
+#if defined(MH_SSIM_X86)
+            if (cpu_has(SsimKernel::Avx2)) return SsimKernel::Avx2;
+            if (cpu_has(SsimKernel::Sse41)) return SsimKernel::Sse41;
+#elif defined(MH_SSIM_NEON)
+            return SsimKernel::Neon;
+#endif
+            return SsimKernel::Scalar;
+        }
+
+        void luma_row(SsimKernel kernel, const std::uint8_t* in, std::uint8_t* out, unsigned width) {
+            switch (kernel) {
+#if defined(MH_SSIM_X86)
+            case SsimKernel::Avx2: return luma_row_avx2(in, out, width);
+            case SsimKernel::Sse41: return luma_row_sse41(in, out, width);
+#elif defined(MH_SSIM_NEON)
+            case SsimKernel::Neon: return luma_row_neon(in, out, width);
+#endif
+            default: return luma_row_scalar(in, out, 0, width);
+            }
+        }
+
+        void block_sums(SsimKernel kernel, const std::uint8_t* a, std::size_t a_stride, const std::uint8_t* b,
+            std::size_t b_stride, unsigned blocks, const SumRow& out) {
+            switch (kernel) {
+#if defined(MH_SSIM_X86)
+            case SsimKernel::Avx2: return block_sums_avx2(a, a_stride, b, b_stride, blocks, out);
+            case SsimKernel::Sse41: return block_sums_sse41(a, a_stride, b, b_stride, blocks, out);
+#elif defined(MH_SSIM_NEON)
+            case SsimKernel::Neon: return block_sums_neon(a, a_stride, b, b_stride, blocks, out);
+#endif
+            default: return block_sums_scalar(a, a_stride, b, b_stride, 0, blocks, out);
+            }
+        }
+
+        double window_row(SsimKernel kernel, const SumRow& above, const SumRow& current, unsigned windows) {
+            switch (kernel) {
+#if defined(MH_SSIM_X86)
+            case SsimKernel::Avx2: return window_row_avx2(above, current, windows);
+            case SsimKernel::Sse41: return window_row_sse41(above, current, windows);
+#elif defined(MH_SSIM_NEON)
+            case SsimKernel::Neon: return window_row_neon(above, current, windows);
+#endif
+            default: return window_row_scalar(above, current, 0, windows);
+            }
+        }
+    }
+
+    const char* to_string(SsimKernel kernel) {
+        switch (kernel) {
+        case SsimKernel::Sse41: return "sse4.1";
+        case SsimKernel::Avx2: return "avx2";
+        case SsimKernel::Neon: return "neon";
+        default: return "scalar";
+        }
+    }
+
+    SsimKernel best_ssim_kernel() {
+        static const SsimKernel kernel = detect_kernel();
+        return kernel;
+    }
+
+    bool ssim_kernel_supported(SsimKernel kernel) {
+        switch (kernel) {
+        case SsimKernel::Scalar: return true;
+#if defined(MH_SSIM_X86)
+        case SsimKernel::Sse41:
+        case SsimKernel::Avx2: return cpu_has(kernel);
+#elif defined(MH_SSIM_NEON)
+        case SsimKernel::Neon: return true;
+#endif
+        default: return false;
+        }
+    }
+
+    void luma_plane(const std::uint8_t* pixels, std::size_t stride, unsigned width, unsigned height, int components,
+        std::vector<std::uint8_t>& out) {
+        luma_plane(pixels, stride, width, height, components, out, best_ssim_kernel());
+    }
+
+    void luma_plane(const std::uint8_t* pixels, std::size_t stride, unsigned width, unsigned height, int components,
+        std::vector<std::uint8_t>& out, SsimKernel kernel) {
+        out.clear();
+        if (components != 1 && components != 3) return;
+        if (!ssim_kernel_supported(kernel)) kernel = SsimKernel::Scalar;
+        out.resize(static_cast<std::size_t>(width) * height);
+        for (unsigned y = 0; y < height; ++y) {
+            const std::uint8_t* in = pixels + y * stride;
+            std::uint8_t* row = out.data() + static_cast<std::size_t>(y) * width;
+            if (components == 1) std::copy_n(in, width, row);
+            else luma_row(kernel, in, row, width);
+        }
+    }
+
+    double ssim(const LumaView& a, const LumaView& b) {
+        return ssim(a, b, best_ssim_kernel());
+    }
+
+    double ssim(const LumaView& a, const LumaView& b, SsimKernel kernel) {
+        if (a.width != b.width || a.height != b.height) return 0.0;
+        if (!ssim_kernel_supported(kernel)) kernel = SsimKernel::Scalar;
+        const unsigned blocks_x = a.width / 4, blocks_y = a.height / 4;
+
+        if (blocks_x < 2 || blocks_y < 2) {
+            // Smaller than one window: the whole plane is the window.
+            double s1 = 0, s2 = 0, squares = 0, cross = 0;
+            for (unsigned y = 0; y < a.height; ++y) {
+                for (unsigned x = 0; x < a.width; ++x) {
+                    const double va = a.pixels[y * a.stride + x], vb = b.pixels[y * b.stride + x];
+                    s1 += va;
+                    s2 += vb;
+                    squares += va * va + vb * vb;
+                    cross += va * vb;
+                }
+            }
+            const double n = static_cast<double>(a.width) * a.height;
+            if (n < 2) return s1 == s2 ? 1.0 : 0.0;
+            const double mu1 = s1 / n, mu2 = s2 / n;
+            const double variances = (squares - (s1 * s1 + s2 * s2) / n) / (n - 1);
+            const double covariance = (cross - s1 * s2 / n) / (n - 1);
+            return (2 * mu1 * mu2 + C1) * (2 * covariance + C2) / ((mu1 * mu1 + mu2 * mu2 + C1) * (variances + C2));
+        }
+
+        // Two block rows in flight: each window row joins the previous block row with the current one.
+        thread_local std::vector<std::uint32_t> storage;
+        storage.resize(static_cast<std::size_t>(blocks_x) * 8);
+        auto row_at = [&](std::size_t i) {
+            std::uint32_t* p = storage.data() + i * 4 * blocks_x;
+            return SumRow{ p, p + blocks_x, p + 2 * blocks_x, p + 3 * blocks_x };
+        };
+        SumRow above = row_at(0), current = row_at(1);
+
+        block_sums(kernel, a.pixels, a.stride, b.pixels, b.stride, blocks_x, above);
+        double total = 0;
+        for (unsigned by = 1; by < blocks_y; ++by) {
+            block_sums(kernel, a.pixels + by * 4 * a.stride, a.stride, b.pixels + by * 4 * b.stride, b.stride, blocks_x, current);
+            total += window_row(kernel, above, current, blocks_x - 1);
+            std::swap(above, current);
+        }
+        return total / (static_cast<double>(blocks_x - 1) * (blocks_y - 1));
+    }
+
+} // namespace media_handler::compressor
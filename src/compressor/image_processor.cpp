@@ -1,11 +1,22 @@
 ﻿#include "utils/utils.h"
 #include "compressor/image_processor.h"
+#include "compressor/dct_requantize.h"
+#include "compressor/jpeg_support.h"
+#include "compressor/jpeg_strip_encoder.h"
+#include "compressor/quality_search.h"
+#include "utils/work_context.h"
 #include <fstream>
 #include <algorithm>
 #include <cctype>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
 #include <vector>
 #include <jpeglib.h>
-#include <libexif/exif-data.h>
+#include <jerror.h>
 #include <png.h>
 #include <libheif/heif.h>
 
@@ -13,23 +24,108 @@ namespace media_handler::compressor {
 
     namespace fs = std::filesystem;
 
-    struct JpegErrorHandler {
-        struct jpeg_error_mgr pub; // must be first member
-        jmp_buf setjmp_buffer;
-        char message[JMSG_LENGTH_MAX];
-    };
-
-    static void jpeg_error_exit_safe(j_common_ptr cinfo) {
-        auto* err = reinterpret_cast<JpegErrorHandler*>(cinfo->err);
-        (*cinfo->err->format_message)(cinfo, err->message);
-        longjmp(err->setjmp_buffer, 1);
+    /// @brief Largest size within PHOTO_TRIM_WIDTH x PHOTO_TRIM_HEIGHT with the source aspect ratio.
+    /// Images already inside the box keep their size.
+    static std::pair<unsigned, unsigned> trim_size(unsigned width, unsigned height) {
+        double scale = 1.0;
+        if (width > PHOTO_TRIM_WIDTH) scale = std::min(scale, static_cast<double>(PHOTO_TRIM_WIDTH) / width);
+        if (height > PHOTO_TRIM_HEIGHT) scale = std::min(scale, static_cast<double>(PHOTO_TRIM_HEIGHT) / height);
+        return { std::max(1u, static_cast<unsigned>(width * scale)), std::max(1u, static_cast<unsigned>(height * scale)) };
     }
 
-    // Suppresses libjpeg trace spam that would otherwise go to stderr
-    static void jpeg_emit_message_safe(j_common_ptr /*cinfo*/, int /*msg_level*/) {
-        // Intentionally suppressed. Fatal errors are handled by jpeg_error_exit_safe.
+    /// @brief Smallest libjpeg decode scale (n/8) whose output still covers the target size, so the
+    /// IDCT does most of the downscaling and the resampler only the last, fractional step.
+    static unsigned jpeg_scale_eighths(unsigned width, unsigned height, unsigned target_w, unsigned target_h) {
+        for (unsigned n = 1; n < 8; ++n) {
+            if ((width * n + 7) / 8 >= target_w && (height * n + 7) / 8 >= target_h) return n;
+        }
+        return 8;
     }
 
+    /// @brief Box-filter downscaler fed one decoded row at a time. Each output pixel is the area-weighted
+    /// mean of the source pixels it covers, so detail is averaged rather than skipped. Only one output row
+    /// of accumulators is held; rows are emitted as soon as the source has covered them.
+    /// Buffers come from the decompressor's image pool and the object is trivially destructible, so a
+    /// libjpeg error that longjmps out of the loop leaks nothing.
+    class AreaResampler {
+    public:
+        AreaResampler(j_common_ptr cinfo, unsigned src_w, unsigned src_h, unsigned dst_w, unsigned dst_h, int channels)
+            : src_w(src_w), src_h(src_h), dst_w(dst_w), dst_h(dst_h), channels(channels) {
+            const std::size_t row = static_cast<std::size_t>(dst_w) * channels;
+            const std::size_t taps = static_cast<std::size_t>(src_w) + dst_w; // Upper bound on (output, source) overlaps.
+            line = alloc<float>(cinfo, row);
+            acc = alloc<float>(cinfo, row);
+            out = alloc<JSAMPLE>(cinfo, row);
+            x_first = alloc<unsigned>(cinfo, dst_w + 1);
+            x_index = alloc<unsigned>(cinfo, taps);
+            x_weight = alloc<float>(cinfo, taps);
+            std::fill(acc, acc + row, 0.0f);
+
+            // Source pixel j spans [j*dst_w, (j+1)*dst_w) and output pixel x spans [x*src_w, (x+1)*src_w)
+            // in the same integer units, so overlaps are exact and the weights of each output sum to 1.
+            unsigned n = 0;
+            for (std::uint64_t x = 0; x < dst_w; ++x) {
+                const std::uint64_t lo = x * src_w, hi = lo + src_w;
+                x_first[x] = n;
+                for (std::uint64_t j = lo / dst_w; j * dst_w < hi; ++j, ++n) {
+                    x_index[n] = static_cast<unsigned>(j);
+                    x_weight[n] = static_cast<float>(std::min(hi, (j + 1) * dst_w) - std::max(lo, j * dst_w)) / src_w;
+                }
+            }
+            x_first[dst_w] = n;
+        }
+
+        /// @brief Add the next source row; calls emit(JSAMPROW) for every output row it completes.
+        template <class Emit>
+        void push(const JSAMPLE* row, Emit&& emit) {
+            const std::size_t width = static_cast<std::size_t>(dst_w) * channels;
+            for (unsigned x = 0; x < dst_w; ++x) {
+                float* px = line + static_cast<std::size_t>(x) * channels;
+                std::fill(px, px + channels, 0.0f);
+                for (unsigned k = x_first[x]; k < x_first[x + 1]; ++k) {
+                    const JSAMPLE* s = row + static_cast<std::size_t>(x_index[k]) * channels;
+                    for (int c = 0; c < channels; ++c) px[c] += x_weight[k] * s[c];
+                }
+            }
+
+            // Same scheme vertically; a source row can straddle the boundary between two output rows.
+            std::uint64_t lo = src_row++ * dst_h;
+            const std::uint64_t hi = lo + dst_h;
+            while (lo < hi && dst_row < dst_h) {
+                const std::uint64_t edge = (dst_row + 1) * src_h;
+                const auto part = std::min(hi, edge) - lo;
+                const float w = static_cast<float>(part) / src_h;
+                for (std::size_t i = 0; i < width; ++i) acc[i] += w * line[i];
+                lo += part;
+                if (lo == edge) {
+                    for (std::size_t i = 0; i < width; ++i) {
+                        out[i] = static_cast<JSAMPLE>(std::clamp(acc[i] + 0.5f, 0.0f, 255.0f));
+                        acc[i] = 0.0f;
+                    }
+                    ++dst_row;
+                    emit(out);
+                }
+            }
+        }
+
+    private:
+        template <class T>
+        static T* alloc(j_common_ptr cinfo, std::size_t count) {
+            return static_cast<T*>((*cinfo->mem->alloc_large)(cinfo, JPOOL_IMAGE, count * sizeof(T)));
+        }
+
+        std::uint64_t src_w, src_h, dst_w, dst_h;
+        int channels;
+        std::uint64_t src_row = 0, dst_row = 0;
+        unsigned* x_first = nullptr;
+        unsigned* x_index = nullptr;
+        float* x_weight = nullptr;
+        float* line = nullptr;
+        float* acc = nullptr;
+        JSAMPLE* out = nullptr;
+    };
+    static_assert(std::is_trivially_destructible_v<AreaResampler>);
+
     ImageProcessor::ImageProcessor(const utils::Config& cfg, std::shared_ptr<spdlog::logger> logger)
         : config(cfg), logger(std::move(logger)) { //std::move() to avoid ref-count increment
     }
@@ -55,20 +151,242 @@ namespace media_handler::compressor {
         }
     }
 
-    ProcessResult ImageProcessor::compress_jpeg(const fs::path& input, const fs::path& output) {
-        FILE* infile = utils::fopen_path(input, "rb");
-        if (!infile) {
-            return ProcessResult::Error("Failed to open input JPEG");
+    /// @brief Per-worker file buffers reused from image to image, so steady-state JPEG work allocates
+    /// nothing for file data. Each keeps the capacity of the largest image its worker has seen.
+    struct JpegBuffers {
+        std::vector<unsigned char> input;
+        std::vector<JOCTET> output;
+        std::vector<JSAMPLE> pixels; // Whole decoded image, when it is encoded in parallel strips.
+        std::vector<JSAMPLE> luma; // Source luma, when outputs are verified.
+        std::vector<JSAMPLE> decoded; // Output luma decoded back for verification.
+
+        static JpegBuffers& current() {
+            thread_local JpegBuffers buffers;
+            return buffers;
         }
+    };
+
+    /// @brief IJG standard luminance quantization table (ITU-T T.81 Annex K), natural order.
+    static constexpr unsigned short STD_LUMA_QUANT[DCTSIZE2] = {
+        16, 11, 10, 16, 24, 40, 51, 61,
+        12, 12, 14, 19, 26, 58, 60, 55,
+        14, 13, 16, 24, 40, 57, 69, 56,
+        14, 17, 22, 29, 51, 87, 80, 62,
+        18, 22, 37, 56, 68, 109, 103, 77,
+        24, 35, 55, 64, 81, 104, 113, 92,
+        49, 64, 78, 87, 103, 121, 120, 101,
+        72, 92, 95, 98, 112, 100, 103, 99,
+    };
+
+    /// @brief IJG standard chrominance quantization table (ITU-T T.81 Annex K), natural order.
+    static constexpr unsigned short STD_CHROMA_QUANT[DCTSIZE2] = {
+        17, 18, 24, 47, 99, 99, 99, 99,
+        18, 21, 26, 66, 99, 99, 99, 99,
+        24, 26, 56, 99, 99, 99, 99, 99,
+        47, 66, 99, 99, 99, 99, 99, 99,
+        99, 99, 99, 99, 99, 99, 99, 99,
+        99, 99, 99, 99, 99, 99, 99, 99,
+        99, 99, 99, 99, 99, 99, 99, 99,
+        99, 99, 99, 99, 99, 99, 99, 99,
+    };
+
+    /// @brief Quantization step k of a standard table scaled to `quality`, as jpeg_set_quality(.., TRUE) makes it.
+    static std::uint16_t quality_step(const unsigned short* standard, int k, int quality) {
+        const long scale = jpeg_quality_scaling(quality);
+        return static_cast<std::uint16_t>(std::clamp((standard[k] * scale + 50) / 100, 1L, 255L));
+    }
+
+    /// @brief Sum of the source's luma quantization steps over the sum of the standard table at `quality`.
+    /// Above 1 the source is coarser than the target; 0 when the header carried no luma table.
+    static double luma_step_ratio(const jpeg_decompress_struct& src, int quality) {
+        const JQUANT_TBL* table = src.quant_tbl_ptrs[0];
+        if (!table) return 0.0;
+        long source = 0, target = 0;
+        for (int i = 0; i < DCTSIZE2; ++i) {
+            source += table->quantval[i];
+            target += quality_step(STD_LUMA_QUANT, i, quality);
+        }
+        return static_cast<double>(source) / static_cast<double>(target);
+    }
+
+    /// @brief True when the source's luma quantization is already at least as coarse as re-encoding at
+    /// `quality` would make it, so a pixel re-encode would mostly add generation loss, not savings.
+    static bool source_is_coarser(const jpeg_decompress_struct& src, int quality) {
+        return luma_step_ratio(src, quality) >= 1.0;
+    }
 
+    /// @brief IJG quality (1-100) that would produce the source's luma table, inverting jpeg_quality_scaling()
+    /// on the mean step. Tables from other encoders land on the nearest equivalent. 0 when unknown.
+    static int estimate_quality(const jpeg_decompress_struct& src) {
+        const double ratio = luma_step_ratio(src, 50); // Quality 50 is the unscaled standard table.
+        if (ratio <= 0.0) return 0;
+        const double scale = ratio * 100.0;
+        const double quality = scale <= 100.0 ? (200.0 - scale) / 2.0 : 5000.0 / scale;
+        return std::clamp(static_cast<int>(std::lround(quality)), 1, 100);
+    }
+
+    /// @brief Predicted output/input size for a pixel or requantize pass to `quality` at `out_pixels`.
+    /// Measured on tools::write_jpeg 1280x960 sources at quality 84-98 re-encoded at 80 (3 seeds, no resize):
+    /// step ratio 0.80/0.70/0.60/0.50/0.40/0.30/0.20/0.10 gave size ratio 1.00/0.97/0.93/0.69/0.40/0.39/0.29/0.23.
+    /// A log-log fit through the origin gives 0.69 overall, but near the passthrough decision (ratio 0.9-1.0)
+    /// the sizes sit above that curve, so the flatter 0.6 is kept. A source at or below the target does not shrink.
+    static double predicted_size_ratio(const jpeg_decompress_struct& src, int quality, std::uint64_t out_pixels) {
+        const double steps = luma_step_ratio(src, quality);
+        if (steps <= 0.0) return 0.0; // No table to judge by: assume compressing pays.
+        const double in_pixels = static_cast<double>(src.image_width) * src.image_height;
+        return std::pow(std::min(1.0, steps), 0.6) * (static_cast<double>(out_pixels) / in_pixels);
+    }
+
+    /// @brief Minimum pixels per parallel strip: below this, starting a thread costs more than it saves.
+    static constexpr std::uint64_t MIN_STRIP_PIXELS = 256 * 1024;
+
+    /// @brief How a JPEG is encoded: in strips or by the ordinary scanline encoder, and on how many threads.
+    struct EncodePlan {
+        bool strips = false;
+        unsigned threads = 1; // The calling thread plus one per reserved idle core.
+        utils::IdleWorkers::Reservation cores;
+    };
+
+    /// @brief Plan the encode of a `pixels`-pixel JPEG. Helper threads only come from idle workers this file
+    /// reserved (the pool size is the user's concurrency budget), so they are never more than the cores left
+    /// idle. Strips are used with a reservation, or from config.jpeg_parallel_pixels up on the calling thread
+    /// alone; max-compression always needs the scanline encoder (strips are baseline only).
+    static EncodePlan plan_encode(std::uint64_t pixels, const utils::Config& config, utils::JpegProfile profile) {
+        const std::uint64_t strips = pixels / MIN_STRIP_PIXELS;
+        if (strips < 2 || profile == utils::JpegProfile::MaxCompression) return {};
+        EncodePlan plan;
+        plan.cores = utils::IdleWorkers::reserve(static_cast<std::size_t>(strips - 1));
+        plan.threads = 1 + static_cast<unsigned>(plan.cores.size());
+        plan.strips = plan.threads > 1 || (config.jpeg_parallel_pixels > 0 && pixels >= config.jpeg_parallel_pixels);
+        return plan;
+    }
+
+    /// @brief Quality for `image` from a probe search for `target`, or PHOTO_QUALITY when the search cannot run.
+    static int searched_quality(const StripImage& image, const QualityTarget& target, utils::JpegProfile profile,
+        const fs::path& input, spdlog::logger* logger) {
+        const auto found = search_jpeg_quality(image, target, profile);
+        if (!found) {
+            if (logger) logger->warn("Quality search failed for {} ({}); using quality {}", utils::path_to_utf8(input), found.error(), PHOTO_QUALITY);
+            return PHOTO_QUALITY;
+        }
+        if (logger) {
+            logger->debug("{}: quality {} after {} probes (SSIM {:.4f}, {:.2f} bpp{})", utils::path_to_utf8(input), found->quality,
+                found->probes, found->ssim, found->bpp, found->reached ? "" : ", target out of range");
+        }
+        return found->quality;
+    }
+
+    /// @brief A JPEG encoded into JpegBuffers::output, and its score when verified.
+    struct VerifiedEncode {
+        std::size_t size = 0; // Bytes of the output buffer holding the JPEG.
+        int quality = 0;
+        double ssim = 0.0; // Luma SSIM against the source; 0 when not measured.
+    };
+
+    /// @brief Encode `image` at `quality` as `plan` says, and with a `threshold` set, decode the
+    /// output's luma and score it against the source. Below the threshold the image is encoded once more, at
+    /// the quality a probe search finds for the threshold, or SEARCH_QUALITY_MAX when the probe saw no need
+    /// for more than `quality`, and scored again. What to do with an output that still falls short is the caller's.
+    static std::expected<VerifiedEncode, std::string> encode_verified(const StripImage& image, int quality, utils::JpegProfile profile,
+        const EncodePlan& plan, const JpegMarkerWriter& markers, double threshold, const fs::path& input, spdlog::logger* logger) {
+        auto& buffers = JpegBuffers::current();
+        auto encode = [&](int q) {
+            return plan.strips ? encode_jpeg_strips(image, q, profile, plan.threads, markers, buffers.output)
+                : encode_jpeg_image(image, q, profile, markers, buffers.output);
+            };
+        auto size = encode(quality);
+        if (!size) return std::unexpected(size.error());
+        VerifiedEncode result{ *size, quality };
+        if (threshold <= 0.0) return result;
+
+        luma_plane(image.pixels, image.stride, image.width, image.height, image.components, buffers.luma);
+        if (buffers.luma.empty()) return result; // CMYK: no luma to compare.
+        const LumaView source{ buffers.luma.data(), image.width, image.width, image.height };
+        auto score = [&] {
+            const auto s = encoded_luma_ssim(source, buffers.output.data(), result.size, buffers.decoded);
+            if (!s && logger) logger->warn("SSIM check failed for {} ({})", utils::path_to_utf8(input), s.error());
+            return s.value_or(0.0);
+            };
+        result.ssim = score();
+        if (result.ssim == 0.0 || result.ssim >= threshold || quality >= SEARCH_QUALITY_MAX) return result;
+
+        const auto found = search_jpeg_quality(image, { .ssim = threshold }, profile);
+        const int retry = found && found->quality > quality ? found->quality : SEARCH_QUALITY_MAX;
+        if (logger) logger->debug("{}: SSIM {:.4f} < {:.4f} at quality {}; re-encoding at {}", utils::path_to_utf8(input), result.ssim, threshold, quality, retry);
+        size = encode(retry);
+        if (!size) return std::unexpected(size.error());
+        result = { *size, retry };
+        result.ssim = score();
+        return result;
+    }
+
+    /// @brief Write `size` bytes to `output` in one call.
+    static ProcessResult write_jpeg_file(const fs::path& output, const unsigned char* data, std::size_t size) {
         FILE* outfile = utils::fopen_path(output, "wb");
         if (!outfile) {
-            fclose(infile);
             return ProcessResult::Error("Failed to open output JPEG");
         }
+        const bool written = fwrite(data, 1, size, outfile) == size;
+        if (fclose(outfile) != 0 || !written) {
+            return ProcessResult::Error(std::format("Failed to write output JPEG: {}", strerror(errno)));
+        }
+        return ProcessResult::OK();
+    }
+
+    /// @brief Move the coefficients read by jpeg_read_coefficients() onto the `quality` tables without leaving
+    /// the DCT domain, and install those tables in `dst` (set up by jpeg_copy_critical_parameters()).
+    /// A step is never made finer than the source's: that would cost bits without restoring any detail.
+    static void requantize_coefficients(j_decompress_ptr src, jvirt_barray_ptr* coefficients, j_compress_ptr dst, int quality) {
+        static_assert(sizeof(JCOEF) == sizeof(std::int16_t) && DCTSIZE2 == DCT_BLOCK);
+        static_assert(sizeof(UINT16) == sizeof(std::uint16_t));
+
+        // One target per source table; a table is treated as luma if the first component uses it.
+        RequantTable factors[NUM_QUANT_TBLS];
+        bool done[NUM_QUANT_TBLS] = {};
+        for (int ci = 0; ci < dst->num_components; ++ci) {
+            const int n = dst->comp_info[ci].quant_tbl_no;
+            JQUANT_TBL* table = dst->quant_tbl_ptrs[n];
+            if (done[n] || !table) continue;
+            const bool luma = n == dst->comp_info[0].quant_tbl_no;
+            std::uint16_t source[DCTSIZE2];
+            for (int k = 0; k < DCTSIZE2; ++k) {
+                source[k] = table->quantval[k];
+                table->quantval[k] = std::max(source[k], quality_step(luma ? STD_LUMA_QUANT : STD_CHROMA_QUANT, k, quality));
+            }
+            factors[n] = make_requant_table(source, table->quantval);
+            done[n] = true;
+        }
+
+        for (int ci = 0; ci < src->num_components; ++ci) {
+            const jpeg_component_info& comp = src->comp_info[ci];
+            const RequantTable& factor = factors[dst->comp_info[ci].quant_tbl_no];
+            for (JDIMENSION row = 0; row < comp.height_in_blocks; ++row) {
+                JBLOCKARRAY blocks = (*src->mem->access_virt_barray)((j_common_ptr)src, coefficients[ci], row, 1, TRUE);
+                requantize_blocks(reinterpret_cast<std::int16_t*>(blocks[0][0]), comp.width_in_blocks, factor);
+            }
+        }
+    }
+
+    /// @brief Copy the APP1 segments saved from the source (EXIF, XMP) into the output unchanged.
+    static void copy_app1_markers(const jpeg_decompress_struct& src, j_compress_ptr dst) {
+        const auto mark = utils::StageMark::now();
+        for (auto* m = src.marker_list; m; m = m->next) {
+            if (m->marker == JPEG_APP0 + 1) jpeg_write_marker(dst, m->marker, m->data, m->data_length);
+        }
+        mark.finish(utils::Stage::Metadata);
+    }
 
-        struct jpeg_decompress_struct srcinfo;
-        struct jpeg_compress_struct dstinfo;
+    ProcessResult ImageProcessor::compress_jpeg(const fs::path& input, const fs::path& output) {
+        // One read of the whole file: libjpeg decodes from memory and the EXIF block is taken from the
+        // markers it saves on the way, rather than reading the file a second time for libexif.
+        auto& buffers = JpegBuffers::current();
+        if (!utils::read_file_into(input, buffers.input)) {
+            return ProcessResult::Error("Failed to open input JPEG");
+        }
+
+        // Zeroed so the error path can destroy whichever of the two has not been created yet.
+        struct jpeg_decompress_struct srcinfo {};
+        struct jpeg_compress_struct dstinfo {};
         JpegErrorHandler jerr;
 
         // Safe error handler so libjpeg never calls exit().
@@ -79,70 +397,203 @@ namespace media_handler::compressor {
         if (setjmp(jerr.setjmp_buffer)) {
             jpeg_destroy_decompress(&srcinfo);
             jpeg_destroy_compress(&dstinfo);
-            fclose(infile);
-            fclose(outfile);
 
             return ProcessResult::Error(std::format("libjpeg error (decompress): {}", jerr.message));
         }
 
         jpeg_create_decompress(&srcinfo);
-        jpeg_stdio_src(&srcinfo, infile);
+        jpeg_mem_src(&srcinfo, buffers.input.data(), static_cast<unsigned long>(buffers.input.size()));
+        jpeg_save_markers(&srcinfo, JPEG_APP0 + 1, 0xFFFF); // EXIF and XMP, copied to the output unchanged.
         if (jpeg_read_header(&srcinfo, TRUE) != JPEG_HEADER_OK) {
             jpeg_destroy_decompress(&srcinfo);
-            fclose(infile);
-            fclose(outfile);
             return ProcessResult::Error("Invalid JPEG header");
         }
 
-        jpeg_start_decompress(&srcinfo);
+        utils::WorkContext::current().pixels = static_cast<std::uint64_t>(srcinfo.image_width) * srcinfo.image_height;
+
+        const auto [target_w, target_h] = trim_size(srcinfo.image_width, srcinfo.image_height);
+        const bool resize = target_w < srcinfo.image_width || target_h < srcinfo.image_height;
+
+        // Both coefficient modes skip IDCT, colour conversion, resampling and FDCT entirely.
+        // Lossless carries the coefficients over unchanged and only redoes the entropy coding (optimized
+        // Huffman tables, progressive scans), like jpegtran. Requantize rescales them onto the
+        // PHOTO_QUALITY tables. Resizing needs pixels, so it always takes the re-encode path.
+        auto mode = utils::parse_jpeg_mode(config.jpeg_mode).value_or(utils::JpegMode::Reencode);
+        const auto profile = utils::parse_jpeg_profile(config.jpeg_profile).value_or(utils::JpegProfile::Balanced);
+        if (mode == utils::JpegMode::Auto)
+            mode = source_is_coarser(srcinfo, PHOTO_QUALITY) ? utils::JpegMode::Lossless : utils::JpegMode::Requantize;
+        if (resize) mode = utils::JpegMode::Reencode;
+
+        // Judged from the header alone: a source already near the target quality would cost a full decode
+        // and encode for a few percent, or come out larger, so it is copied as is. Lossless always pays.
+        // A searched quality is only known after decoding; that case is judged once the search has run.
+        const auto target = QualityTarget::from(config);
+        const bool search = mode == utils::JpegMode::Reencode && target.enabled();
+        const double verify_ssim = mode == utils::JpegMode::Reencode ? config.jpeg_verify_ssim : 0.0;
+        if (mode != utils::JpegMode::Lossless && !search && config.jpeg_min_savings > 0.0) {
+            const double predicted = predicted_size_ratio(srcinfo, PHOTO_QUALITY, static_cast<std::uint64_t>(target_w) * target_h);
+            if (1.0 - predicted < config.jpeg_min_savings) {
+                const int quality = estimate_quality(srcinfo);
+                jpeg_destroy_decompress(&srcinfo);
+                if (auto res = write_jpeg_file(output, buffers.input.data(), buffers.input.size()); !res.success) return res;
+                return ProcessResult::Passthrough(std::format("source quality ~{}, predicted saving {:.0f}% < {:.0f}%",
+                    quality, std::max(0.0, 1.0 - predicted) * 100.0, config.jpeg_min_savings * 100.0));
+            }
+        }
+
         dstinfo.err = jpeg_std_error(&jerr.pub); //share the same handler
         dstinfo.err->error_exit = jpeg_error_exit_safe;
         dstinfo.err->emit_message = jpeg_emit_message_safe; //suppress stderr trace/warning spam
         jpeg_create_compress(&dstinfo);
-        jpeg_stdio_dest(&dstinfo, outfile);
-
-        dstinfo.image_width = srcinfo.output_width;
-        dstinfo.image_height = srcinfo.output_height;
-        dstinfo.input_components = srcinfo.output_components;
-        dstinfo.in_color_space = srcinfo.out_color_space;
+        VectorDestination dest(&dstinfo, buffers.output);
+
+        if (mode != utils::JpegMode::Reencode) {
+            const auto transcode = utils::StageMark::now();
+            jvirt_barray_ptr* coefficients = jpeg_read_coefficients(&srcinfo);
+            jpeg_copy_critical_parameters(&srcinfo, &dstinfo);
+            if (mode == utils::JpegMode::Lossless) {
+                dstinfo.optimize_coding = TRUE;
+                jpeg_simple_progression(&dstinfo);
+            }
+            else {
+                // Standard Huffman tables unless asked for max-compression: the extra statistics pass of
+                // optimize_coding would cost about as much as the whole pixel path this mode exists to avoid.
+                requantize_coefficients(&srcinfo, coefficients, &dstinfo, PHOTO_QUALITY);
+                if (profile == utils::JpegProfile::MaxCompression) {
+                    dstinfo.optimize_coding = TRUE;
+                    jpeg_simple_progression(&dstinfo);
+                }
+            }
+            jpeg_write_coefficients(&dstinfo, coefficients);
+            copy_app1_markers(srcinfo, &dstinfo);
+            jpeg_finish_compress(&dstinfo);
+            jpeg_finish_decompress(&srcinfo);
+            transcode.finish(utils::Stage::Transcode);
+        }
+        else {
+            // Large photos are decoded straight to a reduced size by libjpeg's scaled IDCT, which skips most
+            // of the decode work, then resampled the rest of the way to the trim size.
+            if (resize) {
+                srcinfo.scale_num = jpeg_scale_eighths(srcinfo.image_width, srcinfo.image_height, target_w, target_h);
+                srcinfo.scale_denom = 8;
+            }
+            apply_jpeg_profile(&srcinfo, profile);
+            jpeg_start_decompress(&srcinfo);
+
+            // The scaled decode may land below the target on rounding; never resample upwards.
+            const unsigned out_w = resize ? std::min<unsigned>(target_w, srcinfo.output_width) : srcinfo.output_width;
+            const unsigned out_h = resize ? std::min<unsigned>(target_h, srcinfo.output_height) : srcinfo.output_height;
+
+            // With cores to spare, a quality to search for or an output to verify, the image is decoded whole
+            // first; then it is encoded in strips concurrently, or in one pass.
+            auto plan = plan_encode(static_cast<std::uint64_t>(out_w) * out_h, config, profile);
+            if (plan.strips || search || verify_ssim > 0.0) {
+                const auto decode = utils::StageMark::now();
+                const std::size_t stride = static_cast<std::size_t>(out_w) * srcinfo.output_components;
+                // longjmp out of a catch handler skips the exception's cleanup, so raise after it closes.
+                bool out_of_memory = false;
+                try {
+                    buffers.pixels.resize(stride * out_h);
+                }
+                catch (const std::bad_alloc&) {
+                    out_of_memory = true;
+                }
+                if (out_of_memory) ERREXIT1(&srcinfo, JERR_OUT_OF_MEMORY, 0); // Exceptions must not unwind past libjpeg state.
+                JSAMPLE* next = buffers.pixels.data();
+                if (out_w == srcinfo.output_width && out_h == srcinfo.output_height) {
+                    while (srcinfo.output_scanline < srcinfo.output_height) {
+                        JSAMPROW row = next + stride * srcinfo.output_scanline;
+                        jpeg_read_scanlines(&srcinfo, &row, 1);
+                    }
+                }
+                else {
+                    JSAMPARRAY row = (*srcinfo.mem->alloc_sarray)((j_common_ptr)&srcinfo, JPOOL_IMAGE,
+                        srcinfo.output_width * srcinfo.output_components, 1);
+                    AreaResampler resampler((j_common_ptr)&srcinfo, srcinfo.output_width, srcinfo.output_height,
+                        out_w, out_h, srcinfo.output_components);
+                    while (srcinfo.output_scanline < srcinfo.output_height) {
+                        jpeg_read_scanlines(&srcinfo, row, 1);
+                        resampler.push(row[0], [&](JSAMPROW out) { std::memcpy(next, out, stride); next += stride; });
+                    }
+                }
+                // Not finished: jpeg_finish_decompress() would release the APP1 markers the encode copies.
+                decode.finish(utils::Stage::Decode);
+
+                const auto encode = utils::StageMark::now();
+                const StripImage image{ buffers.pixels.data(), stride, out_w, out_h, srcinfo.output_components, srcinfo.out_color_space };
+                const int quality = search ? searched_quality(image, target, profile, input, logger.get()) : PHOTO_QUALITY;
+
+                // The same judgement as before decoding, now that the quality is known.
+                if (search && config.jpeg_min_savings > 0.0) {
+                    const double predicted = predicted_size_ratio(srcinfo, quality, static_cast<std::uint64_t>(out_w) * out_h);
+                    if (1.0 - predicted < config.jpeg_min_savings) {
+                        encode.finish(utils::Stage::Encode);
+                        jpeg_destroy_compress(&dstinfo);
+                        jpeg_destroy_decompress(&srcinfo);
+                        if (auto res = write_jpeg_file(output, buffers.input.data(), buffers.input.size()); !res.success) return res;
+                        return ProcessResult::Passthrough(std::format("searched quality {}, predicted saving {:.0f}% < {:.0f}%",
+                            quality, std::max(0.0, 1.0 - predicted) * 100.0, config.jpeg_min_savings * 100.0));
+                    }
+                }
 
-        jpeg_set_defaults(&dstinfo);
-        jpeg_set_quality(&dstinfo, PHOTO_QUALITY, TRUE);
-        jpeg_start_compress(&dstinfo, TRUE);
+                auto encoded = encode_verified(image, quality, profile, plan,
+                    [&srcinfo](j_compress_ptr cinfo) { copy_app1_markers(srcinfo, cinfo); }, verify_ssim, input, logger.get());
+                plan.cores.release();
+                encode.finish(utils::Stage::Encode);
+                jpeg_destroy_compress(&dstinfo);
+                jpeg_destroy_decompress(&srcinfo);
+                if (!encoded) return ProcessResult::Error(std::format("libjpeg error (encode): {}", encoded.error()));
+                // Still short after the retry: the source is the better file, unless it is over the trim size.
+                if (encoded->ssim > 0.0 && encoded->ssim < verify_ssim) {
+                    if (!resize) {
+                        if (auto res = write_jpeg_file(output, buffers.input.data(), buffers.input.size()); !res.success) return res;
+                        return ProcessResult::Passthrough(std::format("SSIM {:.4f} at quality {} < {:.4f}", encoded->ssim, encoded->quality, verify_ssim));
+                    }
+                    if (logger) logger->warn("{}: SSIM {:.4f} at quality {} is below {:.4f}", utils::path_to_utf8(input), encoded->ssim, encoded->quality, verify_ssim);
+                }
+                utils::WorkContext::current().ssim = encoded->ssim;
+                return write_jpeg_file(output, buffers.output.data(), encoded->size);
+            }
 
-        {
-            auto exif_buf_raw = utils::read_file_bytes(input);
-            ExifData* exif = exif_buf_raw.empty()
-                ? nullptr
-                : exif_data_new_from_data(exif_buf_raw.data(), static_cast<unsigned int>(exif_buf_raw.size()));
-            if (exif) {
-                unsigned char* exif_out = nullptr;
-                unsigned int exif_len = 0;
-                exif_data_save_data(exif, &exif_out, &exif_len);
-                if (exif_out && exif_len > 6 && memcmp(exif_out, "Exif\0\0", 6) == 0) {
-                    jpeg_write_marker(&dstinfo, JPEG_APP0 + 1, exif_out, exif_len);
+            dstinfo.image_width = out_w;
+            dstinfo.image_height = out_h;
+            dstinfo.input_components = srcinfo.output_components;
+            dstinfo.in_color_space = srcinfo.out_color_space;
+
+            apply_jpeg_profile(&dstinfo, profile);
+            jpeg_set_quality(&dstinfo, PHOTO_QUALITY, TRUE);
+            jpeg_start_compress(&dstinfo, TRUE);
+            copy_app1_markers(srcinfo, &dstinfo);
+
+            // Decode and encode are interleaved per scanline, so they are timed as one stage.
+            const auto transcode = utils::StageMark::now();
+
+            // allocate buffer for one scanline
+            const int row_stride = srcinfo.output_width * srcinfo.output_components;
+            JSAMPARRAY buffer = (*srcinfo.mem->alloc_sarray)((j_common_ptr)&srcinfo, JPOOL_IMAGE, row_stride, 1);
+            if (out_w == srcinfo.output_width && out_h == srcinfo.output_height) {
+                while (srcinfo.output_scanline < srcinfo.output_height) {
+                    jpeg_read_scanlines(&srcinfo, buffer, 1);
+                    jpeg_write_scanlines(&dstinfo, buffer, 1);
+                }
+            }
+            else {
+                AreaResampler resampler((j_common_ptr)&srcinfo, srcinfo.output_width, srcinfo.output_height,
+                    out_w, out_h, srcinfo.output_components);
+                while (srcinfo.output_scanline < srcinfo.output_height) {
+                    jpeg_read_scanlines(&srcinfo, buffer, 1);
+                    resampler.push(buffer[0], [&](JSAMPROW row) { jpeg_write_scanlines(&dstinfo, &row, 1); });
                 }
-                if (exif_out) free(exif_out);
-                exif_data_unref(exif);
             }
-        }
 
-        // allocate buffer for one scanline
-        const int row_stride = srcinfo.output_width * srcinfo.output_components;
-        JSAMPARRAY buffer = (*srcinfo.mem->alloc_sarray)((j_common_ptr)&srcinfo, JPOOL_IMAGE, row_stride, 1);
-        while (srcinfo.output_scanline < srcinfo.output_height) {
-            jpeg_read_scanlines(&srcinfo, buffer, 1);
-            jpeg_write_scanlines(&dstinfo, buffer, 1);
+            jpeg_finish_compress(&dstinfo);
+            jpeg_finish_decompress(&srcinfo);
+            transcode.finish(utils::Stage::Transcode);
         }
-
-        jpeg_finish_compress(&dstinfo);
-        jpeg_finish_decompress(&srcinfo);
         jpeg_destroy_compress(&dstinfo);
         jpeg_destroy_decompress(&srcinfo);
-        fclose(infile);
-        fclose(outfile);
 
-        return ProcessResult::OK();
+        return write_jpeg_file(output, buffers.output.data(), dest.written);
     }
 
     ProcessResult ImageProcessor::compress_heic(const fs::path& input, const fs::path& output) {
@@ -185,7 +636,10 @@ namespace media_handler::compressor {
         }
 
         heif_image* image = nullptr;
-        err = heif_decode_image(handle, &image, heif_colorspace_RGB, heif_chroma_interleaved_RGB, nullptr);
+        {
+            utils::StageTimer decode(utils::Stage::Decode);
+            err = heif_decode_image(handle, &image, heif_colorspace_RGB, heif_chroma_interleaved_RGB, nullptr);
+        }
         if (err.code != heif_error_Ok || !image) {
             heif_image_handle_release(handle);
             heif_context_free(ctx);
@@ -197,6 +651,7 @@ namespace media_handler::compressor {
         int height = heif_image_get_height(image, heif_channel_interleaved);
         int stride;
         const uint8_t* data = heif_image_get_plane_readonly(image, heif_channel_interleaved, &stride);
+        utils::WorkContext::current().pixels = static_cast<std::uint64_t>(width) * height;
 
         if (!data) {
             heif_image_release(image);
@@ -209,6 +664,59 @@ namespace media_handler::compressor {
         auto output_jpeg = output;
         output_jpeg.replace_extension(".jpg");
 
+        // Preserve EXIF metadata from the HEIC source. Read up front: nothing that owns memory may be
+        // live across the libjpeg calls below, which longjmp on error.
+        std::vector<uint8_t> exif;
+        {
+            const auto metadata = utils::StageMark::now();
+            int meta_count = heif_image_handle_get_number_of_metadata_blocks(handle, "Exif");
+            if (meta_count > 0) {
+                heif_item_id meta_id = 0;
+                heif_image_handle_get_list_of_metadata_block_IDs(handle, "Exif", &meta_id, 1);
+                size_t meta_size = heif_image_handle_get_metadata_size(handle, meta_id);
+                if (meta_size > 10) {
+                    std::vector<uint8_t> meta_buf(meta_size);
+                    heif_error meta_err = heif_image_handle_get_metadata(handle, meta_id, meta_buf.data());
+                    // The block starts with a 4-byte offset to the TIFF header.
+                    if (meta_err.code == heif_error_Ok && memcmp(meta_buf.data() + 4, "Exif\0\0", 6) == 0)
+                        exif.assign(meta_buf.begin() + 4, meta_buf.end());
+                }
+            }
+            metadata.finish(utils::Stage::Metadata);
+        }
+        auto write_exif = [&exif](j_compress_ptr cinfo) {
+            if (!exif.empty()) jpeg_write_marker(cinfo, JPEG_APP0 + 1, exif.data(), static_cast<unsigned int>(exif.size()));
+            };
+
+        const auto profile = utils::parse_jpeg_profile(config.jpeg_profile).value_or(utils::JpegProfile::Balanced);
+        const StripImage pixels{ data, static_cast<std::size_t>(stride), static_cast<JDIMENSION>(width), static_cast<JDIMENSION>(height), 3, JCS_RGB };
+        int quality = PHOTO_QUALITY;
+        if (const auto target = QualityTarget::from(config); target.enabled()) {
+            const auto search = utils::StageMark::now();
+            quality = searched_quality(pixels, target, profile, input, logger.get());
+            search.finish(utils::Stage::Encode);
+        }
+
+        // Verification needs the output in memory; there is no source JPEG to fall back to, so an output that
+        // stays below the threshold after the retry is kept with a warning.
+        const double verify_ssim = config.jpeg_verify_ssim;
+        if (auto plan = plan_encode(static_cast<std::uint64_t>(width) * height, config, profile); plan.strips || verify_ssim > 0.0) {
+            auto& buffers = JpegBuffers::current();
+            const auto encode = utils::StageMark::now();
+            auto encoded = encode_verified(pixels, quality, profile, plan, write_exif, verify_ssim, input, logger.get());
+            plan.cores.release();
+            encode.finish(utils::Stage::Encode);
+            heif_image_release(image);
+            heif_image_handle_release(handle);
+            heif_context_free(ctx);
+            if (!encoded) return ProcessResult::Error(std::format("libjpeg error (heic encode): {}", encoded.error()));
+            if (encoded->ssim > 0.0 && encoded->ssim < verify_ssim && logger) {
+                logger->warn("{}: SSIM {:.4f} at quality {} is below {:.4f}", utils::path_to_utf8(input), encoded->ssim, encoded->quality, verify_ssim);
+            }
+            utils::WorkContext::current().ssim = encoded->ssim;
+            return write_jpeg_file(output_jpeg, buffers.output.data(), encoded->size);
+        }
+
         FILE* outfile = utils::fopen_path(output_jpeg, "wb");
         if (!outfile) {
             heif_image_release(image);
@@ -243,32 +751,14 @@ namespace media_handler::compressor {
         cinfo.input_components = 3;  // RGB
         cinfo.in_color_space = JCS_RGB;
 
-        jpeg_set_defaults(&cinfo);
-        jpeg_set_quality(&cinfo, PHOTO_QUALITY, TRUE);
+        apply_jpeg_profile(&cinfo, profile);
+        jpeg_set_quality(&cinfo, quality, TRUE);
         jpeg_start_compress(&cinfo, TRUE);
 
-        // Preserve EXIF metadata from the HEIC source.
-        {
-            int meta_count = heif_image_handle_get_number_of_metadata_blocks(handle, "Exif");
-            if (meta_count > 0) {
-                heif_item_id meta_id = 0;
-                heif_image_handle_get_list_of_metadata_block_IDs(handle, "Exif", &meta_id, 1);
-                size_t meta_size = heif_image_handle_get_metadata_size(handle, meta_id);
-                if (meta_size > 10) {
-                    std::vector<uint8_t> meta_buf(meta_size);
-                    heif_error meta_err = heif_image_handle_get_metadata(handle, meta_id, meta_buf.data());
-                    if (meta_err.code == heif_error_Ok) {
-                        const uint8_t* exif_ptr = meta_buf.data() + 4;
-                        size_t exif_size = meta_size - 4;
-                        if (memcmp(exif_ptr, "Exif\0\0", 6) == 0) {
-                            jpeg_write_marker(&cinfo, JPEG_APP0 + 1, exif_ptr, static_cast<unsigned int>(exif_size));
-                        }
-                    }
-                }
-            }
-        }
+        write_exif(&cinfo);
 
         // Write scanlines
+        const auto encode = utils::StageMark::now();
         JSAMPROW row_pointer[1];
         while (cinfo.next_scanline < cinfo.image_height) {
             row_pointer[0] = (JSAMPROW)(data + cinfo.next_scanline * stride);
@@ -277,6 +767,7 @@ namespace media_handler::compressor {
 
         // Cleanup JPEG
         jpeg_finish_compress(&cinfo);
+        encode.finish(utils::Stage::Encode);
         jpeg_destroy_compress(&cinfo);
         fclose(outfile);
 
@@ -374,16 +865,15 @@ namespace media_handler::compressor {
         }
 
         // Read the image
+        const auto decode = utils::StageMark::now();
         png_read_image(png_read_ptr, row_pointers);
+        decode.finish(utils::Stage::Decode);
+        utils::WorkContext::current().pixels = static_cast<std::uint64_t>(width) * height;
         png_destroy_read_struct(&png_read_ptr, &read_info_ptr, NULL);
         fclose(in_file);
 
         // Resize output dimensions while preserving aspect ratio.
-        double scale = 1.0;
-        if (width > PHOTO_TRIM_WIDTH) scale = std::min(scale, static_cast<double>(PHOTO_TRIM_WIDTH) / width);
-        if (height > PHOTO_TRIM_HEIGHT) scale = std::min(scale, static_cast<double>(PHOTO_TRIM_HEIGHT) / height);
-        png_uint_32 out_width = static_cast<png_uint_32>(width * scale);
-        png_uint_32 out_height = static_cast<png_uint_32>(height * scale);
+        const auto [out_width, out_height] = trim_size(width, height);
 
         out_file = utils::fopen_path(output, "wb");
         if (!out_file) {
@@ -426,6 +916,7 @@ namespace media_handler::compressor {
         png_write_info(png_write_ptr, write_info_ptr);
 
         // Write scaled rows (simple nearest-neighbor scaling)
+        const auto encode = utils::StageMark::now();
         for (png_uint_32 y = 0; y < out_height; y++) {
             png_uint_32 src_y = (png_uint_32)((double)y * height / out_height);
             png_write_row(png_write_ptr, row_pointers[src_y]);
@@ -433,6 +924,7 @@ namespace media_handler::compressor {
 
         // Finish writing
         png_write_end(png_write_ptr, write_info_ptr);
+        encode.finish(utils::Stage::Encode);
         png_destroy_write_struct(&png_write_ptr, &write_info_ptr);
         free(image_data);
         free(row_pointers);
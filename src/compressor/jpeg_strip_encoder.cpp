@@ -0,0 +1,211 @@
+#include "compressor/jpeg_strip_encoder.h"
+#include "compressor/jpeg_support.h"
+#include "utils/resource_usage.h"
+#include "utils/work_context.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <format>
+#include <system_error>
+#include <thread>
+
+namespace media_handler::compressor {
+
+    namespace {
+        constexpr JDIMENSION ROW_BATCH = 16; // Scanlines handed to libjpeg per call.
+
+        /// @brief One horizontal band of the image and the complete JPEG encoded from it.
+        struct Strip {
+            JDIMENSION first_row = 0;
+            JDIMENSION rows = 0;
+            std::vector<JOCTET> data;
+            std::size_t written = 0;
+            std::chrono::nanoseconds cpu{}; // Helper threads only; the calling thread is measured by the tracker.
+            bool ok = false;
+            char message[JMSG_LENGTH_MAX] = {};
+        };
+
+        void configure(j_compress_ptr cinfo, const StripImage& image, JDIMENSION rows, int quality, utils::JpegProfile profile) {
+            cinfo->image_width = image.width;
+            cinfo->image_height = rows;
+            cinfo->input_components = image.components;
+            cinfo->in_color_space = image.color_space;
+            apply_jpeg_profile(cinfo, profile == utils::JpegProfile::Fast ? profile : utils::JpegProfile::Balanced);
+            jpeg_set_quality(cinfo, quality, TRUE);
+        }
+
+        /// @brief Pixel rows per MCU row with the default sampling for this colour space (16 for YCbCr 4:2:0).
+        JDIMENSION mcu_height(const StripImage& image, int quality, utils::JpegProfile profile) {
+            jpeg_compress_struct cinfo{};
+            JpegErrorHandler jerr;
+            cinfo.err = jpeg_std_error(&jerr.pub);
+            jerr.pub.error_exit = jpeg_error_exit_safe;
+            jerr.pub.emit_message = jpeg_emit_message_safe;
+            if (setjmp(jerr.setjmp_buffer)) {
+                jpeg_destroy_compress(&cinfo);
+                return DCTSIZE; // The strip encoders will report the same error.
+            }
+            jpeg_create_compress(&cinfo);
+            configure(&cinfo, image, image.height, quality, profile);
+            int v = 1;
+            for (int ci = 0; ci < cinfo.num_components; ++ci) v = std::max(v, cinfo.comp_info[ci].v_samp_factor);
+            jpeg_destroy_compress(&cinfo);
+            return static_cast<JDIMENSION>(v * DCTSIZE);
+        }
+
+        /// @brief Encode one strip as a standalone JPEG that restarts at every MCU row.
+        void encode_strip(const StripImage& image, int quality, utils::JpegProfile profile, Strip& strip, const JpegMarkerWriter* markers) {
+            jpeg_compress_struct cinfo{};
+            JpegErrorHandler jerr;
+            cinfo.err = jpeg_std_error(&jerr.pub);
+            jerr.pub.error_exit = jpeg_error_exit_safe;
+            jerr.pub.emit_message = jpeg_emit_message_safe; //suppress stderr trace/warning spam
+            if (setjmp(jerr.setjmp_buffer)) {
+                jpeg_destroy_compress(&cinfo);
+                std::memcpy(strip.message, jerr.message, sizeof(strip.message));
+                return;
+            }
+
+            jpeg_create_compress(&cinfo);
+            VectorDestination dest(&cinfo, strip.data);
+            configure(&cinfo, image, strip.rows, quality, profile);
+            cinfo.restart_in_rows = 1; // Strip boundaries fall between restart intervals.
+            jpeg_start_compress(&cinfo, TRUE);
+            if (markers && *markers) (*markers)(&cinfo);
+
+            JSAMPROW rows[ROW_BATCH];
+            while (cinfo.next_scanline < cinfo.image_height) {
+                const JDIMENSION n = std::min(ROW_BATCH, cinfo.image_height - cinfo.next_scanline);
+                for (JDIMENSION i = 0; i < n; ++i)
+                    rows[i] = const_cast<JSAMPROW>(image.pixels + (strip.first_row + cinfo.next_scanline + i) * image.stride);
+                jpeg_write_scanlines(&cinfo, rows, n);
+            }
+            jpeg_finish_compress(&cinfo);
+            strip.written = dest.written;
+            jpeg_destroy_compress(&cinfo);
+            strip.ok = true;
+        }
+
+        /// @brief Rewrite every RSTn marker in entropy-coded data to continue the sequence `next`.
+        /// Byte stuffing guarantees an 0xFF in coded data is followed by 0x00, so this never misfires.
+        void renumber_restarts(JOCTET* p, std::size_t n, unsigned& next) {
+            for (auto* end = p + n; (p = static_cast<JOCTET*>(std::memchr(p, 0xFF, end - p))) && p + 1 < end; p += 2) {
+                if (p[1] >= JPEG_RST0 && p[1] <= JPEG_RST0 + 7) p[1] = static_cast<JOCTET>(JPEG_RST0 + (next++ & 7));
+            }
+        }
+    }
+
+    std::expected<std::size_t, std::string> encode_jpeg_image(const StripImage& image, int quality, utils::JpegProfile profile,
+        const JpegMarkerWriter& markers, std::vector<JOCTET>& out) {
+        jpeg_compress_struct cinfo{};
+        JpegErrorHandler jerr;
+        cinfo.err = jpeg_std_error(&jerr.pub);
+        jerr.pub.error_exit = jpeg_error_exit_safe;
+        jerr.pub.emit_message = jpeg_emit_message_safe; //suppress stderr trace/warning spam
+        if (setjmp(jerr.setjmp_buffer)) {
+            jpeg_destroy_compress(&cinfo);
+            return std::unexpected(std::string(jerr.message));
+        }
+
+        jpeg_create_compress(&cinfo);
+        VectorDestination dest(&cinfo, out);
+        cinfo.image_width = image.width;
+        cinfo.image_height = image.height;
+        cinfo.input_components = image.components;
+        cinfo.in_color_space = image.color_space;
+        apply_jpeg_profile(&cinfo, profile);
+        jpeg_set_quality(&cinfo, quality, TRUE);
+        jpeg_start_compress(&cinfo, TRUE);
+        if (markers) markers(&cinfo);
+
+        JSAMPROW rows[ROW_BATCH];
+        while (cinfo.next_scanline < cinfo.image_height) {
+            const JDIMENSION n = std::min(ROW_BATCH, cinfo.image_height - cinfo.next_scanline);
+            for (JDIMENSION i = 0; i < n; ++i) rows[i] = const_cast<JSAMPROW>(image.pixels + (cinfo.next_scanline + i) * image.stride);
+            jpeg_write_scanlines(&cinfo, rows, n);
+        }
+        jpeg_finish_compress(&cinfo);
+        const std::size_t written = dest.written;
+        jpeg_destroy_compress(&cinfo);
+        return written;
+    }
+
+    std::expected<std::size_t, std::string> encode_jpeg_strips(const StripImage& image, int quality, utils::JpegProfile profile,
+        unsigned threads, const JpegMarkerWriter& markers, std::vector<JOCTET>& out) {
+        if (image.width == 0 || image.height == 0) return std::unexpected("Empty image");
+        if (image.height > JPEG_MAX_DIMENSION || image.width > JPEG_MAX_DIMENSION)
+            return std::unexpected(std::format("Image {}x{} exceeds the JPEG size limit", image.width, image.height));
+
+        // Whole MCU rows per strip, so only the last strip has a partial (edge-padded) MCU row.
+        const JDIMENSION mcu_h = mcu_height(image, quality, profile);
+        const JDIMENSION mcu_rows = (image.height + mcu_h - 1) / mcu_h;
+        const JDIMENSION wanted = std::clamp<JDIMENSION>(threads, 1, mcu_rows);
+        const JDIMENSION per_strip = (mcu_rows + wanted - 1) / wanted;
+        const JDIMENSION count = (mcu_rows + per_strip - 1) / per_strip;
+
+        std::vector<Strip> strips(count);
+        for (JDIMENSION i = 0; i < count; ++i) {
+            strips[i].first_row = i * per_strip * mcu_h;
+            strips[i].rows = std::min(per_strip * mcu_h, image.height - strips[i].first_row);
+        }
+
+        {
+            std::vector<std::jthread> helpers;
+            helpers.reserve(count - 1);
+            JDIMENSION spawned = 1;
+            try {
+                for (; spawned < count; ++spawned) {
+                    helpers.emplace_back([&image, quality, profile, &strip = strips[spawned]] {
+                        const auto cpu = utils::ResourceSample::now().cpu;
+                        encode_strip(image, quality, profile, strip, nullptr);
+                        strip.cpu = utils::ResourceSample::now().cpu - cpu;
+                        });
+                }
+            }
+            catch (const std::system_error&) {
+                // Out of threads: the calling thread encodes whatever could not be handed off.
+            }
+            encode_strip(image, quality, profile, strips[0], &markers);
+            for (JDIMENSION i = spawned; i < count; ++i) encode_strip(image, quality, profile, strips[i], nullptr);
+        } // Joins the helpers.
+
+        std::size_t total = 2;
+        std::chrono::nanoseconds helper_cpu{};
+        for (const auto& s : strips) {
+            if (!s.ok) return std::unexpected(std::string(s.message));
+            total += s.written + 2;
+            helper_cpu += s.cpu;
+        }
+        utils::WorkContext::current().attributed_cpu += helper_cpu;
+
+        // Headers (tables, DRI, APP markers) come from the first strip, with the full height patched in.
+        std::size_t sof = 0;
+        const std::size_t header = scan_data_offset(strips[0].data.data(), strips[0].written, sof);
+        if (header == 0 || sof == 0) return std::unexpected("Malformed strip headers");
+        if (out.size() < total) out.resize(total);
+        std::memcpy(out.data(), strips[0].data.data(), header);
+        out[sof] = static_cast<JOCTET>(image.height >> 8);
+        out[sof + 1] = static_cast<JOCTET>(image.height & 0xFF);
+
+        std::size_t pos = header;
+        unsigned next_restart = 0;
+        for (JDIMENSION i = 0; i < count; ++i) {
+            const auto& s = strips[i];
+            std::size_t strip_sof = 0;
+            const std::size_t begin = i == 0 ? header : scan_data_offset(s.data.data(), s.written, strip_sof);
+            if (begin == 0 || s.written < begin + 2) return std::unexpected("Malformed strip headers");
+            const std::size_t length = s.written - 2 - begin; // Up to, not including, EOI.
+            if (i > 0) {
+                out[pos++] = 0xFF;
+                out[pos++] = static_cast<JOCTET>(JPEG_RST0 + (next_restart++ & 7));
+            }
+            std::memcpy(out.data() + pos, s.data.data() + begin, length);
+            renumber_restarts(out.data() + pos, length, next_restart);
+            pos += length;
+        }
+        out[pos++] = 0xFF;
+        out[pos++] = JPEG_EOI;
+        return pos;
+    }
+
+} // namespace media_handler::compressor
@@ -0,0 +1,153 @@
+#include "compressor/quality_search.h"
+#include "compressor/image_metrics.h"
+#include "compressor/jpeg_support.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <optional>
+#include <vector>
+
+namespace media_handler::compressor {
+
+    namespace {
+        /// @brief Offset of tile `i` of `n` spread evenly over `length`, aligned to the 16-pixel MCU grid
+        /// so each tile is cut into the same blocks as in a full-size encode.
+        unsigned tile_origin(unsigned i, unsigned n, unsigned length) {
+            const unsigned span = length - PROBE_TILE;
+            return (n > 1 ? span * i / (n - 1) : span / 2) & ~15u;
+        }
+
+        /// @brief Up to PROBE_PIXELS / PROBE_TILE^2 full-resolution tiles of `image`, on a grid spread over all
+        /// of it, copied side by side into `out`. An image too small for a grid is returned as is.
+        StripImage probe_of(const StripImage& image, std::vector<JSAMPLE>& out) {
+            constexpr unsigned tiles = static_cast<unsigned>(PROBE_PIXELS / (PROBE_TILE * PROBE_TILE));
+            const unsigned fit_x = image.width / PROBE_TILE, fit_y = image.height / PROBE_TILE;
+            if (static_cast<std::uint64_t>(image.width) * image.height <= 2 * PROBE_PIXELS || fit_x == 0 || fit_y == 0) return image;
+
+            // Square grid where the image allows, wider or taller where one side is short.
+            unsigned rows = std::min(fit_y, 8u); // 8 x 8 = tiles
+            const unsigned cols = std::min(fit_x, tiles / rows);
+            rows = std::min(fit_y, tiles / cols);
+
+            const std::size_t tile_bytes = static_cast<std::size_t>(PROBE_TILE) * image.components;
+            const std::size_t stride = tile_bytes * cols;
+            out.resize(stride * rows * PROBE_TILE);
+            for (unsigned ty = 0; ty < rows; ++ty) {
+                const unsigned y0 = tile_origin(ty, rows, image.height);
+                for (unsigned tx = 0; tx < cols; ++tx) {
+                    const JSAMPLE* from = image.pixels + y0 * image.stride + static_cast<std::size_t>(tile_origin(tx, cols, image.width)) * image.components;
+                    JSAMPLE* to = out.data() + ty * PROBE_TILE * stride + tx * tile_bytes;
+                    for (unsigned y = 0; y < PROBE_TILE; ++y) std::memcpy(to + y * stride, from + y * image.stride, tile_bytes);
+                }
+            }
+            return { out.data(), stride, cols * PROBE_TILE, rows * PROBE_TILE, image.components, image.color_space };
+        }
+    }
+
+    std::expected<double, std::string> encoded_luma_ssim(const LumaView& source, const JOCTET* jpeg, std::size_t size,
+        std::vector<JSAMPLE>& scratch) {
+        jpeg_decompress_struct cinfo{};
+        JpegErrorHandler jerr;
+        cinfo.err = jpeg_std_error(&jerr.pub);
+        jerr.pub.error_exit = jpeg_error_exit_safe;
+        jerr.pub.emit_message = jpeg_emit_message_safe; //suppress stderr trace/warning spam
+        if (setjmp(jerr.setjmp_buffer)) {
+            jpeg_destroy_decompress(&cinfo);
+            return std::unexpected(std::string(jerr.message));
+        }
+
+        jpeg_create_decompress(&cinfo);
+        jpeg_mem_src(&cinfo, jpeg, static_cast<unsigned long>(size));
+        jpeg_read_header(&cinfo, TRUE);
+        if (cinfo.jpeg_color_space != JCS_GRAYSCALE && cinfo.jpeg_color_space != JCS_YCbCr) {
+            jpeg_destroy_decompress(&cinfo);
+            return std::unexpected("JPEG has no luma channel");
+        }
+        cinfo.out_color_space = JCS_GRAYSCALE; // Y alone: the chroma components are never inverse-transformed.
+        jpeg_start_decompress(&cinfo);
+        if (cinfo.output_width != source.width || cinfo.output_height != source.height) {
+            jpeg_destroy_decompress(&cinfo);
+            return std::unexpected("JPEG size differs from its source");
+        }
+        bool out_of_memory = false;
+        try {
+            scratch.resize(static_cast<std::size_t>(source.width) * source.height);
+        }
+        catch (const std::bad_alloc&) {
+            out_of_memory = true; // longjmp from inside the handler would skip ending the exception.
+        }
+        if (out_of_memory) ERREXIT1(&cinfo, JERR_OUT_OF_MEMORY, 0); // Exceptions must not unwind past libjpeg state.
+        while (cinfo.output_scanline < cinfo.output_height) {
+            JSAMPROW row = scratch.data() + static_cast<std::size_t>(cinfo.output_scanline) * source.width;
+            jpeg_read_scanlines(&cinfo, &row, 1);
+        }
+        jpeg_finish_decompress(&cinfo);
+        jpeg_destroy_decompress(&cinfo);
+        return ssim(source, { scratch.data(), source.width, source.width, source.height });
+    }
+
+    std::expected<QualitySearch, std::string> search_jpeg_quality(const StripImage& image, const QualityTarget& target,
+        utils::JpegProfile profile) {
+        if (image.width == 0 || image.height == 0) return std::unexpected("Empty image");
+        if (!target.enabled()) return std::unexpected("No quality target");
+
+        std::vector<JSAMPLE> mosaic;
+        const StripImage probe = probe_of(image, mosaic);
+        const double probe_pixels = static_cast<double>(probe.width) * probe.height;
+
+        // SSIM targets work on luma alone; bpp targets need the colour encode the output will get.
+        const bool by_ssim = target.ssim > 0.0;
+        std::vector<JSAMPLE> luma, decoded;
+        StripImage source = probe;
+        if (by_ssim) {
+            luma_plane(probe.pixels, probe.stride, probe.width, probe.height, probe.components, luma);
+            if (luma.empty()) return std::unexpected("SSIM target needs RGB or grayscale pixels");
+            source = { luma.data(), probe.width, probe.width, probe.height, 1, JCS_GRAYSCALE };
+        }
+
+        std::vector<JOCTET> out;
+        std::array<std::optional<QualitySearch>, SEARCH_QUALITY_MAX + 1> seen{};
+        int probes = 0;
+        auto measure = [&](int quality) -> std::expected<QualitySearch, std::string> {
+            if (seen[quality]) return *seen[quality];
+            auto size = encode_jpeg_image(source, quality, profile, {}, out);
+            if (!size) return std::unexpected(size.error());
+            ++probes;
+            // Headers are amortized to nothing over a full-size image, so only entropy-coded bytes count.
+            std::size_t sof = 0;
+            const std::size_t headers = scan_data_offset(out.data(), *size, sof);
+            QualitySearch m{ .quality = quality, .bpp = static_cast<double>(*size - headers) * 8.0 / probe_pixels };
+            if (by_ssim) {
+                const auto score = encoded_luma_ssim({ luma.data(), source.width, source.width, source.height }, out.data(), *size, decoded);
+                if (!score) return std::unexpected(score.error());
+                m.ssim = *score;
+                m.reached = m.ssim >= target.ssim;
+            }
+            else m.reached = m.bpp <= target.bpp;
+            seen[quality] = m;
+            return m;
+        };
+
+        // SSIM rises with quality and size does too: find the boundary between qualities that meet the target
+        // and those that do not, taking the cheapest quality for SSIM and the best one for bpp.
+        int lo = SEARCH_QUALITY_MIN, hi = SEARCH_QUALITY_MAX;
+        while (lo < hi) {
+            const int mid = by_ssim ? lo + (hi - lo) / 2 : lo + (hi - lo + 1) / 2;
+            auto m = measure(mid);
+            if (!m) return std::unexpected(m.error());
+            if (by_ssim) {
+                if (m->reached) hi = mid;
+                else lo = mid + 1;
+            }
+            else {
+                if (m->reached) lo = mid;
+                else hi = mid - 1;
+            }
+        }
+        auto result = measure(lo);
+        if (!result) return std::unexpected(result.error());
+        result->probes = probes;
+        return result;
+    }
+
+} // namespace media_handler::compressor
@@ -1,4 +1,7 @@
 #include "compressor/video_processor.h"
+#include "utils/resource_usage.h"
+#include "utils/event_log.h"
+#include "utils/work_context.h"
 #include <fstream>
 #include <format>
 #include <vector>
@@ -64,6 +67,7 @@ namespace media_handler::compressor {
             AVStream* in_stream = nullptr;
             AVStream* out_stream = nullptr;
             AVPacket* packet = nullptr;
+            AVPacket* out_pkt = nullptr; // Encoder output, reused for every packet.
             AVFrame* frame = nullptr;
             AVFrame* scaled_frame = nullptr;
             SwsContext* sws_ctx = nullptr;
@@ -116,8 +120,10 @@ namespace media_handler::compressor {
             const int64_t max_bitrate = static_cast<int64_t>(src_bitrate * 0.50);
             const int64_t buf_size = max_bitrate * 2;
 
-            logger->info("Source bitrate: {}kbps  →  target: {}kbps  max: {}kbps",
+            logger->debug("Source bitrate: {}kbps  →  target: {}kbps  max: {}kbps",
                 src_bitrate / 1000, target_bitrate / 1000, max_bitrate / 1000);
+            utils::EventLog::emit(utils::EventType::VideoBitrate, {}, static_cast<std::uint64_t>(src_bitrate / 1000),
+                static_cast<std::uint64_t>(target_bitrate / 1000), static_cast<std::uint32_t>(max_bitrate / 1000));
 
             // Decoder — all cores
 
@@ -143,6 +149,9 @@ namespace media_handler::compressor {
             decoder_ctx->thread_count = 0;
             decoder_ctx->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
 
+            // Codec threads are spawned by avcodec_open2(); charge their CPU to this file.
+            utils::HelperThreadCpu codec_threads;
+
             ret = avcodec_open2(decoder_ctx, decoder, nullptr);
             if (ret < 0) {
                 avcodec_free_context(&decoder_ctx);
@@ -229,6 +238,7 @@ namespace media_handler::compressor {
                 avformat_close_input(&input_ctx);
                 return ProcessResult::Error("Failed to open encoder");
             }
+            codec_threads.adopt();
 
             avcodec_parameters_from_context(out_stream->codecpar, encoder_ctx);
             out_stream->time_base = encoder_ctx->time_base;
@@ -277,12 +287,14 @@ namespace media_handler::compressor {
 
             // Allocate working buffers
             packet = av_packet_alloc();
+            out_pkt = av_packet_alloc();
             frame = av_frame_alloc();
             scaled_frame = av_frame_alloc();
 
-            if (!packet || !frame || !scaled_frame) {
+            if (!packet || !out_pkt || !frame || !scaled_frame) {
                 if (scaled_frame) av_frame_free(&scaled_frame);
                 if (frame) av_frame_free(&frame);
+                if (out_pkt) av_packet_free(&out_pkt);
                 if (packet) av_packet_free(&packet);
                 if (sws_ctx) sws_freeContext(sws_ctx);
                 av_write_trailer(output_ctx);
@@ -301,6 +313,7 @@ namespace media_handler::compressor {
             if (ret < 0) {
                 av_frame_free(&scaled_frame);
                 av_frame_free(&frame);
+                av_packet_free(&out_pkt);
                 av_packet_free(&packet);
                 if (sws_ctx) sws_freeContext(sws_ctx);
                 av_write_trailer(output_ctx);
@@ -313,6 +326,9 @@ namespace media_handler::compressor {
             }
 
             // Main packet loop
+            {
+            utils::StageTimer transcode(utils::Stage::Transcode);
+            auto& frames_decoded = utils::WorkContext::current().frames;
             int64_t pts_fallback = 0;
 
             while (av_read_frame(input_ctx, packet) >= 0) {
@@ -327,6 +343,8 @@ namespace media_handler::compressor {
                         if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) break;
                         if (ret < 0) { av_packet_unref(packet); goto cleanup; }
 
+                        ++frames_decoded;
+
                         // Reset pict_type to let encoder decide GOP structure and avoid warnings/slowdown.
                         frame->pict_type = AV_PICTURE_TYPE_NONE;
 
@@ -355,20 +373,15 @@ namespace media_handler::compressor {
                         if (ret < 0) { av_packet_unref(packet); goto cleanup; }
 
                         while (ret >= 0) {
-                            AVPacket* out_pkt = av_packet_alloc();
                             ret = avcodec_receive_packet(encoder_ctx, out_pkt);
-                            if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
-                                av_packet_free(&out_pkt); break;
-                            }
+                            if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) break;
                             if (ret < 0) {
-                                av_packet_free(&out_pkt);
                                 av_packet_unref(packet);
                                 goto cleanup;
                             }
                             av_packet_rescale_ts(out_pkt, encoder_ctx->time_base, out_stream->time_base);
                             out_pkt->stream_index = out_stream->index;
-                            av_interleaved_write_frame(output_ctx, out_pkt);
-                            av_packet_free(&out_pkt);
+                            av_interleaved_write_frame(output_ctx, out_pkt); // Takes the payload and blanks out_pkt.
                         }
                     }
                 }
@@ -387,19 +400,20 @@ namespace media_handler::compressor {
             // Flush encoder
             avcodec_send_frame(encoder_ctx, nullptr);
             while (true) {
-                AVPacket* out_pkt = av_packet_alloc();
                 ret = avcodec_receive_packet(encoder_ctx, out_pkt);
-                if (ret == AVERROR_EOF || ret < 0) { av_packet_free(&out_pkt); break; }
+                if (ret == AVERROR_EOF || ret < 0) break;
                 av_packet_rescale_ts(out_pkt, encoder_ctx->time_base, out_stream->time_base);
                 out_pkt->stream_index = out_stream->index;
                 av_interleaved_write_frame(output_ctx, out_pkt);
-                av_packet_free(&out_pkt);
+            }
             }
 
         cleanup:
+            codec_threads.collect(); // Before the contexts (and their threads) are freed.
             av_write_trailer(output_ctx);
             av_frame_free(&scaled_frame);
             av_frame_free(&frame);
+            av_packet_free(&out_pkt);
             av_packet_free(&packet);
             if (sws_ctx) sws_freeContext(sws_ctx);
             if (output_ctx && output_ctx->pb) avio_closep(&output_ctx->pb);
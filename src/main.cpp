@@ -1,6 +1,7 @@
 #include "utils/app_args.h"
 #include "utils/utils.h"
 #include "compressor/compression_engine.h"
+#include "compressor/bench_mode.h"
 #include <iostream>
 
 namespace fs = std::filesystem;
@@ -15,8 +16,9 @@ int main(int argc, char** argv) {
         // Parse command line (handles config loading + CLI parsing)
         auto args = utils::parse_command_line(argc, argv, logger);
 
-        // Update logger level if changed
+        // Update logger level and overflow policy if changed
         logger->set_level(args.cfg.log_level);
+        utils::Logger::set_overflow(utils::parse_log_overflow(args.cfg.log_overflow).value_or(utils::LogOverflow::Block));
         logger->info("Input files: {}", args.inputs.size());
         logger->info("Output dir: {}", args.cfg.output_dir);
         logger->info("Threads: {}, CRF: {}", args.cfg.threads, args.cfg.crf);
@@ -33,6 +35,19 @@ int main(int argc, char** argv) {
             logger->info("Created output directory: {}", args.cfg.output_dir);
         }
 
+        if (args.bench_runs > 0) {
+            compressor::BenchOptions bench;
+            bench.runs = args.bench_runs;
+            bench.cache = compressor::parse_bench_cache(args.bench_cache).value_or(compressor::BenchCache::Warm);
+            auto result = compressor::run_bench(args.cfg, bench, logger);
+            utils::Logger::flush_all();
+            if (!result) {
+                logger->error("Bench failed: {}", result.error());
+                return 1;
+            }
+            return 0;
+        }
+
         compressor::MigrateOptions opts;
         opts.retry = args.retry_failed; // re-attempt files that failed in the prior run
         opts.organize = args.organize_by_date; // move output into output_dir/<YYYY>/ (without compression)
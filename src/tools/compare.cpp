@@ -0,0 +1,36 @@
+#include "utils/report_compare.h"
+#include <CLI/CLI.hpp>
+#include <iostream>
+
+namespace fs = std::filesystem;
+using namespace media_handler;
+
+// Diff two run reports (--report output) of the same corpus.
+// Exit code: 0 = no regressions, 1 = regressions found, 2 = usage or load error.
+int main(int argc, char** argv) {
+    CLI::App app{ "Media Handler - compare two run reports" };
+
+    fs::path baseline, candidate;
+    utils::CompareOptions opts;
+    app.add_option("baseline", baseline, "Report of the reference run")->required();
+    app.add_option("candidate", candidate, "Report of the run under test")->required();
+    app.add_option("--threshold", opts.threshold_pct, "Regression threshold in percent (points for savings)");
+    app.add_option("--min-slowdown-ms", opts.min_slowdown_ms, "Ignore per-file slowdowns below this");
+    app.add_option("--top", opts.max_slower, "Slower files to list");
+
+    try {
+        app.parse(argc, argv);
+    }
+    catch (const CLI::ParseError& e) {
+        return app.exit(e) == 0 ? 0 : 2;
+    }
+
+    auto a = utils::load_report(baseline);
+    if (!a) { std::cerr << a.error() << '\n'; return 2; }
+    auto b = utils::load_report(candidate);
+    if (!b) { std::cerr << b.error() << '\n'; return 2; }
+
+    auto c = utils::compare_reports(*a, *b, opts);
+    std::cout << utils::format_comparison(c, opts);
+    return c.regressions.empty() ? 0 : 1;
+}
@@ -0,0 +1,68 @@
+#include "tools/corpus_generator.h"
+#include <CLI/CLI.hpp>
+#include <iostream>
+#include <map>
+
+using namespace media_handler;
+
+// Generate a seeded synthetic media corpus (see tools::CorpusSpec for defaults).
+// Exit code: 0 = written, 1 = generation failed, 2 = usage error.
+int main(int argc, char** argv) {
+    CLI::App app{ "Media Handler - deterministic synthetic media corpus" };
+
+    tools::CorpusSpec spec;
+    std::vector<std::string> resolutions, video_resolutions;
+    app.add_option("-o,--out", spec.root, "Corpus directory")->required();
+    app.add_option("--seed", spec.seed, "Seed; the same seed and options give identical files");
+    app.add_option("--jpeg", spec.jpeg, "JPEG count");
+    app.add_option("--png", spec.png, "PNG count");
+    app.add_option("--heic", spec.heic, "HEIC count");
+    app.add_option("--video", spec.video, "Video count");
+    app.add_option("--corrupt", spec.corrupt, "Files with a damaged body");
+    app.add_option("--truncated", spec.truncated, "Files cut short");
+    app.add_option("--resolution", resolutions, "Image sizes, WxH (repeatable)");
+    app.add_option("--video-resolution", video_resolutions, "Video sizes, WxH (repeatable)");
+    app.add_option("--video-seconds", spec.video_seconds, "Video durations in seconds (repeatable)");
+    app.add_option("--codec", spec.video_codecs, "FFmpeg encoders for videos (repeatable)");
+    app.add_option("--fps", spec.video_fps, "Video frame rate");
+    app.add_option("--quality", spec.jpeg_quality, "JPEG/HEIC quality of the originals");
+    app.add_option("--depth", spec.depth, "Maximum directory nesting");
+    app.add_option("--fanout", spec.fanout, "Subdirectories per level");
+    app.add_option("--year-from", spec.year_from, "Earliest EXIF year");
+    app.add_option("--year-to", spec.year_to, "Latest EXIF year");
+
+    try {
+        app.parse(argc, argv);
+    }
+    catch (const CLI::ParseError& e) {
+        return app.exit(e) == 0 ? 0 : 2;
+    }
+
+    const auto parse_all = [](const std::vector<std::string>& in, std::vector<std::pair<int, int>>& out) {
+        if (in.empty()) return true;
+        out.clear();
+        for (const auto& r : in) {
+            auto wh = tools::parse_resolution(r);
+            if (!wh) { std::cerr << "Bad resolution '" << r << "', expected WxH\n"; return false; }
+            out.push_back(*wh);
+        }
+        return true;
+    };
+    if (!parse_all(resolutions, spec.resolutions) || !parse_all(video_resolutions, spec.video_resolutions)) return 2;
+
+    auto files = tools::generate_corpus(spec);
+    if (!files) {
+        std::cerr << "Corpus generation failed: " << files.error() << '\n';
+        return 1;
+    }
+
+    std::map<std::string, std::size_t> counts;
+    std::uintmax_t bytes = 0;
+    for (const auto& f : *files) {
+        ++counts[f.defect.empty() ? f.kind : f.defect];
+        bytes += f.size;
+    }
+    std::cout << files->size() << " files, " << bytes / 1'048'576.0 << " MB in " << spec.root.string() << '\n';
+    for (const auto& [what, n] : counts) std::cout << "  " << what << ": " << n << '\n';
+    return 0;
+}
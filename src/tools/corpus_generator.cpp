@@ -0,0 +1,167 @@
+#include "tools/corpus_generator.h"
+#include "tools/synthetic_media.h"
+#include "utils/utils.h"
+#include <charconv>
+#include <chrono>
+#include <format>
+#include <fstream>
+#include <nlohmann/json.hpp>
+
+namespace media_handler::tools {
+
+    namespace fs = std::filesystem;
+
+    namespace {
+        /// @brief SplitMix64. Defined here (not <random> distributions) so output is identical across standard libraries.
+        struct Rng {
+            std::uint64_t state;
+
+            std::uint64_t next() {
+                std::uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+                z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+                z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+                return z ^ (z >> 31);
+            }
+
+            /// @brief Uniform-enough value in [0, n) for the small ranges used here.
+            std::uint32_t below(std::size_t n) { return n == 0 ? 0 : static_cast<std::uint32_t>(next() % n); }
+        };
+
+        /// @brief Broken-down EXIF date.
+        struct Date {
+            int y, mo, d, h, mi, s;
+            std::string exif() const { return std::format("{:04}:{:02}:{:02} {:02}:{:02}:{:02}", y, mo, d, h, mi, s); }
+            std::string iso() const { return std::format("{:04}-{:02}-{:02}T{:02}:{:02}:{:02}.000000Z", y, mo, d, h, mi, s); }
+        };
+
+        /// @brief Container extension for an FFmpeg encoder name.
+        std::string container_for(const std::string& codec) {
+            if (codec.find("vpx") != std::string::npos || codec.find("av1") != std::string::npos) return ".mkv";
+            if (codec == "mpeg4") return ".avi";
+            return ".mp4";
+        }
+
+        /// @brief Overwrite a run of bytes in the second half of the file, leaving the header readable.
+        void corrupt_body(const fs::path& file, Rng& rng) {
+            const auto size = fs::file_size(file);
+            if (size < 64) return;
+            std::fstream f(file, std::ios::binary | std::ios::in | std::ios::out);
+            const std::uintmax_t span = std::min<std::uintmax_t>(512, size / 8);
+            f.seekp(static_cast<std::streamoff>(size / 2 + rng.below(size / 4)));
+            for (std::uintmax_t i = 0; i < span; ++i) f.put(static_cast<char>(rng.next()));
+        }
+    }
+
+    std::optional<std::pair<int, int>> parse_resolution(const std::string& text) {
+        const auto x = text.find_first_of("xX");
+        if (x == std::string::npos) return std::nullopt;
+        int w = 0, h = 0;
+        const auto [pw, ew] = std::from_chars(text.data(), text.data() + x, w);
+        const auto [ph, eh] = std::from_chars(text.data() + x + 1, text.data() + text.size(), h);
+        if (ew != std::errc{} || eh != std::errc{} || pw != text.data() + x || ph != text.data() + text.size()) return std::nullopt;
+        if (w <= 0 || h <= 0) return std::nullopt;
+        return std::pair{ w, h };
+    }
+
+    std::expected<std::vector<CorpusFile>, std::string> generate_corpus(const CorpusSpec& spec) {
+        if (spec.resolutions.empty()) return std::unexpected("no image resolutions given");
+        if (spec.video > 0 && (spec.video_resolutions.empty() || spec.video_seconds.empty() || spec.video_codecs.empty()))
+            return std::unexpected("videos requested without resolutions, durations or codecs");
+        if (spec.year_from > spec.year_to) return std::unexpected("year range is empty");
+
+        std::error_code ec;
+        fs::create_directories(spec.root, ec);
+        if (ec) return std::unexpected(std::format("cannot create {}: {}", utils::path_to_utf8(spec.root), ec.message()));
+
+        // Kinds that can donate a damaged copy, in a fixed order.
+        std::vector<std::string> defect_kinds;
+        if (spec.jpeg) defect_kinds.push_back("jpeg");
+        if (spec.png) defect_kinds.push_back("png");
+        if (spec.video) defect_kinds.push_back("video");
+        if (spec.heic) defect_kinds.push_back("heic");
+        if (defect_kinds.empty() && spec.corrupt + spec.truncated > 0) defect_kinds.push_back("jpeg");
+
+        struct Job { std::string kind; std::string defect; };
+        std::vector<Job> jobs;
+        for (std::size_t i = 0; i < spec.jpeg; ++i) jobs.push_back({ "jpeg", "" });
+        for (std::size_t i = 0; i < spec.png; ++i) jobs.push_back({ "png", "" });
+        for (std::size_t i = 0; i < spec.heic; ++i) jobs.push_back({ "heic", "" });
+        for (std::size_t i = 0; i < spec.video; ++i) jobs.push_back({ "video", "" });
+        for (std::size_t i = 0; i < spec.corrupt; ++i) jobs.push_back({ defect_kinds[i % defect_kinds.size()], "corrupt" });
+        for (std::size_t i = 0; i < spec.truncated; ++i) jobs.push_back({ defect_kinds[i % defect_kinds.size()], "truncated" });
+
+        std::vector<CorpusFile> files;
+        files.reserve(jobs.size());
+        for (std::size_t i = 0; i < jobs.size(); ++i) {
+            const auto& job = jobs[i];
+            // Per-file stream: a file's bytes depend only on (seed, index), not on earlier files.
+            Rng rng{ (static_cast<std::uint64_t>(spec.seed) << 32) ^ (i * 0x2545F4914F6CDD1Dull) };
+            const auto content_seed = static_cast<std::uint32_t>(rng.next());
+
+            const Date date{
+                spec.year_from + static_cast<int>(rng.below(spec.year_to - spec.year_from + 1)),
+                1 + static_cast<int>(rng.below(12)), 1 + static_cast<int>(rng.below(28)),
+                static_cast<int>(rng.below(24)), static_cast<int>(rng.below(60)), static_cast<int>(rng.below(60))
+            };
+
+            fs::path rel;
+            const int levels = static_cast<int>(rng.below(static_cast<std::size_t>(spec.depth) + 1));
+            for (int l = 0; l < levels; ++l) rel /= std::format("d{}_{}", l, rng.below(spec.fanout));
+
+            const std::string prefix = job.defect.empty() ? "" : job.defect + "_";
+            std::expected<void, std::string> made;
+            if (job.kind == "video") {
+                const auto [w, h] = spec.video_resolutions[rng.below(spec.video_resolutions.size())];
+                const double secs = spec.video_seconds[rng.below(spec.video_seconds.size())];
+                const auto& codec = spec.video_codecs[rng.below(spec.video_codecs.size())];
+                rel /= std::format("{}VID_{:05}{}", prefix, i, container_for(codec));
+                fs::create_directories((spec.root / rel).parent_path(), ec);
+                const int frames = std::max(1, static_cast<int>(secs * spec.video_fps));
+                made = write_video(spec.root / rel, w, h, frames, spec.video_fps, codec, content_seed, date.iso());
+            }
+            else {
+                const auto [w, h] = spec.resolutions[rng.below(spec.resolutions.size())];
+                const auto ext = job.kind == "jpeg" ? ".jpg" : "." + job.kind;
+                rel /= std::format("{}{}_{:05}{}", prefix, job.kind == "png" ? "PNG" : "IMG", i, ext);
+                fs::create_directories((spec.root / rel).parent_path(), ec);
+                const auto out = spec.root / rel;
+                made = job.kind == "jpeg" ? write_jpeg(out, w, h, spec.jpeg_quality, content_seed, date.exif())
+                    : job.kind == "png" ? write_png(out, w, h, content_seed)
+                    : write_heic(out, w, h, spec.jpeg_quality, content_seed, date.exif());
+            }
+            if (!made) return std::unexpected(std::format("{}: {}", utils::path_to_utf8(rel), made.error()));
+
+            const auto abs = spec.root / rel;
+            if (job.defect == "corrupt") {
+                corrupt_body(abs, rng);
+            }
+            else if (job.defect == "truncated") {
+                const auto size = fs::file_size(abs);
+                fs::resize_file(abs, size * (30 + rng.below(41)) / 100); // Keep 30-70%.
+            }
+
+            // File times match the embedded date, for tools that fall back to mtime.
+            const auto sys = std::chrono::sys_days{ std::chrono::year{ date.y } / date.mo / date.d }
+                + std::chrono::hours{ date.h } + std::chrono::minutes{ date.mi } + std::chrono::seconds{ date.s };
+            // file_clock and system_clock epochs differ by whole seconds, so rounding removes the
+            // jitter of the two now() reads (clock_cast is not available on every toolchain we build with).
+            const auto offset = fs::file_time_type::clock::now().time_since_epoch()
+                - std::chrono::duration_cast<fs::file_time_type::duration>(std::chrono::system_clock::now().time_since_epoch());
+            fs::last_write_time(abs, fs::file_time_type(std::chrono::round<std::chrono::seconds>(
+                std::chrono::duration_cast<fs::file_time_type::duration>(sys.time_since_epoch()) + offset)), ec);
+
+            files.push_back({ rel, job.kind, job.defect, date.exif(), fs::file_size(abs) });
+        }
+
+        std::ofstream manifest(spec.root / "manifest.ndjson", std::ios::binary | std::ios::trunc);
+        for (const auto& f : files) {
+            nlohmann::json j = {
+                {"path", f.path.generic_string()}, {"kind", f.kind}, {"defect", f.defect}, {"date", f.date}, {"size", f.size}
+            };
+            manifest << j.dump() << '\n';
+        }
+        if (!manifest) return std::unexpected("cannot write manifest.ndjson");
+        return files;
+    }
+
+} // namespace media_handler::tools
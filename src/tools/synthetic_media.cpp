@@ -0,0 +1,302 @@
+#include "tools/synthetic_media.h"
+#include "utils/utils.h"
+#include <algorithm>
+#include <csetjmp>
+#include <cstdio>
+#include <cstring>
+#include <format>
+#include <jpeglib.h>
+#include <png.h>
+#include <libheif/heif.h>
+#include <libexif/exif-data.h>
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#include <libavutil/avutil.h>
+}
+
+namespace media_handler::tools {
+
+    namespace fs = std::filesystem;
+
+    std::vector<std::uint8_t> synthetic_rgb(int width, int height, std::uint32_t seed, int frame) {
+        std::vector<std::uint8_t> rgb(static_cast<std::size_t>(width) * height * 3);
+        std::uint32_t state = seed * 2654435761u + 1;
+        const int shift = frame * 3; // Horizontal motion between frames.
+
+        for (int y = 0; y < height; ++y) {
+            std::uint8_t* row = rgb.data() + static_cast<std::size_t>(y) * width * 3;
+            for (int x = 0; x < width; ++x) {
+                // xorshift32: cheap, seeded sensor-like noise.
+                state ^= state << 13; state ^= state >> 17; state ^= state << 5;
+                const int noise = static_cast<int>(state & 15) - 8;
+
+                const int sx = x + shift;
+                const int block = (((sx >> 6) + (y >> 6) + static_cast<int>(seed)) & 1) * 48; // Hard edges.
+                const int r = sx * 255 / std::max(1, width) + block + noise;
+                const int g = y * 255 / std::max(1, height) + noise;
+                const int b = ((sx + y) * 255 / std::max(1, width + height)) - block + noise;
+
+                row[x * 3 + 0] = static_cast<std::uint8_t>(std::clamp(r, 0, 255));
+                row[x * 3 + 1] = static_cast<std::uint8_t>(std::clamp(g, 0, 255));
+                row[x * 3 + 2] = static_cast<std::uint8_t>(std::clamp(b, 0, 255));
+            }
+        }
+        return rgb;
+    }
+
+    std::vector<std::uint8_t> make_exif(const std::string& date) {
+        ExifData* exif = exif_data_new();
+        if (!exif) return {};
+        exif_data_set_option(exif, EXIF_DATA_OPTION_FOLLOW_SPECIFICATION);
+        exif_data_set_data_type(exif, EXIF_DATA_TYPE_COMPRESSED);
+        exif_data_set_byte_order(exif, EXIF_BYTE_ORDER_INTEL);
+        exif_data_fix(exif);
+
+        // exif_entry_initialize() sizes ASCII date tags to 20 bytes ("YYYY:MM:DD HH:MM:SS\0").
+        const auto set_date = [&](ExifIfd ifd, ExifTag tag) {
+            ExifEntry* entry = exif_content_get_entry(exif->ifd[ifd], tag);
+            if (!entry) {
+                entry = exif_entry_new();
+                if (!entry) return;
+                exif_content_add_entry(exif->ifd[ifd], entry);
+                exif_entry_initialize(entry, tag);
+                exif_entry_unref(entry); // Owned by the content now.
+            }
+            if (entry->data && entry->size >= 20) {
+                std::memset(entry->data, 0, entry->size);
+                std::memcpy(entry->data, date.data(), std::min<std::size_t>(date.size(), 19));
+            }
+        };
+        set_date(EXIF_IFD_0, EXIF_TAG_DATE_TIME);
+        set_date(EXIF_IFD_EXIF, EXIF_TAG_DATE_TIME_ORIGINAL);
+
+        unsigned char* buf = nullptr;
+        unsigned int len = 0;
+        exif_data_save_data(exif, &buf, &len);
+        std::vector<std::uint8_t> out(buf, buf + len);
+        free(buf);
+        exif_data_unref(exif);
+        return out;
+    }
+
+    namespace {
+        struct JpegError {
+            jpeg_error_mgr pub;
+            std::jmp_buf jump;
+            char message[JMSG_LENGTH_MAX];
+        };
+
+        void jpeg_error_exit(j_common_ptr cinfo) {
+            auto* err = reinterpret_cast<JpegError*>(cinfo->err);
+            (*cinfo->err->format_message)(cinfo, err->message);
+            std::longjmp(err->jump, 1);
+        }
+    }
+
+    std::expected<void, std::string> write_jpeg(const fs::path& file, int width, int height, int quality, std::uint32_t seed,
+        const std::string& exif_date) {
+        const auto rgb = synthetic_rgb(width, height, seed);
+        const auto exif = exif_date.empty() ? std::vector<std::uint8_t>{} : make_exif(exif_date);
+
+        FILE* out = utils::fopen_path(file, "wb");
+        if (!out) return std::unexpected(std::format("cannot create {}", utils::path_to_utf8(file)));
+
+        jpeg_compress_struct cinfo;
+        JpegError jerr;
+        cinfo.err = jpeg_std_error(&jerr.pub);
+        jerr.pub.error_exit = jpeg_error_exit;
+        if (setjmp(jerr.jump)) {
+            jpeg_destroy_compress(&cinfo);
+            fclose(out);
+            return std::unexpected(std::format("libjpeg: {}", jerr.message));
+        }
+
+        jpeg_create_compress(&cinfo);
+        jpeg_stdio_dest(&cinfo, out);
+        cinfo.image_width = static_cast<JDIMENSION>(width);
+        cinfo.image_height = static_cast<JDIMENSION>(height);
+        cinfo.input_components = 3;
+        cinfo.in_color_space = JCS_RGB;
+        jpeg_set_defaults(&cinfo);
+        jpeg_set_quality(&cinfo, quality, TRUE);
+        jpeg_start_compress(&cinfo, TRUE);
+        if (!exif.empty()) jpeg_write_marker(&cinfo, JPEG_APP0 + 1, exif.data(), static_cast<unsigned int>(exif.size()));
+
+        while (cinfo.next_scanline < cinfo.image_height) {
+            JSAMPROW row = const_cast<JSAMPROW>(rgb.data() + static_cast<std::size_t>(cinfo.next_scanline) * width * 3);
+            jpeg_write_scanlines(&cinfo, &row, 1);
+        }
+
+        jpeg_finish_compress(&cinfo);
+        jpeg_destroy_compress(&cinfo);
+        fclose(out);
+        return {};
+    }
+
+    std::expected<void, std::string> write_png(const fs::path& file, int width, int height, std::uint32_t seed) {
+        const auto rgb = synthetic_rgb(width, height, seed);
+
+        FILE* out = utils::fopen_path(file, "wb");
+        if (!out) return std::unexpected(std::format("cannot create {}", utils::path_to_utf8(file)));
+
+        png_structp png = png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+        png_infop info = png ? png_create_info_struct(png) : nullptr;
+        if (!info) {
+            png_destroy_write_struct(&png, nullptr);
+            fclose(out);
+            return std::unexpected("libpng: cannot create write struct");
+        }
+        if (setjmp(png_jmpbuf(png))) {
+            png_destroy_write_struct(&png, &info);
+            fclose(out);
+            return std::unexpected(std::format("libpng: error writing {}", utils::path_to_utf8(file)));
+        }
+
+        png_init_io(png, out);
+        png_set_IHDR(png, info, static_cast<png_uint_32>(width), static_cast<png_uint_32>(height), 8,
+            PNG_COLOR_TYPE_RGB, PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+        png_write_info(png, info);
+        for (int y = 0; y < height; ++y)
+            png_write_row(png, rgb.data() + static_cast<std::size_t>(y) * width * 3);
+        png_write_end(png, info);
+
+        png_destroy_write_struct(&png, &info);
+        fclose(out);
+        return {};
+    }
+
+    std::expected<void, std::string> write_heic(const fs::path& file, int width, int height, int quality, std::uint32_t seed,
+        const std::string& exif_date) {
+        const auto rgb = synthetic_rgb(width, height, seed);
+
+        heif_image* image = nullptr;
+        heif_error err = heif_image_create(width, height, heif_colorspace_RGB, heif_chroma_interleaved_RGB, &image);
+        if (err.code != heif_error_Ok) return std::unexpected(std::format("libheif: {}", err.message));
+
+        err = heif_image_add_plane(image, heif_channel_interleaved, width, height, 8);
+        if (err.code != heif_error_Ok) {
+            heif_image_release(image);
+            return std::unexpected(std::format("libheif: {}", err.message));
+        }
+
+        int stride = 0;
+        std::uint8_t* plane = heif_image_get_plane(image, heif_channel_interleaved, &stride);
+        for (int y = 0; y < height; ++y)
+            std::copy_n(rgb.data() + static_cast<std::size_t>(y) * width * 3, static_cast<std::size_t>(width) * 3, plane + static_cast<std::size_t>(y) * stride);
+
+        heif_context* ctx = heif_context_alloc();
+        heif_encoder* encoder = nullptr;
+        err = heif_context_get_encoder_for_format(ctx, heif_compression_HEVC, &encoder);
+        heif_image_handle* handle = nullptr;
+        if (err.code == heif_error_Ok) {
+            heif_encoder_set_lossy_quality(encoder, quality);
+            err = heif_context_encode_image(ctx, image, encoder, nullptr, &handle);
+            heif_encoder_release(encoder);
+        }
+        if (err.code == heif_error_Ok && !exif_date.empty()) {
+            const auto exif = make_exif(exif_date);
+            if (!exif.empty()) err = heif_context_add_exif_metadata(ctx, handle, exif.data(), static_cast<int>(exif.size()));
+        }
+        if (handle) heif_image_handle_release(handle);
+        if (err.code == heif_error_Ok)
+            err = heif_context_write_to_file(ctx, utils::path_to_utf8(file).c_str());
+
+        heif_context_free(ctx);
+        heif_image_release(image);
+        if (err.code != heif_error_Ok) return std::unexpected(std::format("libheif: {}", err.message));
+        return {};
+    }
+
+    std::expected<void, std::string> write_video(const fs::path& file, int width, int height,
+        int frames, int fps, const std::string& codec, std::uint32_t seed, const std::string& creation_time) {
+        const std::string name = utils::path_to_utf8(file);
+
+        /// @brief Owns every FFmpeg object so each early return cleans up.
+        struct Writer {
+            AVFormatContext* oc = nullptr;
+            AVCodecContext* enc = nullptr;
+            AVFrame* frame = nullptr;
+            AVPacket* pkt = nullptr;
+            ~Writer() {
+                av_packet_free(&pkt);
+                av_frame_free(&frame);
+                avcodec_free_context(&enc);
+                if (oc && oc->pb && !(oc->oformat->flags & AVFMT_NOFILE)) avio_closep(&oc->pb);
+                avformat_free_context(oc);
+            }
+        } w;
+
+        if (avformat_alloc_output_context2(&w.oc, nullptr, nullptr, name.c_str()) < 0 || !w.oc)
+            return std::unexpected(std::format("no container for {}", name));
+
+        if (!creation_time.empty()) av_dict_set(&w.oc->metadata, "creation_time", creation_time.c_str(), 0);
+
+        const AVCodec* codec_impl = avcodec_find_encoder_by_name(codec.c_str());
+        if (!codec_impl) return std::unexpected(std::format("encoder {} not available", codec));
+
+        AVStream* st = avformat_new_stream(w.oc, nullptr);
+        w.enc = avcodec_alloc_context3(codec_impl);
+        if (!st || !w.enc) return std::unexpected("cannot allocate stream");
+
+        w.enc->width = width;
+        w.enc->height = height;
+        w.enc->pix_fmt = AV_PIX_FMT_YUV420P;
+        w.enc->time_base = AVRational{ 1, fps };
+        w.enc->framerate = AVRational{ fps, 1 };
+        w.enc->gop_size = fps * 2;
+        if (w.oc->oformat->flags & AVFMT_GLOBALHEADER) w.enc->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+
+        if (avcodec_open2(w.enc, codec_impl, nullptr) < 0) return std::unexpected(std::format("cannot open encoder {}", codec));
+        if (avcodec_parameters_from_context(st->codecpar, w.enc) < 0) return std::unexpected("cannot copy codec parameters");
+        st->time_base = w.enc->time_base;
+
+        if (!(w.oc->oformat->flags & AVFMT_NOFILE) && avio_open(&w.oc->pb, name.c_str(), AVIO_FLAG_WRITE) < 0)
+            return std::unexpected(std::format("cannot create {}", name));
+        if (avformat_write_header(w.oc, nullptr) < 0) return std::unexpected("cannot write header");
+
+        w.frame = av_frame_alloc();
+        w.pkt = av_packet_alloc();
+        if (!w.frame || !w.pkt) return std::unexpected("out of memory");
+        w.frame->format = AV_PIX_FMT_YUV420P;
+        w.frame->width = width;
+        w.frame->height = height;
+        if (av_frame_get_buffer(w.frame, 0) < 0) return std::unexpected("cannot allocate frame");
+
+        const auto drain = [&]() -> bool {
+            while (true) {
+                int ret = avcodec_receive_packet(w.enc, w.pkt);
+                if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) return true;
+                if (ret < 0) return false;
+                av_packet_rescale_ts(w.pkt, w.enc->time_base, st->time_base);
+                w.pkt->stream_index = st->index;
+                if (av_interleaved_write_frame(w.oc, w.pkt) < 0) return false;
+            }
+        };
+
+        for (int i = 0; i < frames; ++i) {
+            if (av_frame_make_writable(w.frame) < 0) return std::unexpected("frame not writable");
+
+            // BT.601 RGB -> YUV420P; chroma from the top-left pixel of each 2x2 block.
+            const auto rgb = synthetic_rgb(width, height, seed, i);
+            for (int y = 0; y < height; ++y) {
+                for (int x = 0; x < width; ++x) {
+                    const std::uint8_t* p = rgb.data() + (static_cast<std::size_t>(y) * width + x) * 3;
+                    w.frame->data[0][y * w.frame->linesize[0] + x] = static_cast<std::uint8_t>((66 * p[0] + 129 * p[1] + 25 * p[2] + 128) / 256 + 16);
+                    if ((x | y) & 1) continue;
+                    w.frame->data[1][(y / 2) * w.frame->linesize[1] + x / 2] = static_cast<std::uint8_t>((-38 * p[0] - 74 * p[1] + 112 * p[2] + 128) / 256 + 128);
+                    w.frame->data[2][(y / 2) * w.frame->linesize[2] + x / 2] = static_cast<std::uint8_t>((112 * p[0] - 94 * p[1] - 18 * p[2] + 128) / 256 + 128);
+                }
+            }
+            w.frame->pts = i;
+
+            if (avcodec_send_frame(w.enc, w.frame) < 0 || !drain()) return std::unexpected("encoding failed");
+        }
+
+        if (avcodec_send_frame(w.enc, nullptr) < 0 || !drain()) return std::unexpected("encoder flush failed");
+        if (av_write_trailer(w.oc) < 0) return std::unexpected("cannot write trailer");
+        return {};
+    }
+
+} // namespace media_handler::tools
@@ -32,9 +32,25 @@ namespace media_handler::utils {
         app.add_option("-t,--threads", args.cfg.threads, "Threads");
         app.add_option("--crf", args.cfg.crf, "CRF quality");
         app.add_option("--preset", args.cfg.video_preset, "Preset");
+        app.add_option("--jpeg-mode", args.cfg.jpeg_mode, "JPEG: reencode, lossless, requantize or auto")->check(CLI::IsMember({ "reencode", "lossless", "requantize", "auto" }));
+        app.add_option("--jpeg-profile", args.cfg.jpeg_profile, "JPEG: fast, balanced or max-compression")->check(CLI::IsMember({ "fast", "balanced", "max-compression" }));
+        app.add_option("--jpeg-min-savings", args.cfg.jpeg_min_savings, "JPEG: copy unchanged when the predicted saving is below this fraction (0 = always compress)")->check(CLI::Range(0.0, 0.99));
+        app.add_option("--jpeg-target-ssim", args.cfg.jpeg_target_ssim, "JPEG: pick the quality per image to reach this luma SSIM (0 = fixed quality)")->check(CLI::Range(0.0, 0.9999));
+        app.add_option("--jpeg-target-bpp", args.cfg.jpeg_target_bpp, "JPEG: pick the quality per image to stay within this many bits per pixel (0 = fixed quality)")->check(CLI::Range(0.0, 24.0));
+        app.add_option("--jpeg-verify-ssim", args.cfg.jpeg_verify_ssim, "JPEG: re-encode or copy the source when the output's luma SSIM is below this (0 = no check)")->check(CLI::Range(0.0, 0.9999));
+        app.add_option("--jpeg-parallel-pixels", args.cfg.jpeg_parallel_pixels, "JPEG: encode images of at least this many pixels in parallel strips (0 = only when workers are idle)");
         app.add_flag("-j,--json", args.cfg.json_log, "JSON logging");
         app.add_flag("-r,--retry", args.retry_failed, "Retry failed");
         app.add_flag("--organize", args.organize_by_date, "Organize by date");
+        app.add_option("--metrics-file", args.cfg.metrics_file, "Prometheus textfile metrics path");
+        app.add_flag("--perf-counters", args.cfg.perf_counters, "Hardware performance counters per file/stage");
+        app.add_option("--heartbeat", args.cfg.heartbeat_interval, "Seconds between progress lines (0 = off)");
+        app.add_option("--report", args.cfg.report_file, "Per-file run report (.csv or NDJSON)");
+        app.add_option("--event-log", args.cfg.event_log, "Binary per-file event log");
+        app.add_option("--log-overflow", args.cfg.log_overflow, "Full log queue: block, drop-oldest or drop-new")->check(CLI::IsMember({ "block", "drop-oldest", "drop-new" }));
+        app.add_option("--control-socket", args.cfg.control_socket, "Unix socket for status, pause/resume, workers <n>, flush");
+        app.add_option("--bench", args.bench_runs, "Benchmark: N timed scan+migrate runs into a scratch output");
+        app.add_option("--bench-cache", args.bench_cache, "Bench input cache state per run")->check(CLI::IsMember({ "warm", "cold", "drop" }));
 
         // Handle log level with a temporary string for validation
         std::string log_level_str;
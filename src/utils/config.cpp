@@ -1,4 +1,5 @@
 ﻿#include "utils/config.h"
+#include "utils/utils.h"
 #include <filesystem>
 #include <expected>
 #include <fstream>
@@ -44,6 +45,17 @@ namespace media_handler::utils {
                 cfg.audio_bitrate = a.value("bitrate", cfg.audio_bitrate);
             }
 
+            if (j.contains("image") && j["image"].is_object()) {
+                const auto& i = j["image"];
+                cfg.jpeg_mode = i.value("jpeg_mode", cfg.jpeg_mode);
+                cfg.jpeg_profile = i.value("jpeg_profile", cfg.jpeg_profile);
+                cfg.jpeg_min_savings = i.value("jpeg_min_savings", cfg.jpeg_min_savings);
+                cfg.jpeg_target_ssim = i.value("jpeg_target_ssim", cfg.jpeg_target_ssim);
+                cfg.jpeg_target_bpp = i.value("jpeg_target_bpp", cfg.jpeg_target_bpp);
+                cfg.jpeg_verify_ssim = i.value("jpeg_verify_ssim", cfg.jpeg_verify_ssim);
+                cfg.jpeg_parallel_pixels = i.value("jpeg_parallel_pixels", cfg.jpeg_parallel_pixels);
+            }
+
             if (j.contains("general") && j["general"].is_object()) {
                 const auto& g = j["general"];
                 cfg.container = g.value("container", cfg.container);
@@ -51,6 +63,14 @@ namespace media_handler::utils {
                 cfg.output_dir = g.value("output_dir", cfg.output_dir);
                 cfg.threads = g.value("threads", cfg.threads);
                 cfg.json_log = g.value("json_log", cfg.json_log);
+                cfg.metrics_file = g.value("metrics_file", cfg.metrics_file);
+                cfg.metrics_interval = g.value("metrics_interval", cfg.metrics_interval);
+                cfg.heartbeat_interval = g.value("heartbeat_interval", cfg.heartbeat_interval);
+                cfg.perf_counters = g.value("perf_counters", cfg.perf_counters);
+                cfg.report_file = g.value("report_file", cfg.report_file);
+                cfg.event_log = g.value("event_log", cfg.event_log);
+                cfg.log_overflow = g.value("log_overflow", cfg.log_overflow);
+                cfg.control_socket = g.value("control_socket", cfg.control_socket);
 
                 if (g.contains("log_level")) {
                     cfg.log_level = spdlog::level::from_str(g.value("log_level", "info"));
@@ -69,10 +89,34 @@ namespace media_handler::utils {
         return cfg;
     }
 
+    std::optional<JpegMode> parse_jpeg_mode(std::string_view name) {
+        if (name == "reencode") return JpegMode::Reencode;
+        if (name == "lossless") return JpegMode::Lossless;
+        if (name == "requantize") return JpegMode::Requantize;
+        if (name == "auto") return JpegMode::Auto;
+        return std::nullopt;
+    }
+
+    std::optional<JpegProfile> parse_jpeg_profile(std::string_view name) {
+        if (name == "fast") return JpegProfile::Fast;
+        if (name == "balanced") return JpegProfile::Balanced;
+        if (name == "max-compression") return JpegProfile::MaxCompression;
+        return std::nullopt;
+    }
+
     std::expected<void, std::string> Config::validate() const {
         if (threads == 0) return std::unexpected("config.json: threads must be >= 1");
         if (input_dir.empty()) return std::unexpected("config.json: input_dir must not be empty");
         if (output_dir.empty()) return std::unexpected("config.json: output_dir must not be empty");
+        if (metrics_interval == 0) return std::unexpected("config.json: metrics_interval must be >= 1");
+        if (!parse_log_overflow(log_overflow)) return std::unexpected("config.json: log_overflow must be block, drop-oldest or drop-new");
+        if (!parse_jpeg_mode(jpeg_mode)) return std::unexpected("config.json: jpeg_mode must be reencode, lossless, requantize or auto");
+        if (!parse_jpeg_profile(jpeg_profile)) return std::unexpected("config.json: jpeg_profile must be fast, balanced or max-compression");
+        if (!(jpeg_min_savings >= 0.0 && jpeg_min_savings < 1.0)) return std::unexpected("config.json: jpeg_min_savings must be in [0, 1)");
+        if (!(jpeg_target_ssim >= 0.0 && jpeg_target_ssim < 1.0)) return std::unexpected("config.json: jpeg_target_ssim must be in [0, 1)");
+        if (!(jpeg_target_bpp >= 0.0 && jpeg_target_bpp <= 24.0)) return std::unexpected("config.json: jpeg_target_bpp must be in [0, 24]");
+        if (!(jpeg_verify_ssim >= 0.0 && jpeg_verify_ssim < 1.0)) return std::unexpected("config.json: jpeg_verify_ssim must be in [0, 1)");
+        if (jpeg_target_ssim > 0.0 && jpeg_target_bpp > 0.0) return std::unexpected("config.json: set jpeg_target_ssim or jpeg_target_bpp, not both");
         return {};
     }
 }
\ No newline at end of file
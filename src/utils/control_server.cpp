@@ -0,0 +1,213 @@
+#include "utils/control_server.h"
+#include "utils/utils.h"
+#include <cerrno>
+#include <cstring>
+#include <format>
+#include <optional>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace media_handler::utils {
+
+    namespace fs = std::filesystem;
+
+#ifndef _WIN32
+
+    namespace {
+        constexpr std::size_t MAX_COMMAND = 1024; // Longer lines are rejected.
+        constexpr int POLL_MS = 200; // How often the server thread checks for stop.
+        constexpr int CLIENT_TIMEOUT_MS = 2000; // A client that sends nothing is dropped after this.
+
+        std::expected<sockaddr_un, std::string> socket_address(const fs::path& path) {
+            sockaddr_un addr{};
+            addr.sun_family = AF_UNIX;
+            const auto s = path.string();
+            if (s.size() >= sizeof(addr.sun_path))
+                return std::unexpected(std::format("Control socket path too long ({} bytes, max {}): {}", s.size(), sizeof(addr.sun_path) - 1, s));
+            std::memcpy(addr.sun_path, s.c_str(), s.size() + 1);
+            return addr;
+        }
+
+        int connect_to(const sockaddr_un& addr) {
+            const int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            if (fd < 0) return -1;
+            if (::connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0) {
+                ::close(fd);
+                return -1;
+            }
+            return fd;
+        }
+
+        void set_timeouts(int fd) {
+            const timeval tv{ CLIENT_TIMEOUT_MS / 1000, (CLIENT_TIMEOUT_MS % 1000) * 1000 };
+            ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+            ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+        }
+
+        bool write_all(int fd, std::string_view data) {
+            while (!data.empty()) {
+                const auto n = ::send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+                if (n < 0 && errno == EINTR) continue;
+                if (n <= 0) return false;
+                data.remove_prefix(static_cast<std::size_t>(n));
+            }
+            return true;
+        }
+
+        /// @brief Read up to the first newline (or EOF). Empty on timeout, error or an over-long line.
+        std::optional<std::string> read_line(int fd) {
+            std::string line;
+            char buf[256];
+            while (line.size() <= MAX_COMMAND) {
+                const auto n = ::recv(fd, buf, sizeof(buf), 0);
+                if (n < 0 && errno == EINTR) continue;
+                if (n < 0) return std::nullopt;
+                if (n == 0) return line;
+                line.append(buf, static_cast<std::size_t>(n));
+                if (const auto nl = line.find('\n'); nl != std::string::npos) {
+                    line.resize(nl);
+                    if (!line.empty() && line.back() == '\r') line.pop_back();
+                    return line;
+                }
+            }
+            return std::nullopt;
+        }
+    }
+
+    std::expected<std::unique_ptr<ControlServer>, std::string> ControlServer::start(const fs::path& path,
+        Handler handler, std::shared_ptr<spdlog::logger> logger) {
+        auto addr = socket_address(path);
+        if (!addr) return std::unexpected(addr.error());
+
+        // A leftover socket file blocks bind(). Replace it unless a live server still answers on it.
+        std::error_code ec;
+        if (fs::is_socket(path, ec)) {
+            if (const int probe = connect_to(*addr); probe >= 0) {
+                ::close(probe);
+                return std::unexpected(std::format("Control socket {} is in use by another process", path_to_utf8(path)));
+            }
+            fs::remove(path, ec);
+        }
+        else if (fs::exists(path, ec)) {
+            return std::unexpected(std::format("Control socket path {} exists and is not a socket", path_to_utf8(path)));
+        }
+
+        const int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) return std::unexpected(std::format("Cannot create control socket: {}", std::strerror(errno)));
+
+        // Owner-only without touching the process umask, which other threads' files (metrics, event log) rely on.
+        // Linux creates the socket file with the fd's mode, so it never exists wider; chmod() covers other kernels.
+        ::fchmod(fd, S_IRUSR | S_IWUSR);
+        const int bound = ::bind(fd, reinterpret_cast<const sockaddr*>(&*addr), sizeof(*addr));
+        const int bind_errno = errno;
+        if (bound != 0 || ::chmod(addr->sun_path, S_IRUSR | S_IWUSR) != 0 || ::listen(fd, 8) != 0) {
+            const auto err = std::strerror(bound != 0 ? bind_errno : errno);
+            if (bound == 0) fs::remove(path, ec);
+            ::close(fd);
+            return std::unexpected(std::format("Cannot listen on control socket {}: {}", path_to_utf8(path), err));
+        }
+
+        return std::make_unique<ControlServer>(fd, path, std::move(handler), std::move(logger));
+    }
+
+    std::expected<std::string, std::string> ControlServer::request(const fs::path& path, std::string_view command) {
+        auto addr = socket_address(path);
+        if (!addr) return std::unexpected(addr.error());
+
+        const int fd = connect_to(*addr);
+        if (fd < 0) return std::unexpected(std::format("Cannot connect to {}: {}", path_to_utf8(path), std::strerror(errno)));
+        set_timeouts(fd);
+
+        std::string line(command);
+        line += '\n';
+        if (!write_all(fd, line)) {
+            ::close(fd);
+            return std::unexpected(std::format("Cannot send command: {}", std::strerror(errno)));
+        }
+        auto response = read_line(fd);
+        ::close(fd);
+        if (!response) return std::unexpected("No response from control socket");
+        return *response;
+    }
+
+    ControlServer::ControlServer(int fd, fs::path path, Handler handler, std::shared_ptr<spdlog::logger> logger)
+        : fd(fd)
+        , path(std::move(path))
+        , handler(std::move(handler))
+        , logger(std::move(logger))
+        , worker([this](std::stop_token st) { run(st); }) {
+        this->logger->info("Control socket listening on {}", path_to_utf8(this->path));
+    }
+
+    ControlServer::~ControlServer() {
+        worker.request_stop();
+        if (worker.joinable()) worker.join();
+        ::close(fd);
+        std::error_code ec;
+        fs::remove(path, ec);
+    }
+
+    void ControlServer::run(std::stop_token stop) {
+        pollfd pfd{ fd, POLLIN, 0 };
+        while (!stop.stop_requested()) {
+            const int ready = ::poll(&pfd, 1, POLL_MS);
+            if (ready <= 0) continue; // Timeout (check stop again) or EINTR.
+
+            const int client = ::accept(fd, nullptr, nullptr);
+            if (client < 0) continue;
+            ::fcntl(client, F_SETFD, FD_CLOEXEC);
+            serve(client);
+            ::close(client);
+        }
+    }
+
+    void ControlServer::serve(int client) {
+        set_timeouts(client);
+        auto command = read_line(client);
+        if (!command) {
+            write_all(client, R"({"ok": false, "error": "expected one command line"})" "\n");
+            return;
+        }
+
+        std::string response;
+        try {
+            response = handler(*command);
+        }
+        catch (const std::exception& e) {
+            logger->error("Control command '{}' failed: {}", *command, e.what());
+            response = R"({"ok": false, "error": "internal error"})";
+        }
+        logger->debug("Control: {} -> {}", *command, response);
+        response += '\n';
+        write_all(client, response);
+    }
+
+#else
+
+    std::expected<std::unique_ptr<ControlServer>, std::string> ControlServer::start(const fs::path&, Handler, std::shared_ptr<spdlog::logger>) {
+        return std::unexpected("Control socket is only supported on Unix-like systems");
+    }
+
+    std::expected<std::string, std::string> ControlServer::request(const fs::path&, std::string_view) {
+        return std::unexpected("Control socket is only supported on Unix-like systems");
+    }
+
+    ControlServer::ControlServer(int fd, fs::path path, Handler handler, std::shared_ptr<spdlog::logger> logger)
+        : fd(fd), path(std::move(path)), handler(std::move(handler)), logger(std::move(logger)) {}
+
+    ControlServer::~ControlServer() = default;
+
+    void ControlServer::run(std::stop_token) {}
+
+    void ControlServer::serve(int) {}
+
+#endif
+
+} // namespace media_handler::utils
@@ -0,0 +1,289 @@
+#include "utils/event_log.h"
+#include "utils/utils.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <format>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+
+namespace media_handler::utils {
+
+    namespace fs = std::filesystem;
+
+    namespace {
+        constexpr char MAGIC[8] = { 'M', 'H', 'E', 'V', 'L', 'O', 'G', '1' };
+
+        /// @brief File header: magic, then record size so a decoder can refuse a mismatched layout.
+        struct FileHeader {
+            char magic[8];
+            std::uint32_t version;
+            std::uint32_t record_size;
+        };
+
+        /// @brief Single-producer (owning worker) / single-consumer (drain thread) ring.
+        struct Ring {
+            static constexpr std::size_t MASK = EventLog::RING_RECORDS - 1;
+            static_assert((EventLog::RING_RECORDS & MASK) == 0, "ring size must be a power of two");
+
+            std::uint32_t thread = 0;
+            alignas(64) std::atomic<std::uint64_t> head{ 0 }; // Next slot to write; producer only.
+            alignas(64) std::atomic<std::uint64_t> tail{ 0 }; // Next slot to drain; consumer only.
+            std::unique_ptr<EventRecord[]> slots = std::make_unique<EventRecord[]>(EventLog::RING_RECORDS);
+        };
+
+        struct State {
+            std::mutex rings_mutex; // Guards rings and batch (registration and drain); never taken by emit().
+            std::vector<std::shared_ptr<Ring>> rings; // Kept after their thread exits until drained, then freed.
+            std::vector<EventRecord> batch; // One drain's records, merged by time before writing.
+            std::uint32_t next_thread = 1;
+
+            std::mutex control; // Serializes start()/stop().
+            FILE* out = nullptr;
+            std::jthread drainer;
+            std::atomic<std::uint64_t> written{ 0 };
+            std::atomic<std::uint64_t> dropped{ 0 };
+        };
+
+        State& state() {
+            static State s;
+            return s;
+        }
+
+        Ring& my_ring() {
+            thread_local std::shared_ptr<Ring> ring = [] {
+                auto r = std::make_shared<Ring>();
+                auto& s = state();
+                std::lock_guard lock(s.rings_mutex);
+                r->thread = s.next_thread++;
+                s.rings.push_back(r);
+                return r;
+            }();
+            return *ring;
+        }
+
+        /// @brief Write everything currently in the rings, in time order across threads, and free the rings
+        /// of threads that have exited. Only the drain thread (or stop()) calls this.
+        void drain(State& s) {
+            std::lock_guard lock(s.rings_mutex);
+            s.batch.clear();
+            for (auto& ring : s.rings) {
+                const auto t = ring->tail.load(std::memory_order_relaxed);
+                const auto h = ring->head.load(std::memory_order_acquire);
+                if (h == t) continue;
+
+                // At most two contiguous runs: up to the end of the array, then from its start.
+                const auto first = t & Ring::MASK;
+                const auto n = h - t;
+                const auto run1 = std::min<std::uint64_t>(n, EventLog::RING_RECORDS - first);
+                s.batch.insert(s.batch.end(), &ring->slots[first], &ring->slots[first] + run1);
+                if (n > run1) s.batch.insert(s.batch.end(), &ring->slots[0], &ring->slots[0] + (n - run1));
+
+                ring->tail.store(h, std::memory_order_release);
+            }
+
+            // Stable, so records of one thread stamped in the same nanosecond keep their emit order.
+            std::stable_sort(s.batch.begin(), s.batch.end(), [](const EventRecord& x, const EventRecord& y) { return x.time_ns < y.time_ns; });
+            std::fwrite(s.batch.data(), sizeof(EventRecord), s.batch.size(), s.out);
+            s.written.fetch_add(s.batch.size(), std::memory_order_relaxed);
+
+            // Only this list still holds the ring of an exited thread; once empty it is never written again.
+            std::erase_if(s.rings, [](const std::shared_ptr<Ring>& ring) {
+                return ring.use_count() == 1 && ring->head.load(std::memory_order_acquire) == ring->tail.load(std::memory_order_relaxed);
+                });
+        }
+
+        std::string_view text_of(const EventRecord& e) {
+            return { e.text, std::min<std::size_t>(e.text_len, sizeof(e.text)) };
+        }
+
+        std::string iso_time(std::uint64_t ns) {
+            using namespace std::chrono;
+            const sys_time<nanoseconds> t{ nanoseconds(ns) };
+            const auto day = floor<days>(t);
+            const year_month_day ymd{ day };
+            const hh_mm_ss tod{ floor<microseconds>(t - day) };
+            return std::format("{:04}-{:02}-{:02}T{:02}:{:02}:{:02}.{:06}Z",
+                static_cast<int>(ymd.year()), static_cast<unsigned>(ymd.month()), static_cast<unsigned>(ymd.day()),
+                tod.hours().count(), tod.minutes().count(), tod.seconds().count(), tod.subseconds().count());
+        }
+
+        const char* type_name(EventType t) {
+            switch (t) {
+            case EventType::FileStart: return "start";
+            case EventType::FileOk: return "ok";
+            case EventType::FileFail: return "fail";
+            case EventType::FileSkip: return "skip";
+            case EventType::VideoBitrate: return "video_bitrate";
+            case EventType::FilePassthrough: return "passthrough";
+            }
+            return "unknown";
+        }
+
+        void append_json_string(std::string& out, std::string_view s) {
+            out += '"';
+            for (unsigned char ch : s) {
+                if (ch == '"' || ch == '\\') { out += '\\'; out += static_cast<char>(ch); }
+                else if (ch < 0x20) out += std::format("\\u{:04x}", ch);
+                else out += static_cast<char>(ch);
+            }
+            out += '"';
+        }
+    }
+
+    bool EventLog::start(const fs::path& file, const std::shared_ptr<spdlog::logger>& logger) {
+        auto& s = state();
+        std::lock_guard lock(s.control);
+        if (s.out) return true;
+
+        s.out = fopen_path(file, "wb");
+        if (!s.out) {
+            logger->error("Cannot create event log {} - continuing without it", path_to_utf8(file));
+            return false;
+        }
+        std::setvbuf(s.out, nullptr, _IOFBF, 1 << 20);
+
+        FileHeader header{};
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = 1;
+        header.record_size = sizeof(EventRecord);
+        std::fwrite(&header, sizeof(header), 1, s.out);
+
+        // Records left over from an earlier session are discarded, not written into this file.
+        {
+            std::lock_guard rings_lock(s.rings_mutex);
+            for (auto& ring : s.rings) ring->tail.store(ring->head.load(std::memory_order_acquire), std::memory_order_release);
+        }
+        s.written = 0;
+        s.dropped = 0;
+
+        s.drainer = std::jthread([&s](std::stop_token st) {
+            std::mutex m;
+            std::condition_variable_any wake;
+            std::unique_lock lock(m);
+            while (!wake.wait_for(lock, st, std::chrono::milliseconds(10), [&st] { return st.stop_requested(); }))
+                drain(s);
+            });
+        active.store(true, std::memory_order_release);
+        logger->info("Writing binary event log to {}", path_to_utf8(file));
+        return true;
+    }
+
+    void EventLog::stop() {
+        auto& s = state();
+        std::lock_guard lock(s.control);
+        if (!s.out) return;
+
+        active.store(false, std::memory_order_release);
+        s.drainer.request_stop();
+        s.drainer.join();
+        drain(s); // Whatever was emitted before active went false.
+        std::fclose(s.out);
+        s.out = nullptr;
+    }
+
+    void EventLog::emit(EventType type, std::string_view text, std::uint64_t a, std::uint64_t b, std::uint32_t c, std::uint32_t d) {
+        if (!enabled()) return;
+        auto& ring = my_ring();
+
+        const auto h = ring.head.load(std::memory_order_relaxed);
+        if (h - ring.tail.load(std::memory_order_acquire) >= RING_RECORDS) {
+            state().dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        auto& e = ring.slots[h & Ring::MASK];
+        e.time_ns = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+        e.thread = ring.thread;
+        e.type = type;
+        e.a = a;
+        e.b = b;
+        e.c = c;
+        e.d = d;
+        // Keep the end of long names: it holds the distinguishing part and the extension.
+        if (text.size() > sizeof(e.text)) text.remove_prefix(text.size() - sizeof(e.text));
+        e.text_len = static_cast<std::uint16_t>(text.size());
+        std::memcpy(e.text, text.data(), text.size());
+
+        ring.head.store(h + 1, std::memory_order_release);
+    }
+
+    std::uint64_t EventLog::written() { return state().written.load(std::memory_order_relaxed); }
+
+    std::uint64_t EventLog::dropped() { return state().dropped.load(std::memory_order_relaxed); }
+
+    std::size_t EventLog::rings() {
+        auto& s = state();
+        std::lock_guard lock(s.rings_mutex);
+        return s.rings.size();
+    }
+
+    std::expected<std::vector<EventRecord>, std::string> read_events(const fs::path& file) {
+        FILE* in = fopen_path(file, "rb");
+        if (!in) return std::unexpected(std::format("Cannot open event log {}", path_to_utf8(file)));
+
+        FileHeader header{};
+        if (std::fread(&header, sizeof(header), 1, in) != 1 || std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+            std::fclose(in);
+            return std::unexpected(std::format("{} is not a media_handler event log", path_to_utf8(file)));
+        }
+        if (header.version != 1 || header.record_size != sizeof(EventRecord)) {
+            std::fclose(in);
+            return std::unexpected(std::format("Unsupported event log version {} (record size {})", header.version, header.record_size));
+        }
+
+        std::vector<EventRecord> events;
+        EventRecord e;
+        while (std::fread(&e, sizeof(e), 1, in) == 1) events.push_back(e);
+        std::fclose(in);
+        return events;
+    }
+
+    std::string format_event_text(const EventRecord& e) {
+        auto line = std::format("{} [T{}] ", iso_time(e.time_ns), e.thread);
+        switch (e.type) {
+        case EventType::FileStart: line += std::format("START {}", text_of(e)); break;
+        case EventType::FileOk:
+            line += std::format("OK    {} {:.1f}MB -> {:.1f}MB {}ms", text_of(e), e.a / 1'048'576.0, e.b / 1'048'576.0, e.c);
+            break;
+        case EventType::FileFail: line += std::format("FAIL  {} {:.1f}MB {}ms", text_of(e), e.a / 1'048'576.0, e.c); break;
+        case EventType::FileSkip: line += std::format("SKIP  {}", text_of(e)); break;
+        case EventType::FilePassthrough:
+            line += std::format("COPY  {} {:.1f}MB {}ms", text_of(e), e.a / 1'048'576.0, e.c);
+            break;
+        case EventType::VideoBitrate:
+            line += std::format("VIDEO source {}kbps -> target {}kbps max {}kbps", e.a, e.b, e.c);
+            break;
+        default: line += std::format("EVENT {} a={} b={} c={} d={}", static_cast<unsigned>(e.type), e.a, e.b, e.c, e.d); break;
+        }
+        return line;
+    }
+
+    std::string format_event_json(const EventRecord& e) {
+        std::string out = std::format(R"({{"timestamp": "{}", "thread": {}, "event": "{}")", iso_time(e.time_ns), e.thread, type_name(e.type));
+        switch (e.type) {
+        case EventType::FileOk:
+        case EventType::FilePassthrough:
+            out += std::format(R"(, "size_in": {}, "size_out": {}, "elapsed_ms": {})", e.a, e.b, e.c);
+            break;
+        case EventType::FileFail:
+            out += std::format(R"(, "size_in": {}, "elapsed_ms": {})", e.a, e.c);
+            break;
+        case EventType::VideoBitrate:
+            out += std::format(R"(, "source_kbps": {}, "target_kbps": {}, "max_kbps": {})", e.a, e.b, e.c);
+            break;
+        default: break;
+        }
+        if (e.text_len > 0) {
+            out += R"(, "file": )";
+            append_json_string(out, text_of(e));
+        }
+        out += '}';
+        return out;
+    }
+
+} // namespace media_handler::utils
@@ -0,0 +1,78 @@
+#include "utils/lock_stats.h"
+#include <algorithm>
+
+namespace media_handler::utils {
+
+    namespace {
+        /// @brief Name -> stats registry. Never shrinks, so pointers handed out stay valid.
+        struct Registry {
+            std::mutex m;
+            std::vector<std::shared_ptr<LockStats>> locks;
+        };
+    }
+
+    static Registry& registry() {
+        static Registry r;
+        return r;
+    }
+
+    std::shared_ptr<LockStats> LockStats::get(const std::string& name) {
+        auto& [m, locks] = registry();
+        std::lock_guard lock(m);
+        auto it = std::find_if(locks.begin(), locks.end(), [&](const auto& s) { return s->name == name; });
+        if (it != locks.end()) return *it;
+        return locks.emplace_back(std::make_shared<LockStats>(name));
+    }
+
+    std::vector<LockStats::Snapshot> LockStats::all() {
+        auto& [m, locks] = registry();
+        std::lock_guard lock(m);
+        std::vector<Snapshot> out;
+        for (const auto& s : locks) {
+            auto snap = s->snapshot();
+            if (snap.acquisitions > 0) out.push_back(std::move(snap));
+        }
+        return out;
+    }
+
+    void LockStats::reset_all() {
+        auto& [m, locks] = registry();
+        std::lock_guard lock(m);
+        for (const auto& s : locks) s->reset();
+    }
+
+    void LockStats::record_acquire(std::chrono::nanoseconds waited, bool was_contended) {
+        acquisitions.fetch_add(1, std::memory_order_relaxed);
+        if (!was_contended) return;
+
+        contended.fetch_add(1, std::memory_order_relaxed);
+        const auto ns = waited.count();
+        wait_ns.fetch_add(ns, std::memory_order_relaxed);
+        auto prev = max_wait_ns.load(std::memory_order_relaxed);
+        while (prev < ns && !max_wait_ns.compare_exchange_weak(prev, ns, std::memory_order_relaxed)) {}
+    }
+
+    void LockStats::record_hold(std::chrono::nanoseconds held) {
+        hold_ns.fetch_add(held.count(), std::memory_order_relaxed);
+    }
+
+    LockStats::Snapshot LockStats::snapshot() const {
+        Snapshot s;
+        s.name = name;
+        s.acquisitions = acquisitions.load(std::memory_order_relaxed);
+        s.contended = contended.load(std::memory_order_relaxed);
+        s.wait = std::chrono::nanoseconds(wait_ns.load(std::memory_order_relaxed));
+        s.max_wait = std::chrono::nanoseconds(max_wait_ns.load(std::memory_order_relaxed));
+        s.hold = std::chrono::nanoseconds(hold_ns.load(std::memory_order_relaxed));
+        return s;
+    }
+
+    void LockStats::reset() {
+        acquisitions = 0;
+        contended = 0;
+        wait_ns = 0;
+        max_wait_ns = 0;
+        hold_ns = 0;
+    }
+
+} // namespace media_handler::utils
@@ -11,8 +11,13 @@
 #include <spdlog/sinks/stdout_color_sinks.h>
 #include <spdlog/sinks/basic_file_sink.h>
 #include <spdlog/async.h>
+#include <spdlog/pattern_formatter.h>
+#include <algorithm>
 #include <filesystem>
+#include <format>
 #include "utils/utils.h"
+#include "utils/lock_stats.h"
+#include "utils/log_event.h"
 
 namespace fs = std::filesystem;
 
@@ -65,13 +70,176 @@ namespace media_handler::utils {
 
 	// Logger implementation
 
+	namespace {
+		constexpr std::size_t QUEUE_SIZE = 8192; // Messages, shared by every logger.
+
+		std::atomic<LogOverflow> overflow{ LogOverflow::Block };
+		std::atomic<std::uint64_t> dropped_new{ 0 };
+	}
+
+	std::optional<LogOverflow> parse_log_overflow(std::string_view name) {
+		if (name == "block") return LogOverflow::Block;
+		if (name == "drop-oldest") return LogOverflow::DropOldest;
+		if (name == "drop-new") return LogOverflow::DropNew;
+		return std::nullopt;
+	}
+
+	/// @brief JSON lines written field by field straight into the sink's buffer: every string is escaped, and the
+	/// fields of a LogEvent become top-level keys. Timestamps are UTC; the date part is rebuilt once per second.
+	class JsonFormatter final : public spdlog::formatter {
+	public:
+		void format(const spdlog::details::log_msg& msg, spdlog::memory_buf_t& dest) override {
+			std::string_view fields;
+			std::string_view message(msg.payload.data(), msg.payload.size());
+			LogEvent::split(message, fields, message);
+
+			JsonWriter json(dest);
+			json.raw("{");
+			json.key("timestamp");
+			write_time(msg.time, json);
+			json.key("level");
+			const auto level = spdlog::level::to_string_view(msg.level);
+			json.string(std::string_view(level.data(), level.size()));
+			json.key("thread");
+			json.raw("\"");
+			json.number(msg.thread_id);
+			json.raw("\"");
+			json.key("file");
+			json.raw("\"");
+			if (!msg.source.empty()) {
+				json.escaped(msg.source.filename);
+				json.raw(":");
+				json.number(msg.source.line);
+			}
+			json.raw("\"");
+			json.key("message");
+			json.string(message);
+			if (!fields.empty()) {
+				json.raw(", ");
+				json.raw(fields);
+			}
+			json.raw("}");
+			json.raw(spdlog::details::os::default_eol);
+		}
+
+		std::unique_ptr<spdlog::formatter> clone() const override { return std::make_unique<JsonFormatter>(); }
+
+	private:
+		void write_time(spdlog::log_clock::time_point time, JsonWriter<spdlog::memory_buf_t>& json) {
+			using namespace std::chrono;
+			const auto secs = floor<seconds>(time);
+			if (secs != cached_second) {
+				const auto day = floor<days>(secs);
+				const year_month_day ymd{ day };
+				const hh_mm_ss tod{ secs - day };
+				const auto r = std::format_to_n(cached_date, sizeof(cached_date), "{:04}-{:02}-{:02}T{:02}:{:02}:{:02}",
+					static_cast<int>(ymd.year()), static_cast<unsigned>(ymd.month()), static_cast<unsigned>(ymd.day()),
+					tod.hours().count(), tod.minutes().count(), tod.seconds().count());
+				cached_len = static_cast<std::size_t>(r.size);
+				cached_second = secs;
+			}
+			const auto ms = duration_cast<milliseconds>(time - secs).count();
+			const char frac[6] = { '.', static_cast<char>('0' + ms / 100), static_cast<char>('0' + ms / 10 % 10), static_cast<char>('0' + ms % 10), 'Z', '"' };
+			json.raw("\"");
+			json.raw(std::string_view(cached_date, cached_len));
+			json.raw(std::string_view(frac, sizeof(frac)));
+		}
+
+		spdlog::log_clock::time_point cached_second{};
+		char cached_date[32] = {};
+		std::size_t cached_len = 0;
+	};
+
+	/// @brief The text pattern, applied to the message part of a LogEvent (its fields are for the JSON log).
+	class TextFormatter final : public spdlog::formatter {
+	public:
+		explicit TextFormatter(std::string pattern)
+			: pattern(std::move(pattern))
+			, inner(std::make_unique<spdlog::pattern_formatter>(this->pattern)) {}
+
+		void format(const spdlog::details::log_msg& msg, spdlog::memory_buf_t& dest) override {
+			std::string_view fields, message;
+			if (!LogEvent::split(std::string_view(msg.payload.data(), msg.payload.size()), fields, message)) {
+				inner->format(msg, dest);
+				return;
+			}
+			auto copy = msg;
+			copy.payload = spdlog::string_view_t(message.data(), message.size());
+			inner->format(copy, dest);
+		}
+
+		std::unique_ptr<spdlog::formatter> clone() const override { return std::make_unique<TextFormatter>(pattern); }
+
+	private:
+		std::string pattern;
+		std::unique_ptr<spdlog::pattern_formatter> inner;
+	};
+
+	auto Logger::formatter(bool json_format) -> std::unique_ptr<spdlog::formatter> {
+		if (json_format) return std::make_unique<JsonFormatter>();
+		return std::make_unique<TextFormatter>("[%Y-%m-%d %H:%M:%S.%e] [%^%l%$] [%t] [%s:%#] %v");
+	}
+
+	/// @brief Front end that times the enqueue into spdlog's async queue (async_logger is final, so it is wrapped).
+	/// With async_overflow_policy::block a full queue stalls the calling worker; that time is reported
+	/// as the "log queue" lock. Shares the async logger's sinks so sinks() and set_pattern() still apply.
+	/// An async_logger's overflow policy is fixed, so there is one backend per policy and the current
+	/// LogOverflow picks between them; both post to the same queue, which keeps messages in order.
+	class TimedAsyncLogger final : public spdlog::logger {
+	public:
+		TimedAsyncLogger(std::shared_ptr<spdlog::async_logger> blocking, std::shared_ptr<spdlog::details::thread_pool> pool)
+			: spdlog::logger(blocking->name(), blocking->sinks().begin(), blocking->sinks().end())
+			, blocking(std::move(blocking))
+			, overwriting(std::make_shared<spdlog::async_logger>(name(), sinks().begin(), sinks().end(), pool, spdlog::async_overflow_policy::overrun_oldest))
+			, pool(std::move(pool))
+			, queue(LockStats::get("log queue")) {
+			// Level filtering happens here.
+			this->blocking->set_level(spdlog::level::trace);
+			overwriting->set_level(spdlog::level::trace);
+		}
+
+	protected:
+		void sink_it_(const spdlog::details::log_msg& msg) override {
+			const auto policy = overflow.load(std::memory_order_relaxed);
+			// drop-new checks for room first; if another thread takes the last slot in between, the oldest
+			// message is overwritten instead, so the caller still never waits.
+			if (policy == LogOverflow::DropNew && pool->queue_size() >= QUEUE_SIZE) {
+				dropped_new.fetch_add(1, std::memory_order_relaxed);
+				return;
+			}
+
+			const auto t0 = std::chrono::steady_clock::now();
+			backend(policy).log(msg.time, msg.source, msg.level, msg.payload);
+			const auto waited = std::chrono::steady_clock::now() - t0;
+			// A free slot costs well under a microsecond; anything slower waited on the backend thread.
+			queue->record_acquire(waited, waited > BLOCKED_ENQUEUE);
+
+			if (should_flush_(msg)) flush_(); // flush_on() is honoured inside logger::sink_it_, which this replaces.
+		}
+
+		// A flush request is queued like a message, so it follows the same policy.
+		void flush_() override { backend(overflow.load(std::memory_order_relaxed)).flush(); }
+
+	private:
+		static constexpr auto BLOCKED_ENQUEUE = std::chrono::microseconds(20);
+
+		spdlog::async_logger& backend(LogOverflow policy) {
+			return policy == LogOverflow::Block ? *blocking : *overwriting;
+		}
+
+		std::shared_ptr<spdlog::async_logger> blocking;
+		std::shared_ptr<spdlog::async_logger> overwriting;
+		std::shared_ptr<spdlog::details::thread_pool> pool;
+		std::shared_ptr<LockStats> queue;
+	};
+
 	auto Logger::create(const std::string& name, spdlog::level::level_enum level, bool json_format) -> std::shared_ptr<spdlog::logger> {
 		std::filesystem::create_directories(log_dir);
 
 		//spdlog::init_thread_pool(8192, 1); //Queue size, thread count
 		static std::once_flag flag;
 		std::call_once(flag, [] {
-			spdlog::init_thread_pool(8192, 1); // queue size, thread count
+			spdlog::init_thread_pool(QUEUE_SIZE, 1); // queue size, thread count
 			});
 
 		// Reuse existing logger if present
@@ -85,14 +253,11 @@ namespace media_handler::utils {
 		std::string file_name = json_format ? log_dir + "/media_handler.json" : log_dir + "/media_handler.log";
 		auto file_sink = std::make_shared<spdlog::sinks::basic_file_sink_mt>(file_name, true);
 
-		std::string pattern = json_format ?
-			R"({"timestamp": "%Y-%m-%dT%H:%M:%S.%eZ", "level": "%l", "thread": "%t", "file": "%s:%#", "message": "%v"})"
-			: "[%Y-%m-%d %H:%M:%S.%e] [%^%l%$] [%t] [%s:%#] %v";
+		console_sink->set_formatter(formatter(json_format));
+		file_sink->set_formatter(formatter(json_format));
 
-		console_sink->set_pattern(pattern);
-		file_sink->set_pattern(pattern);
-
-		auto logger = std::make_shared<spdlog::async_logger>(name, spdlog::sinks_init_list{console_sink, file_sink}, spdlog::thread_pool(), spdlog::async_overflow_policy::block);
+		auto backend = std::make_shared<spdlog::async_logger>(name, spdlog::sinks_init_list{console_sink, file_sink}, spdlog::thread_pool(), spdlog::async_overflow_policy::block);
+		auto logger = std::make_shared<TimedAsyncLogger>(std::move(backend), spdlog::thread_pool());
 		spdlog::register_logger(logger);
 
 		logger->set_level(level);
@@ -111,4 +276,46 @@ namespace media_handler::utils {
 		spdlog::apply_all([](std::shared_ptr<spdlog::logger> l) { l->flush(); });
 	}
 
+	bool Logger::structured(const spdlog::logger& logger) {
+		return dynamic_cast<const TimedAsyncLogger*>(&logger) != nullptr;
+	}
+
+	void Logger::set_overflow(LogOverflow policy) {
+		overflow.store(policy, std::memory_order_relaxed);
+	}
+
+	auto Logger::drops() -> Drops {
+		Drops d;
+		if (auto pool = spdlog::thread_pool()) d.oldest = pool->overrun_counter();
+		d.newest = dropped_new.load(std::memory_order_relaxed);
+		d.suppressed = LogSite::suppressed_total();
+		return d;
+	}
+
+	// LogSite implementation
+
+	LogSite::LogSite(std::uint32_t burst, double per_second)
+		: interval_ns(static_cast<std::int64_t>(1e9 / std::max(per_second, 1e-6)))
+		, window_ns(interval_ns * (std::max<std::uint32_t>(burst, 1) - 1)) {}
+
+	std::optional<std::uint64_t> LogSite::allow() {
+		const std::int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+		auto next = next_ns.load(std::memory_order_relaxed);
+		for (;;) {
+			const auto start = std::max(next, now);
+			if (start - now > window_ns) {
+				pending.fetch_add(1, std::memory_order_relaxed);
+				total.fetch_add(1, std::memory_order_relaxed);
+				return std::nullopt;
+			}
+			if (next_ns.compare_exchange_weak(next, start + interval_ns, std::memory_order_relaxed)) break;
+		}
+		return pending.exchange(0, std::memory_order_relaxed);
+	}
+
+	std::string LogSite::note(std::uint64_t suppressed) {
+		return suppressed > 0 ? std::format(" ({} similar suppressed)", suppressed) : std::string();
+	}
+
 } // namespace media_handler::utils
\ No newline at end of file
@@ -0,0 +1,134 @@
+#include "utils/metrics_exporter.h"
+#include "utils/utils.h"
+#include <fstream>
+#include <format>
+#include <iterator>
+#include <algorithm>
+
+namespace media_handler::utils {
+
+    namespace fs = std::filesystem;
+
+    MetricsExporter::MetricsExporter(const ProgressTracker& tracker, fs::path file, std::chrono::seconds interval, std::shared_ptr<spdlog::logger> logger)
+        : tracker(tracker)
+        , file(std::move(file))
+        , interval(interval.count() > 0 ? interval : std::chrono::seconds(1))
+        , logger(std::move(logger))
+        , worker([this](std::stop_token st) { run(st); }) {
+    }
+
+    MetricsExporter::~MetricsExporter() {
+        worker.request_stop();
+        if (worker.joinable()) worker.join();
+        write(); // Final values once all workers are done.
+    }
+
+    void MetricsExporter::run(std::stop_token stop) {
+        std::unique_lock lock(mutex);
+        while (!stop.stop_requested()) {
+            lock.unlock();
+            write();
+            lock.lock();
+            cv.wait_for(lock, stop, interval, [] { return false; });
+        }
+    }
+
+    void MetricsExporter::write() const {
+        auto tmp = file;
+        tmp += ".tmp"; // Not *.prom, so the collector never picks up a partial file.
+
+        std::lock_guard lock(write_mutex);
+        try {
+            {
+                std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+                if (!f) { logger->warn("Cannot write metrics: {}", path_to_utf8(tmp)); return; }
+                f << render(tracker.snapshot());
+                f.close();
+                // ENOSPC, EIO: keep the last good file rather than commit a partial one.
+                if (!f) { logger->warn("Metrics write failed: {}", path_to_utf8(tmp)); return; }
+            }
+            std::error_code ec;
+            fs::rename(tmp, file, ec);
+            if (ec) logger->warn("Metrics commit failed: {}", ec.message());
+        }
+        catch (const std::exception& e) {
+            logger->warn("Exception writing metrics: {}", e.what());
+        }
+    }
+
+    std::string MetricsExporter::render(const ProgressTracker::Snapshot& s) {
+        std::string out;
+        auto it = std::back_inserter(out);
+
+        auto histogram = [&it](const char* name, const char* labels, const LatencyHistogram::Snapshot& h) {
+            const std::string sep = *labels ? "," : "";
+            std::uint64_t cumulative = 0;
+            for (std::size_t i = 0; i < LatencyHistogram::bounds.size(); ++i) {
+                cumulative += h.buckets[i];
+                std::format_to(it, "{}_bucket{{{}{}le=\"{}\"}} {}\n", name, labels, sep, LatencyHistogram::bounds[i], cumulative);
+            }
+            cumulative += h.buckets.back();
+            std::format_to(it, "{}_bucket{{{}{}le=\"+Inf\"}} {}\n", name, labels, sep, cumulative);
+            std::format_to(it, "{}_sum{{{}}} {:.6f}\n", name, labels, h.sum_seconds);
+            std::format_to(it, "{}_count{{{}}} {}\n", name, labels, h.count);
+            };
+
+        std::format_to(it, "# HELP media_handler_files_total Files finished, by outcome.\n");
+        std::format_to(it, "# TYPE media_handler_files_total counter\n");
+        std::format_to(it, "media_handler_files_total{{outcome=\"ok\"}} {}\n", s.completed);
+        std::format_to(it, "media_handler_files_total{{outcome=\"failed\"}} {}\n", s.failed);
+        std::format_to(it, "media_handler_files_total{{outcome=\"skipped\"}} {}\n", s.skipped);
+        std::format_to(it, "media_handler_files_total{{outcome=\"passthrough\"}} {}\n", s.passthrough);
+
+        std::format_to(it, "# HELP media_handler_files_planned Files scheduled for this run.\n");
+        std::format_to(it, "# TYPE media_handler_files_planned gauge\n");
+        std::format_to(it, "media_handler_files_planned {}\n", s.total);
+
+        std::format_to(it, "# HELP media_handler_bytes_in_total Input bytes of successfully compressed files.\n");
+        std::format_to(it, "# TYPE media_handler_bytes_in_total counter\n");
+        std::format_to(it, "media_handler_bytes_in_total {}\n", s.bytes_in);
+        std::format_to(it, "# HELP media_handler_bytes_out_total Output bytes of successfully compressed files.\n");
+        std::format_to(it, "# TYPE media_handler_bytes_out_total counter\n");
+        std::format_to(it, "media_handler_bytes_out_total {}\n", s.bytes_out);
+
+        std::format_to(it, "# HELP media_handler_bytes_planned Input bytes scheduled for this run.\n");
+        std::format_to(it, "# TYPE media_handler_bytes_planned gauge\n");
+        std::format_to(it, "media_handler_bytes_planned {}\n", s.bytes_planned);
+        std::format_to(it, "# HELP media_handler_bytes_processed_total Input bytes finished, any outcome.\n");
+        std::format_to(it, "# TYPE media_handler_bytes_processed_total counter\n");
+        std::format_to(it, "media_handler_bytes_processed_total {}\n", s.bytes_done);
+
+        std::format_to(it, "# HELP media_handler_processing_seconds Per-file processing time, by media kind.\n");
+        std::format_to(it, "# TYPE media_handler_processing_seconds histogram\n");
+        for (std::size_t k = 0; k < media_kind_count; ++k) {
+            auto labels = std::format("kind=\"{}\"", to_string(static_cast<MediaKind>(k)));
+            histogram("media_handler_processing_seconds", labels.c_str(), s.processing_time[k]);
+        }
+
+        std::format_to(it, "# HELP media_handler_cpu_seconds_total CPU time spent on files (worker + attributed codec threads), by media kind.\n");
+        std::format_to(it, "# TYPE media_handler_cpu_seconds_total counter\n");
+        for (std::size_t k = 0; k < media_kind_count; ++k)
+            std::format_to(it, "media_handler_cpu_seconds_total{{kind=\"{}\"}} {:.3f}\n", to_string(static_cast<MediaKind>(k)), s.cpu_seconds[k]);
+
+        std::format_to(it, "# HELP media_handler_queue_depth Files waiting in the work queue.\n");
+        std::format_to(it, "# TYPE media_handler_queue_depth gauge\n");
+        std::format_to(it, "media_handler_queue_depth {}\n", s.queue_depth);
+
+        const auto busy = std::min(s.busy_workers, s.workers);
+        std::format_to(it, "# HELP media_handler_workers Worker threads, by state.\n");
+        std::format_to(it, "# TYPE media_handler_workers gauge\n");
+        std::format_to(it, "media_handler_workers{{state=\"busy\"}} {}\n", busy);
+        std::format_to(it, "media_handler_workers{{state=\"idle\"}} {}\n", s.workers - busy);
+
+        std::format_to(it, "# HELP media_handler_state_commit_seconds Time to persist run state (lock wait + save).\n");
+        std::format_to(it, "# TYPE media_handler_state_commit_seconds histogram\n");
+        histogram("media_handler_state_commit_seconds", "", s.state_commit);
+
+        std::format_to(it, "# HELP media_handler_uptime_seconds Seconds since the run started.\n");
+        std::format_to(it, "# TYPE media_handler_uptime_seconds gauge\n");
+        std::format_to(it, "media_handler_uptime_seconds {:.3f}\n", std::chrono::duration<double>(s.uptime).count());
+
+        return out;
+    }
+
+} // namespace media_handler::utils
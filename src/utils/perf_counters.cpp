@@ -0,0 +1,122 @@
+#include "utils/perf_counters.h"
+#include <atomic>
+#include <array>
+#include <cerrno>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+
+namespace media_handler::utils {
+
+    static std::atomic<bool> perf_enabled{ false };
+
+#ifdef __linux__
+    static int perf_event_open(perf_event_attr* attr, int group_fd) {
+        // pid 0 + cpu -1: the calling thread, on whichever CPU it runs.
+        return static_cast<int>(syscall(SYS_perf_event_open, attr, 0, -1, group_fd, 0));
+    }
+
+    /// @brief One counter group per thread; members that fail to open are skipped.
+    class ThreadCounters {
+    public:
+        ThreadCounters() {
+            static constexpr std::array<std::uint64_t, 4> configs = {
+                PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES
+            };
+
+            for (std::size_t i = 0; i < configs.size(); ++i) {
+                perf_event_attr attr{};
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.size = sizeof(attr);
+                attr.config = configs[i];
+                attr.read_format = PERF_FORMAT_GROUP;
+                attr.exclude_kernel = 1; // Allowed at perf_event_paranoid <= 2.
+                attr.exclude_hv = 1;
+                attr.disabled = leader < 0 ? 1 : 0;
+
+                int fd = perf_event_open(&attr, leader);
+                if (fd < 0) {
+                    if (leader < 0) { error = errno; return; } // No cycles counter: give up on this thread.
+                    continue;
+                }
+                if (leader < 0) leader = fd;
+                slot[count] = i;
+                fds[count++] = fd;
+            }
+
+            ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+            ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        }
+
+        ~ThreadCounters() {
+            for (std::size_t i = 0; i < count; ++i) close(fds[i]);
+        }
+
+        ThreadCounters(const ThreadCounters&) = delete;
+        ThreadCounters& operator=(const ThreadCounters&) = delete;
+
+        bool ok() const { return leader >= 0; }
+        int last_error() const { return error; }
+
+        PerfValues read() const {
+            PerfValues v;
+            if (leader < 0) return v;
+
+            // PERF_FORMAT_GROUP layout: nr, then one value per member in open order.
+            std::array<std::uint64_t, 1 + 4> buf{};
+            if (::read(leader, buf.data(), sizeof(buf)) <= 0) return v;
+
+            std::uint64_t* fields[] = { &v.cycles, &v.instructions, &v.cache_misses, &v.branch_misses };
+            for (std::size_t i = 0; i < count && i < buf[0]; ++i) *fields[slot[i]] = buf[1 + i];
+            return v;
+        }
+
+    private:
+        int leader = -1;
+        int error = 0;
+        std::array<int, 4> fds{};
+        std::array<std::size_t, 4> slot{};
+        std::size_t count = 0;
+    };
+
+    static ThreadCounters& thread_counters() {
+        thread_local ThreadCounters counters;
+        return counters;
+    }
+#endif
+
+    bool PerfCounters::enable(const std::shared_ptr<spdlog::logger>& logger) {
+#ifdef __linux__
+        const auto& probe = thread_counters();
+        if (!probe.ok()) {
+            logger->warn("Perf counters unavailable ({}); check /proc/sys/kernel/perf_event_paranoid or container seccomp policy",
+                std::strerror(probe.last_error()));
+            return false;
+        }
+        perf_enabled = true;
+        logger->info("Perf counters enabled (cycles, instructions, cache misses, branch misses)");
+        return true;
+#else
+        logger->warn("Perf counters are only supported on Linux");
+        return false;
+#endif
+    }
+
+    bool PerfCounters::enabled() {
+        return perf_enabled.load(std::memory_order_relaxed);
+    }
+
+    PerfValues PerfCounters::read() {
+#ifdef __linux__
+        if (enabled()) return thread_counters().read();
+#endif
+        return {};
+    }
+
+} // namespace media_handler::utils
@@ -1,11 +1,39 @@
 #include "utils/progress_tracker.h"
 #include "utils/utils.h"
+#include "utils/work_context.h"
+#include "utils/run_report.h"
+#include "utils/event_log.h"
+#include "utils/log_event.h"
 #include <format>
+#include <algorithm>
 
 namespace media_handler::utils {
 
     namespace fs = std::filesystem;
 
+    // Weight kept by the previous throughput estimate each time a file finishes.
+    static constexpr double RATE_DECAY = 0.95;
+
+    // In-flight files listed by name in a heartbeat line.
+    static constexpr std::size_t HEARTBEAT_MAX_IN_FLIGHT = 3;
+
+    /// @brief "1h 2m 3s" / "2m 3s" / "3s"
+    static std::string format_duration(long long s) {
+        long long mins = s / 60; s %= 60;
+        long long hrs = mins / 60; mins %= 60;
+        return hrs > 0 ? std::format("{}h {}m {}s", hrs, mins, s)
+            : mins > 0 ? std::format("{}m {}s", mins, s)
+            : std::format("{}s", s);
+    }
+
+    const char* to_string(MediaKind kind) {
+        switch (kind) {
+        case MediaKind::Image: return "image";
+        case MediaKind::Video: return "video";
+        default:               return "other";
+        }
+    }
+
     ProgressTracker::ProgressTracker(std::size_t total_files, std::shared_ptr<spdlog::logger> logger)
         : total(total_files)
         , logger(std::move(logger))
@@ -13,50 +41,125 @@ namespace media_handler::utils {
         std::lock_guard lock(mutex);
         stats.reserve(total_files);
         start_times.reserve(total_files);
+        start_usage.reserve(total_files);
     }
 
-    std::size_t ProgressTracker::begin_file(const fs::path& file) {
+    std::size_t ProgressTracker::begin_file(const fs::path& file, MediaKind kind) {
+        WorkContext::current().reset();
+        auto usage = ResourceSample::now();
+
         std::lock_guard lock(mutex);
         FileStats s;
         s.filename = path_to_utf8(file.filename());
+        s.path = path_to_utf8(file);
+        s.kind = kind;
         std::error_code ec;
         s.size_in = fs::file_size(file, ec);
 
+        EventLog::emit(EventType::FileStart, s.filename);
+
         std::size_t token = stats.size();
         stats.push_back(std::move(s));
         start_times.push_back(std::chrono::steady_clock::now());
+        start_usage.push_back(usage);
+        in_flight.insert(token);
 
         return token;
     }
 
-    void ProgressTracker::finish_file(std::size_t token, const fs::path& output, bool success, const std::string& error) {
+    void ProgressTracker::add_planned(MediaKind kind, std::uintmax_t bytes) {
+        planned_bytes[static_cast<std::size_t>(kind)].fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    void ProgressTracker::finish_file(std::size_t token, const fs::path& output, bool success, const std::string& error, bool passthrough) {
 
         auto now = std::chrono::steady_clock::now();
+        auto usage = ResourceSample::now();
+        const auto& ctx = WorkContext::current();
 
-        const bool is_skipped = success && !error.empty();
+        const bool is_passthrough = success && passthrough;
+        const bool is_skipped = success && !error.empty() && !passthrough;
 
         {
             std::lock_guard lock(mutex);
             auto& s = stats[token];
+            const auto& u0 = start_usage[token];
             s.elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - start_times[token]);
+            s.cpu_time = (usage.cpu - u0.cpu) + ctx.attributed_cpu;
+            s.io_read = usage.read_bytes - u0.read_bytes;
+            s.io_written = usage.write_bytes - u0.write_bytes;
+            s.peak_rss_delta = usage.peak_rss - u0.peak_rss;
+            s.perf = usage.perf - u0.perf;
+            s.pixels = ctx.pixels;
+            s.frames = ctx.frames;
+            s.ssim = ctx.ssim;
+            for (std::size_t st = 0; st < stage_count; ++st) s.stage_wall[st] = ctx.stages[st].wall;
             s.success = success;
             s.skipped = is_skipped;
+            s.passthrough = is_passthrough;
             s.error = error;
 
             if (success) {
                 std::error_code ec;
                 s.size_out = fs::file_size(output, ec);
             }
+
+            in_flight.erase(token);
+            EventLog::emit(is_skipped ? EventType::FileSkip : is_passthrough ? EventType::FilePassthrough : success ? EventType::FileOk : EventType::FileFail,
+                s.filename, s.size_in, s.size_out, static_cast<std::uint32_t>(s.elapsed.count()));
+            const auto k = static_cast<std::size_t>(s.kind);
+            done_bytes[k].fetch_add(s.size_in, std::memory_order_relaxed);
+
+            if (!is_skipped) {
+                const auto took = now - start_times[token];
+                processing_time[k].observe(took);
+                cpu_ns[k].fetch_add(static_cast<std::uint64_t>(s.cpu_time.count()), std::memory_order_relaxed);
+                for (std::size_t st = 0; st < stage_count; ++st) {
+                    stage_totals[k][st].wall += ctx.stages[st].wall;
+                    stage_totals[k][st].perf += ctx.stages[st].perf;
+                }
+
+                // Byte-weighted so one large video counts for more than many tiny photos.
+                rates[k].bytes = rates[k].bytes * RATE_DECAY + static_cast<double>(s.size_in);
+                rates[k].seconds = rates[k].seconds * RATE_DECAY + std::chrono::duration<double>(took).count();
+
+                if (success) {
+                    bytes_in.fetch_add(s.size_in, std::memory_order_relaxed);
+                    bytes_out.fetch_add(s.size_out, std::memory_order_relaxed);
+                }
+            }
+        }
+
+        if (report) {
+            FileStats copy;
+            {
+                std::lock_guard lock(mutex);
+                copy = stats[token];
+            }
+            report->append(copy);
         }
 
+        // Per-file lines are debug-level; log_heartbeat() reports progress at info.
         if (is_skipped) {
-            auto pos = completed.load() + failed.load() + ++skipped;
+            auto pos = completed.load() + failed.load() + ++skipped + passed_through.load();
+            if (!logger->should_log(spdlog::level::debug)) return;
+            std::lock_guard lock(mutex);
+            const auto& s = stats[token];
+            LogEvent("file_skip").field("file", s.path).field("pos", pos).field("total", total).field("reason", error)
+                .log(*logger, spdlog::level::debug, "[{}/{}] SKIP {} | {}", pos, total, s.filename, error);
+        }
+        else if (is_passthrough) {
+            auto pos = completed.load() + failed.load() + skipped.load() + ++passed_through;
+            if (!logger->should_log(spdlog::level::debug)) return;
             std::lock_guard lock(mutex);
             const auto& s = stats[token];
-            logger->info("[{}/{}] SKIP {} | {}", pos, total, s.filename, error);
+            LogEvent("file_passthrough").field("file", s.path).field("kind", to_string(s.kind)).field("pos", pos).field("total", total)
+                .field("size_in", s.size_in).field("elapsed_ms", s.elapsed.count()).field("reason", error)
+                .log(*logger, spdlog::level::debug, "[{}/{}] COPY {} | {} | {}ms", pos, total, s.filename, error, s.elapsed.count());
         }
         else if (success) {
-            auto pos = ++completed + failed.load() + skipped.load();
+            auto pos = ++completed + failed.load() + skipped.load() + passed_through.load();
+            if (!logger->should_log(spdlog::level::debug)) return;
 
             std::lock_guard lock(mutex);
             const auto& s = stats[token];
@@ -65,44 +168,175 @@ namespace media_handler::utils {
             double mb_out = s.size_out / 1'048'576.0;
             double mb_per_s = s.elapsed.count() > 0 ? mb_in / (s.elapsed.count() / 1000.0) : 0.0;
 
-            logger->info("[{}/{}] OK {} | {:.1f}MB -> {:.1f}MB ({:.0f}% saved) | {:.1f}MB/s | {}ms", pos, total, s.filename, mb_in, mb_out, ratio, mb_per_s, s.elapsed.count());
+            LogEvent("file_ok").field("file", s.path).field("kind", to_string(s.kind)).field("pos", pos).field("total", total)
+                .field("size_in", s.size_in).field("size_out", s.size_out).field("elapsed_ms", s.elapsed.count())
+                .log(*logger, spdlog::level::debug, "[{}/{}] OK {} | {:.1f}MB -> {:.1f}MB ({:.0f}% saved) | {:.1f}MB/s | {}ms",
+                    pos, total, s.filename, mb_in, mb_out, ratio, mb_per_s, s.elapsed.count());
         }
         else {
-            auto pos = completed.load() + ++failed + skipped.load();
+            auto pos = completed.load() + ++failed + skipped.load() + passed_through.load();
             std::lock_guard lock(mutex);
             const auto& s = stats[token];
 
-            logger->error("[{}/{}] FAIL {} | {} | {}ms", pos, total, s.filename, error, s.elapsed.count());
+            // A failure storm (bad mount, corrupt batch) must not turn into a logging storm; the report and
+            // the retry state still record every failure.
+            static LogSite site(20, 2.0);
+            if (auto held = site.allow()) {
+                LogEvent("file_fail").field("file", s.path).field("kind", to_string(s.kind)).field("pos", pos).field("total", total)
+                    .field("size_in", s.size_in).field("elapsed_ms", s.elapsed.count()).field("error", error).field("suppressed", *held)
+                    .log(*logger, spdlog::level::err, "[{}/{}] FAIL {} | {} | {}ms{}", pos, total, s.filename, error, s.elapsed.count(), LogSite::note(*held));
+            }
         }
     }
 
     void ProgressTracker::skip_file(const fs::path& file) {
-        auto pos = completed.load() + failed.load() + ++skipped;
+        auto pos = completed.load() + failed.load() + ++skipped + passed_through.load();
 
-        logger->debug("[{}/{}] SKIP {} (already completed)", pos, total, path_to_utf8(file.filename()));
+        if (EventLog::enabled()) EventLog::emit(EventType::FileSkip, path_to_utf8(file.filename()));
+        if (!logger->should_log(spdlog::level::debug)) return;
+        const auto name = path_to_utf8(file.filename());
+        LogEvent("file_skip").field("file", path_to_utf8(file)).field("pos", pos).field("total", total).field("reason", "already completed")
+            .log(*logger, spdlog::level::debug, "[{}/{}] SKIP {} (already completed)", pos, total, name);
+    }
+
+    ProgressTracker::Progress ProgressTracker::progress(std::size_t max_in_flight) const {
+        const auto now = std::chrono::steady_clock::now();
+        const double uptime_s = std::chrono::duration<double>(now - run_start).count();
+
+        Progress p;
+        double worker_seconds_left = 0.0;
+        bool eta_known = true;
+
+        // Fallback for kinds that have not finished a file yet.
+        double all_bytes = 0.0, all_seconds = 0.0;
+        std::array<KindRate, media_kind_count> kind_rates;
+        {
+            std::lock_guard lock(mutex);
+            kind_rates = rates;
+
+            // Longest-running first: those dominate the tail.
+            std::vector<std::pair<std::chrono::steady_clock::duration, std::size_t>> running;
+            running.reserve(in_flight.size());
+            for (auto token : in_flight) running.emplace_back(now - start_times[token], token);
+            std::sort(running.begin(), running.end(), std::greater<>());
+
+            p.in_flight_count = running.size();
+            for (std::size_t i = 0; i < running.size() && i < max_in_flight; ++i)
+                p.in_flight.emplace_back(stats[running[i].second].filename, std::chrono::duration_cast<std::chrono::seconds>(running[i].first));
+        }
+        for (const auto& r : kind_rates) { all_bytes += r.bytes; all_seconds += r.seconds; }
+
+        for (std::size_t k = 0; k < media_kind_count; ++k) {
+            const auto planned = planned_bytes[k].load(std::memory_order_relaxed);
+            const auto done = done_bytes[k].load(std::memory_order_relaxed);
+            p.bytes_planned += planned;
+            p.bytes_done += done;
+
+            const double left = planned > done ? static_cast<double>(planned - done) : 0.0;
+            if (left == 0.0) continue;
+
+            const auto& r = kind_rates[k];
+            const double rate = r.seconds > 0.0 ? r.bytes / r.seconds
+                : all_seconds > 0.0 ? all_bytes / all_seconds
+                : 0.0;
+            if (rate <= 0.0) { eta_known = false; continue; }
+            worker_seconds_left += left / rate;
+        }
+
+        p.total = total;
+        p.files_done = completed.load() + failed.load() + skipped.load() + passed_through.load();
+        p.percent = p.bytes_planned > 0 ? 100.0 * static_cast<double>(p.bytes_done) / p.bytes_planned
+            : total > 0 ? 100.0 * static_cast<double>(p.files_done) / total
+            : 100.0;
+        p.mb_per_s = uptime_s > 0.0 ? p.bytes_done / 1'048'576.0 / uptime_s : 0.0;
+        const auto pool = std::max<std::size_t>(1, workers.load(std::memory_order_relaxed));
+        if (eta_known) p.eta = std::chrono::seconds(static_cast<long long>(worker_seconds_left / pool));
+        return p;
+    }
+
+    void ProgressTracker::log_heartbeat() const {
+        const auto p = progress(HEARTBEAT_MAX_IN_FLIGHT);
+
+        std::string flight;
+        for (std::size_t i = 0; i < p.in_flight.size(); ++i)
+            flight += std::format("{}{} ({})", i ? ", " : "", p.in_flight[i].first, format_duration(p.in_flight[i].second.count()));
+        if (p.in_flight_count > p.in_flight.size())
+            flight += std::format(" +{} more", p.in_flight_count - p.in_flight.size());
+
+        const auto eta = p.eta ? format_duration(p.eta->count()) : std::string("--");
+        LogEvent("heartbeat").field("files_done", p.files_done).field("total", p.total).field("bytes_done", p.bytes_done).field("bytes_planned", p.bytes_planned)
+            .field("mb_per_s", p.mb_per_s).field("eta_s", p.eta ? p.eta->count() : -1).field("in_flight", p.in_flight_count)
+            .log(*logger, spdlog::level::info, "[HEARTBEAT] {}/{} files | {:.2f}/{:.2f} GB ({:.1f}%) | {:.1f}MB/s | ETA {} | in flight: {}",
+                p.files_done, p.total, p.bytes_done / 1'073'741'824.0, p.bytes_planned / 1'073'741'824.0, p.percent, p.mb_per_s, eta,
+                flight.empty() ? "none" : flight);
+    }
+
+    ProgressTracker::Snapshot ProgressTracker::snapshot() const {
+        Snapshot s;
+        s.total = total;
+        s.completed = completed.load(std::memory_order_relaxed);
+        s.failed = failed.load(std::memory_order_relaxed);
+        s.skipped = skipped.load(std::memory_order_relaxed);
+        s.passthrough = passed_through.load(std::memory_order_relaxed);
+        s.bytes_in = bytes_in.load(std::memory_order_relaxed);
+        s.bytes_out = bytes_out.load(std::memory_order_relaxed);
+        for (std::size_t k = 0; k < media_kind_count; ++k) {
+            s.bytes_planned += planned_bytes[k].load(std::memory_order_relaxed);
+            s.bytes_done += done_bytes[k].load(std::memory_order_relaxed);
+        }
+        s.queue_depth = queue_depth.load(std::memory_order_relaxed);
+        s.busy_workers = busy_workers.load(std::memory_order_relaxed);
+        s.workers = workers.load(std::memory_order_relaxed);
+        for (std::size_t k = 0; k < media_kind_count; ++k) {
+            s.processing_time[k] = processing_time[k].snapshot();
+            s.cpu_seconds[k] = cpu_ns[k].load(std::memory_order_relaxed) / 1e9;
+        }
+        s.state_commit = state_commit.snapshot();
+        s.uptime = std::chrono::steady_clock::now() - run_start;
+        return s;
     }
 
     void ProgressTracker::print_summary() const {
         auto total_ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - run_start).count();
 
+        /// @brief Per-kind resource totals for capacity planning.
+        struct KindCost {
+            std::size_t files = 0;
+            double cpu_s = 0.0;
+            std::uintmax_t saved = 0;
+            std::uint64_t io_read = 0, io_written = 0, peak_rss = 0;
+            PerfValues perf{};
+            std::uint64_t pixels = 0, frames = 0;
+        };
+        std::array<KindCost, media_kind_count> cost{};
+
         std::uintmax_t in = 0, out = 0;
         {
             std::lock_guard lock(mutex);
             for (const auto& s : stats) {
-                if (s.success && !s.skipped) { in += s.size_in; out += s.size_out; }
+                if (s.skipped) continue;
+                if (s.success) { in += s.size_in; out += s.size_out; }
+
+                // Failed files still cost CPU and I/O.
+                auto& c = cost[static_cast<std::size_t>(s.kind)];
+                ++c.files;
+                c.cpu_s += std::chrono::duration<double>(s.cpu_time).count();
+                if (s.success && s.size_out < s.size_in) c.saved += s.size_in - s.size_out;
+                c.io_read += s.io_read;
+                c.io_written += s.io_written;
+                c.peak_rss = std::max(c.peak_rss, s.peak_rss_delta);
+                c.perf += s.perf;
+                c.pixels += s.pixels;
+                c.frames += s.frames;
             }
         }
+        const auto stages = [this] { std::lock_guard lock(mutex); return stage_totals; }();
 
         double gb_in = in / 1'073'741'824.0;
         double gb_out = out / 1'073'741'824.0;
         double saved = in > 0 ? (1.0 - static_cast<double>(out) / in) * 100.0 : 0.0;
 
-        long s = total_ms / 1000;
-        long mins = s / 60; s %= 60;
-        long hrs = mins / 60; mins %= 60;
-        auto elapsed = hrs > 0 ? std::format("{}h {}m {}s", hrs, mins, s)
-            : mins > 0 ? std::format("{}m {}s", mins, s)
-            : std::format("{}s", s);
+        auto elapsed = format_duration(total_ms / 1000);
 
         logger->info("=================================================");
 
@@ -110,11 +344,58 @@ namespace media_handler::utils {
         logger->info("  OK      : {}", completed.load());
         logger->info("  Failed  : {}", failed.load());
         logger->info("  Skipped : {}", skipped.load());
+        if (const auto copied = passed_through.load(); copied > 0)
+            logger->info("  Copied  : {} (compression predicted to save too little)", copied);
         logger->info("  Before  : {:.2f} GB", gb_in);
         logger->info("  After   : {:.2f} GB", gb_out);
         logger->info("  Saved   : {:.1f}%", saved);
         logger->info("  Time    : {}", elapsed);
 
+        for (std::size_t k = 0; k < media_kind_count; ++k) {
+            const auto& c = cost[k];
+            if (c.files == 0) continue;
+            const double gb_saved = c.saved / 1'073'741'824.0;
+            logger->info("  {:<7} : {} file(s) | CPU {:.1f}s | {} | read {:.2f} GB | wrote {:.2f} GB | peak RSS +{:.0f} MB",
+                to_string(static_cast<MediaKind>(k)), c.files, c.cpu_s,
+                gb_saved > 0.0 ? std::format("{:.1f} CPU-s/GB saved", c.cpu_s / gb_saved) : std::string("nothing saved"),
+                c.io_read / 1'073'741'824.0, c.io_written / 1'073'741'824.0, c.peak_rss / 1'048'576.0);
+
+            if (!PerfCounters::enabled() || c.perf.cycles == 0) continue;
+
+            // Normalize misses by work done: megapixels for images, frames for video.
+            const bool per_frame = c.frames > 0;
+            const double units = per_frame ? static_cast<double>(c.frames) : c.pixels / 1e6;
+            const char* unit = per_frame ? "frame" : "MP";
+            if (units > 0.0) {
+                logger->info("            IPC {:.2f} | {:.0f} cache-miss/{} | {:.0f} branch-miss/{} | {:.1f}M instr/{}",
+                    c.perf.ipc(), c.perf.cache_misses / units, unit, c.perf.branch_misses / units, unit, c.perf.instructions / units / 1e6, unit);
+            }
+            else {
+                logger->info("            IPC {:.2f} | {} cache misses | {} branch misses", c.perf.ipc(), c.perf.cache_misses, c.perf.branch_misses);
+            }
+
+            for (std::size_t st = 0; st < stage_count; ++st) {
+                const auto& sp = stages[k][st];
+                if (sp.perf.cycles == 0) continue;
+                logger->info("            {:<9} {:.0f}% of cycles | IPC {:.2f} | {:.2f}s wall",
+                    to_string(static_cast<Stage>(st)), 100.0 * sp.perf.cycles / c.perf.cycles, sp.perf.ipc(),
+                    std::chrono::duration<double>(sp.wall).count());
+            }
+        }
+
+        // Serialization points: where workers waited on each other or on the log queue.
+        for (const auto& l : LockStats::all()) {
+            const double wait_s = std::chrono::duration<double>(l.wait).count();
+            logger->info("  lock {:<9}: {} acq | {} contended ({:.1f}%) | wait {:.3f}s (max {:.1f} ms) | hold {:.3f}s",
+                l.name, l.acquisitions, l.contended, 100.0 * l.contended / l.acquisitions, wait_s,
+                std::chrono::duration<double, std::milli>(l.max_wait).count(), std::chrono::duration<double>(l.hold).count());
+        }
+
+        if (const auto d = Logger::drops(); d.oldest + d.newest + d.suppressed > 0) {
+            logger->warn("  Log     : {} message(s) lost on a full queue ({} oldest, {} new), {} rate-limited",
+                d.oldest + d.newest, d.oldest, d.newest, d.suppressed);
+        }
+
         if (failed.load() > 0) {
             logger->warn("  {} file(s) failed — run with --retry", failed.load());
         }
@@ -0,0 +1,235 @@
+#include "utils/report_compare.h"
+#include "utils/utils.h"
+#include <algorithm>
+#include <format>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <unordered_map>
+#include <nlohmann/json.hpp>
+
+namespace media_handler::utils {
+
+    namespace fs = std::filesystem;
+    using json = nlohmann::json;
+
+    /// @brief Split CSV text into rows of fields (RFC 4180 quoting, so quoted fields may span lines).
+    static std::vector<std::vector<std::string>> parse_csv(const std::string& text) {
+        std::vector<std::vector<std::string>> rows;
+        std::vector<std::string> row;
+        std::string field;
+        bool quoted = false;
+
+        for (std::size_t i = 0; i < text.size(); ++i) {
+            const char c = text[i];
+            if (quoted) {
+                if (c == '"' && i + 1 < text.size() && text[i + 1] == '"') { field += '"'; ++i; }
+                else if (c == '"') quoted = false;
+                else field += c;
+            }
+            else if (c == '"') quoted = true;
+            else if (c == ',') { row.push_back(std::move(field)); field.clear(); }
+            else if (c == '\n') {
+                row.push_back(std::move(field)); field.clear();
+                rows.push_back(std::move(row)); row.clear();
+            }
+            else if (c != '\r') field += c;
+        }
+        if (!field.empty() || !row.empty()) {
+            row.push_back(std::move(field));
+            rows.push_back(std::move(row));
+        }
+        return rows;
+    }
+
+    static std::expected<Report, std::string> load_csv(const std::string& text) {
+        auto rows = parse_csv(text);
+        if (rows.empty()) return std::unexpected("empty CSV report");
+
+        // Columns by name, so reports with extra columns still load.
+        std::unordered_map<std::string, std::size_t> col;
+        for (std::size_t i = 0; i < rows[0].size(); ++i) col[rows[0][i]] = i;
+        for (const char* name : { "type", "path", "kind", "outcome", "size_in", "size_out", "elapsed_ms", "error" }) {
+            if (!col.contains(name)) return std::unexpected(std::format("CSV report has no '{}' column", name));
+        }
+
+        Report r;
+        for (std::size_t i = 1; i < rows.size(); ++i) {
+            const auto& row = rows[i];
+            if (row.size() < rows[0].size()) continue; // Blank or truncated last line.
+            const auto get = [&](const char* name) -> const std::string& { return row[col[name]]; };
+
+            try {
+                if (get("type") == "summary") {
+                    r.wall_seconds = std::stod(get("elapsed_ms")) / 1000.0;
+                    continue;
+                }
+                ReportFile f;
+                f.path = get("path");
+                f.kind = get("kind");
+                f.outcome = get("outcome");
+                f.size_in = std::stoull(get("size_in"));
+                f.size_out = std::stoull(get("size_out"));
+                f.elapsed_ms = std::stod(get("elapsed_ms"));
+                f.error = get("error");
+                r.files.push_back(std::move(f));
+            }
+            catch (const std::exception&) {
+                return std::unexpected(std::format("CSV report: bad number on row {}", i + 1));
+            }
+        }
+        return r;
+    }
+
+    static std::expected<Report, std::string> load_ndjson(std::istream& in) {
+        Report r;
+        std::string line;
+        std::size_t line_no = 0;
+        while (std::getline(in, line)) {
+            ++line_no;
+            if (line.empty() || line == "\r") continue;
+            try {
+                auto j = json::parse(line);
+                const auto type = j.value("type", "");
+                if (type == "summary") {
+                    r.wall_seconds = j.value("wall_seconds", 0.0);
+                }
+                else if (type == "file") {
+                    ReportFile f;
+                    f.path = j.value("path", "");
+                    f.kind = j.value("kind", "other");
+                    f.outcome = j.value("outcome", "");
+                    f.size_in = j.value("size_in", std::uintmax_t{ 0 });
+                    f.size_out = j.value("size_out", std::uintmax_t{ 0 });
+                    f.elapsed_ms = j.value("elapsed_ms", 0.0);
+                    f.error = j.value("error", "");
+                    r.files.push_back(std::move(f));
+                }
+            }
+            catch (const json::exception& e) {
+                return std::unexpected(std::format("NDJSON report line {}: {}", line_no, e.what()));
+            }
+        }
+        return r;
+    }
+
+    std::expected<Report, std::string> load_report(const fs::path& file) {
+        std::ifstream in(file, std::ios::binary);
+        if (!in) return std::unexpected(std::format("Cannot open report {}", path_to_utf8(file)));
+
+        if (in.peek() == '{') return load_ndjson(in);
+
+        std::stringstream buf;
+        buf << in.rdbuf();
+        return load_csv(buf.str());
+    }
+
+    Comparison compare_reports(const Report& a, const Report& b, const CompareOptions& opts) {
+        /// @brief Totals of OK files of one kind.
+        struct Totals {
+            std::size_t files = 0;
+            std::uintmax_t in = 0, out = 0;
+            double ms = 0.0;
+            double mb_per_s() const { return ms > 0 ? in / 1'048'576.0 / (ms / 1000.0) : 0.0; }
+            double saved_pct() const { return in > 0 ? (1.0 - static_cast<double>(out) / in) * 100.0 : 0.0; }
+        };
+        const auto totals = [](const Report& r) {
+            std::map<std::string, Totals> t;
+            for (const auto& f : r.files) {
+                if (f.outcome != "ok") continue;
+                auto& k = t[f.kind];
+                ++k.files;
+                k.in += f.size_in;
+                k.out += f.size_out;
+                k.ms += f.elapsed_ms;
+            }
+            return t;
+        };
+
+        Comparison c;
+        const auto ta = totals(a), tb = totals(b);
+        for (const auto& [kind, ka] : ta) {
+            auto it = tb.find(kind);
+            if (it == tb.end()) continue;
+            const auto& kb = it->second;
+
+            KindDelta d;
+            d.kind = kind;
+            d.files_a = ka.files;
+            d.files_b = kb.files;
+            d.mb_per_s_a = ka.mb_per_s();
+            d.mb_per_s_b = kb.mb_per_s();
+            d.saved_pct_a = ka.saved_pct();
+            d.saved_pct_b = kb.saved_pct();
+            d.throughput_change_pct = d.mb_per_s_a > 0 ? (d.mb_per_s_b / d.mb_per_s_a - 1.0) * 100.0 : 0.0;
+            d.saved_change_points = d.saved_pct_b - d.saved_pct_a;
+
+            if (d.throughput_change_pct < -opts.threshold_pct)
+                c.regressions.push_back(std::format("{} throughput {:+.1f}% ({:.2f} -> {:.2f} MB/s)", kind, d.throughput_change_pct, d.mb_per_s_a, d.mb_per_s_b));
+            if (d.saved_change_points < -opts.threshold_pct)
+                c.regressions.push_back(std::format("{} savings {:+.1f} points ({:.1f}% -> {:.1f}%)", kind, d.saved_change_points, d.saved_pct_a, d.saved_pct_b));
+            c.kinds.push_back(std::move(d));
+        }
+
+        if (a.wall_seconds && b.wall_seconds && *a.wall_seconds > 0) {
+            c.wall_change_pct = (*b.wall_seconds / *a.wall_seconds - 1.0) * 100.0;
+            if (*c.wall_change_pct > opts.threshold_pct)
+                c.regressions.push_back(std::format("wall time {:+.1f}% ({:.1f}s -> {:.1f}s)", *c.wall_change_pct, *a.wall_seconds, *b.wall_seconds));
+        }
+
+        std::unordered_map<std::string, const ReportFile*> by_path;
+        for (const auto& f : a.files) by_path[f.path] = &f;
+
+        for (const auto& fb : b.files) {
+            auto it = by_path.find(fb.path);
+            if (it == by_path.end()) continue;
+            const auto& fa = *it->second;
+
+            if (fa.outcome == "ok" && fb.outcome == "failed") {
+                c.newly_failed.push_back(fb.path);
+                continue;
+            }
+            if (fa.outcome != "ok" || fb.outcome != "ok") continue;
+
+            const double slower_ms = fb.elapsed_ms - fa.elapsed_ms;
+            if (slower_ms < opts.min_slowdown_ms) continue;
+            const double pct = fa.elapsed_ms > 0 ? slower_ms / fa.elapsed_ms * 100.0 : 100.0;
+            if (pct > opts.threshold_pct) c.slower.push_back({ fb.path, fa.elapsed_ms, fb.elapsed_ms, pct });
+        }
+        std::sort(c.slower.begin(), c.slower.end(), [](const SlowerFile& x, const SlowerFile& y) {
+            return x.elapsed_ms_b - x.elapsed_ms_a > y.elapsed_ms_b - y.elapsed_ms_a;
+            });
+        if (c.slower.size() > opts.max_slower) c.slower.resize(opts.max_slower);
+
+        if (!c.newly_failed.empty())
+            c.regressions.push_back(std::format("{} file(s) newly failing", c.newly_failed.size()));
+        return c;
+    }
+
+    std::string format_comparison(const Comparison& c, const CompareOptions& opts) {
+        std::string s;
+        s += std::format("{:<7} {:>7} {:>7} {:>11} {:>11} {:>8} {:>9} {:>9} {:>8}\n",
+            "kind", "files A", "files B", "MB/s A", "MB/s B", "change", "saved A", "saved B", "change");
+        for (const auto& k : c.kinds) {
+            s += std::format("{:<7} {:>7} {:>7} {:>11.2f} {:>11.2f} {:>+7.1f}% {:>8.1f}% {:>8.1f}% {:>+7.1f}p\n",
+                k.kind, k.files_a, k.files_b, k.mb_per_s_a, k.mb_per_s_b, k.throughput_change_pct,
+                k.saved_pct_a, k.saved_pct_b, k.saved_change_points);
+        }
+        if (c.wall_change_pct) s += std::format("wall time {:+.1f}%\n", *c.wall_change_pct);
+
+        if (!c.slower.empty()) {
+            s += std::format("\nSlower files (> {:.0f}% and > {:.0f} ms):\n", opts.threshold_pct, opts.min_slowdown_ms);
+            for (const auto& f : c.slower)
+                s += std::format("  {:>+7.1f}% {:>9.0f} -> {:>9.0f} ms  {}\n", f.change_pct, f.elapsed_ms_a, f.elapsed_ms_b, f.path);
+        }
+        if (!c.newly_failed.empty()) {
+            s += "\nNewly failing:\n";
+            for (const auto& p : c.newly_failed) s += std::format("  {}\n", p);
+        }
+
+        s += c.regressions.empty() ? "\nNo regressions.\n" : "\nREGRESSIONS:\n";
+        for (const auto& r : c.regressions) s += std::format("  {}\n", r);
+        return s;
+    }
+
+} // namespace media_handler::utils
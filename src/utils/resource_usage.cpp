@@ -0,0 +1,121 @@
+#include "utils/resource_usage.h"
+#include "utils/work_context.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iterator>
+#include <string>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <fcntl.h>
+#endif
+
+namespace media_handler::utils {
+
+#ifdef __linux__
+    /// @brief Read a small /proc file into buf (NUL-terminated). Returns bytes read, 0 on failure.
+    static std::size_t read_proc(const char* path, char* buf, std::size_t size) {
+        int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return 0;
+        ssize_t n = ::read(fd, buf, size - 1);
+        ::close(fd);
+        if (n <= 0) return 0;
+        buf[n] = '\0';
+        return static_cast<std::size_t>(n);
+    }
+
+    /// @brief Parse "key: value" from /proc/<...>/io content.
+    static std::uint64_t io_field(const char* text, const char* key) {
+        const char* p = std::strstr(text, key);
+        if (!p) return 0;
+        return std::strtoull(p + std::strlen(key), nullptr, 10);
+    }
+
+    /// @brief utime + stime of one task from /proc/self/task/<tid>/stat.
+    static std::chrono::nanoseconds task_cpu(long tid) {
+        char path[64];
+        std::snprintf(path, sizeof(path), "/proc/self/task/%ld/stat", tid);
+        char buf[1024];
+        if (!read_proc(path, buf, sizeof(buf))) return {};
+
+        // comm (field 2) may contain spaces; fields resume after the last ')'.
+        const char* p = std::strrchr(buf, ')');
+        if (!p) return {};
+        unsigned long long utime = 0, stime = 0;
+        if (std::sscanf(p + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu", &utime, &stime) != 2) return {};
+
+        static const long ticks = sysconf(_SC_CLK_TCK);
+        if (ticks <= 0) return {};
+        return std::chrono::nanoseconds((utime + stime) * 1'000'000'000ULL / static_cast<unsigned long long>(ticks));
+    }
+
+    static std::vector<long> list_tasks() {
+        std::vector<long> tids;
+        std::error_code ec;
+        for (const auto& e : std::filesystem::directory_iterator("/proc/self/task", ec))
+            tids.push_back(std::strtol(e.path().filename().c_str(), nullptr, 10));
+        std::sort(tids.begin(), tids.end());
+        return tids;
+    }
+#endif
+
+    ResourceSample ResourceSample::now() {
+        ResourceSample s;
+#ifdef _WIN32
+        FILETIME created, exited, kernel, user;
+        if (GetThreadTimes(GetCurrentThread(), &created, &exited, &kernel, &user)) {
+            auto to_100ns = [](const FILETIME& ft) {
+                return (static_cast<std::uint64_t>(ft.dwHighDateTime) << 32) | ft.dwLowDateTime;
+                };
+            s.cpu = std::chrono::nanoseconds((to_100ns(kernel) + to_100ns(user)) * 100);
+        }
+#else
+        timespec ts{};
+        if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0)
+            s.cpu = std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+
+        rusage ru{};
+        if (getrusage(RUSAGE_SELF, &ru) == 0)
+            s.peak_rss = static_cast<std::uint64_t>(ru.ru_maxrss) * 1024; // KiB on Linux
+#endif
+#ifdef __linux__
+        char buf[512];
+        if (read_proc("/proc/thread-self/io", buf, sizeof(buf))) {
+            s.read_bytes = io_field(buf, "rchar:");
+            s.write_bytes = io_field(buf, "wchar:");
+        }
+#endif
+        s.perf = PerfCounters::read();
+        return s;
+    }
+
+    HelperThreadCpu::HelperThreadCpu() {
+#ifdef __linux__
+        baseline = list_tasks();
+#endif
+    }
+
+    void HelperThreadCpu::adopt() {
+#ifdef __linux__
+        auto now = list_tasks();
+        adopted.clear();
+        std::set_difference(now.begin(), now.end(), baseline.begin(), baseline.end(), std::back_inserter(adopted));
+#endif
+    }
+
+    void HelperThreadCpu::collect() {
+#ifdef __linux__
+        std::chrono::nanoseconds total{};
+        for (auto tid : adopted) total += task_cpu(tid);
+        WorkContext::current().attributed_cpu += total;
+        adopted.clear();
+#endif
+    }
+
+} // namespace media_handler::utils
@@ -0,0 +1,121 @@
+#include "utils/run_report.h"
+#include "utils/utils.h"
+#include <algorithm>
+#include <cctype>
+#include <format>
+#include <nlohmann/json.hpp>
+
+namespace media_handler::utils {
+
+    namespace fs = std::filesystem;
+    using json = nlohmann::json;
+
+    static double to_ms(std::chrono::nanoseconds d) {
+        return std::chrono::duration<double, std::milli>(d).count();
+    }
+
+    /// @brief Quote a CSV field if it contains a separator, quote or line break.
+    static std::string csv_field(const std::string& v) {
+        if (v.find_first_of(",\"\r\n") == std::string::npos) return v;
+        std::string q = "\"";
+        for (char c : v) {
+            if (c == '"') q += '"';
+            q += c;
+        }
+        return q + '"';
+    }
+
+    std::expected<std::unique_ptr<RunReport>, std::string> RunReport::open(const fs::path& file) {
+        std::error_code ec;
+        if (file.has_parent_path()) fs::create_directories(file.parent_path(), ec);
+
+        std::ofstream out(file, std::ios::binary | std::ios::trunc);
+        if (!out) return std::unexpected(std::format("Cannot open run report {}", path_to_utf8(file)));
+
+        auto ext = path_to_utf8(file.extension());
+        std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        return std::make_unique<RunReport>(std::move(out), ext == ".csv" ? Format::Csv : Format::NDJson);
+    }
+
+    RunReport::RunReport(std::ofstream out, Format format) : out(std::move(out)), format(format) {
+        if (format == Format::Csv) this->out << CSV_HEADER << '\n';
+    }
+
+    const char* RunReport::outcome(const FileStats& s) {
+        return s.skipped ? "skipped" : s.passthrough ? "passthrough" : s.success ? "ok" : "failed";
+    }
+
+    void RunReport::append(const FileStats& s) {
+        const auto& st = s.stage_wall;
+        const double cpu_ms = to_ms(s.cpu_time);
+
+        std::string line;
+        if (format == Format::Csv) {
+            line = std::format("file,{},{},{},{},{},{},{:.3f},{:.3f},{:.3f},{:.3f},{:.3f},{:.3f},{},{}\n",
+                csv_field(s.path), to_string(s.kind), outcome(s), s.size_in, s.size_out, s.elapsed.count(), cpu_ms,
+                to_ms(st[0]), to_ms(st[1]), to_ms(st[2]), to_ms(st[3]), to_ms(st[4]),
+                s.ssim > 0.0 ? std::format("{:.4f}", s.ssim) : std::string(), csv_field(s.error));
+        }
+        else {
+            json stages = json::object();
+            for (std::size_t i = 0; i < stage_count; ++i) {
+                if (st[i].count() > 0) stages[to_string(static_cast<Stage>(i))] = to_ms(st[i]);
+            }
+            json j = {
+                {"type", "file"}, {"path", s.path}, {"kind", to_string(s.kind)}, {"outcome", outcome(s)},
+                {"size_in", s.size_in}, {"size_out", s.size_out}, {"elapsed_ms", s.elapsed.count()},
+                {"cpu_ms", cpu_ms}, {"stages_ms", std::move(stages)}, {"error", s.error}
+            };
+            if (s.ssim > 0.0) j["ssim"] = s.ssim;
+            line = j.dump(-1, ' ', false, json::error_handler_t::replace) + '\n';
+        }
+
+        std::lock_guard lock(mutex);
+        auto& k = kinds[static_cast<std::size_t>(s.kind)];
+        if (s.skipped) ++k.skipped;
+        else if (s.success) {
+            ++(s.passthrough ? k.passthrough : k.ok);
+            k.bytes_in += s.size_in;
+            k.bytes_out += s.size_out;
+        }
+        else ++k.failed;
+        if (!s.skipped) k.busy_seconds += s.elapsed.count() / 1000.0;
+
+        out << line;
+        out.flush();
+    }
+
+    void RunReport::write_summary(const ProgressTracker::Snapshot& snap) {
+        const double wall_s = std::chrono::duration<double>(snap.uptime).count();
+        const double cpu_s = snap.cpu_seconds[0] + snap.cpu_seconds[1] + snap.cpu_seconds[2];
+
+        std::lock_guard lock(mutex);
+        if (format == Format::Csv) {
+            out << std::format("summary,,all,,{},{},{:.0f},{:.3f},,,,,,,\n", snap.bytes_in, snap.bytes_out, wall_s * 1000.0, cpu_s * 1000.0);
+        }
+        else {
+            json per_kind = json::object();
+            for (std::size_t i = 0; i < media_kind_count; ++i) {
+                const auto& k = kinds[i];
+                if (k.ok + k.failed + k.skipped + k.passthrough == 0) continue;
+                per_kind[to_string(static_cast<MediaKind>(i))] = {
+                    {"ok", k.ok}, {"failed", k.failed}, {"skipped", k.skipped}, {"passthrough", k.passthrough},
+                    {"bytes_in", k.bytes_in}, {"bytes_out", k.bytes_out},
+                    {"busy_seconds", k.busy_seconds}, {"cpu_seconds", snap.cpu_seconds[i]}
+                };
+            }
+            const auto finished = snap.completed + snap.failed + snap.passthrough;
+            json j = {
+                {"type", "summary"}, {"files", snap.total}, {"ok", snap.completed}, {"failed", snap.failed},
+                {"skipped", snap.skipped}, {"passthrough", snap.passthrough}, {"bytes_in", snap.bytes_in}, {"bytes_out", snap.bytes_out},
+                {"wall_seconds", wall_s}, {"cpu_seconds", cpu_s},
+                {"files_per_second", wall_s > 0 ? finished / wall_s : 0.0},
+                {"mb_per_second", wall_s > 0 ? snap.bytes_in / 1'048'576.0 / wall_s : 0.0},
+                {"kinds", std::move(per_kind)}
+            };
+            out << j.dump() << '\n';
+        }
+        out.flush();
+    }
+
+} // namespace media_handler::utils
@@ -0,0 +1,83 @@
+#include "alloc_counter.h"
+#include <cerrno>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+// glibc: interpose the C allocators and forward to the __libc_* entry points. operator new and
+// av_malloc both end up here, so every allocation is counted exactly once.
+// Elsewhere (or under ASan, which owns malloc): replace operator new only.
+#if defined(__GLIBC__) && !defined(__SANITIZE_ADDRESS__)
+#define MEDIA_HANDLER_HOOK_MALLOC 1
+#endif
+
+namespace {
+    constinit thread_local std::uint64_t t_count = 0;
+    constinit thread_local std::uint64_t t_bytes = 0;
+    constinit thread_local int t_armed = 0;
+
+    inline void note(std::size_t bytes) {
+        if (t_armed) {
+            ++t_count;
+            t_bytes += bytes;
+        }
+    }
+}
+
+#ifdef MEDIA_HANDLER_HOOK_MALLOC
+extern "C" {
+    void* __libc_malloc(std::size_t);
+    void* __libc_calloc(std::size_t, std::size_t);
+    void* __libc_realloc(void*, std::size_t);
+    void* __libc_memalign(std::size_t, std::size_t);
+
+    void* malloc(std::size_t n) { note(n); return __libc_malloc(n); }
+    void* calloc(std::size_t n, std::size_t size) { note(n * size); return __libc_calloc(n, size); }
+    void* realloc(void* p, std::size_t n) { note(n); return __libc_realloc(p, n); }
+    void* memalign(std::size_t align, std::size_t n) { note(n); return __libc_memalign(align, n); }
+    void* aligned_alloc(std::size_t align, std::size_t n) { note(n); return __libc_memalign(align, n); }
+
+    int posix_memalign(void** out, std::size_t align, std::size_t n) {
+        if (align < sizeof(void*) || (align & (align - 1)) != 0) return EINVAL;
+        note(n);
+        void* p = __libc_memalign(align, n);
+        if (!p) return ENOMEM;
+        *out = p;
+        return 0;
+    }
+}
+#else
+void* operator new(std::size_t n) {
+    note(n);
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t n) { return ::operator new(n); }
+void* operator new(std::size_t n, const std::nothrow_t&) noexcept {
+    note(n);
+    return std::malloc(n ? n : 1);
+}
+void* operator new[](std::size_t n, const std::nothrow_t& t) noexcept { return ::operator new(n, t); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+#endif
+
+namespace media_handler::tests {
+
+    AllocScope::AllocScope() : start{ t_count, t_bytes } { ++t_armed; }
+
+    AllocScope::~AllocScope() { --t_armed; }
+
+    AllocStats AllocScope::stats() const { return { t_count - start.count, t_bytes - start.bytes }; }
+
+    bool counts_c_allocations() {
+#ifdef MEDIA_HANDLER_HOOK_MALLOC
+        return true;
+#else
+        return false;
+#endif
+    }
+
+} // namespace media_handler::tests
@@ -0,0 +1,31 @@
+#pragma once
+#include <cstdint>
+
+namespace media_handler::tests {
+
+    struct AllocStats {
+        std::uint64_t count = 0; // Allocation calls (malloc, calloc, realloc, aligned variants, operator new).
+        std::uint64_t bytes = 0; // Bytes requested.
+    };
+
+    /// @brief Counts heap allocations made by the calling thread while the scope is alive.
+    /// Other threads (including FFmpeg codec threads) are not counted. Scopes may nest.
+    class AllocScope {
+    public:
+        AllocScope();
+        ~AllocScope();
+        AllocScope(const AllocScope&) = delete;
+        AllocScope& operator=(const AllocScope&) = delete;
+
+        /// @brief Allocations since construction.
+        AllocStats stats() const;
+
+    private:
+        AllocStats start;
+    };
+
+    /// @brief True when C-level allocations (libjpeg, libpng, FFmpeg's av_malloc) are counted too;
+    /// otherwise only operator new is.
+    bool counts_c_allocations();
+
+} // namespace media_handler::tests
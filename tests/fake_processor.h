@@ -0,0 +1,110 @@
+#pragma once
+#include "compressor/media_processor.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace media_handler::tests {
+
+    /// @brief Random variable for fake processor latency and memory.
+    struct Distribution {
+        enum class Shape { Fixed, Uniform, LogNormal };
+        Shape shape = Shape::Fixed;
+        double a = 0.0; // Fixed: value. Uniform: low. LogNormal: median.
+        double b = 0.0; // Uniform: high. LogNormal: sigma of the underlying normal.
+
+        static Distribution fixed(double v) { return { Shape::Fixed, v, 0.0 }; }
+        static Distribution uniform(double lo, double hi) { return { Shape::Uniform, lo, hi }; }
+        static Distribution lognormal(double median, double sigma) { return { Shape::LogNormal, median, sigma }; }
+
+        double sample(std::mt19937_64& rng) const {
+            switch (shape) {
+            case Shape::Uniform: return std::uniform_real_distribution<double>(a, b)(rng);
+            case Shape::LogNormal: return a > 0.0 ? std::lognormal_distribution<double>(std::log(a), b)(rng) : 0.0;
+            default: return a;
+            }
+        }
+    };
+
+    /// @brief What a FakeProcessor does per call.
+    struct FakeProfile {
+        Distribution latency_us; // Time spent per file.
+        Distribution memory_kb; // Heap touched and held for the duration of the call.
+        bool burn_cpu = false; // Spin instead of sleeping (CPU-bound codec vs. I/O wait).
+        double failure_rate = 0.0; // Fraction of calls returning an error.
+    };
+
+    /// @brief Synthetic MediaProcessor: no codec and no file I/O, only the configured latency and memory.
+    /// Optionally records each call's start/end so a harness can derive dispatch gaps and makespan.
+    class FakeProcessor final : public compressor::MediaProcessor {
+    public:
+        struct Call {
+            std::chrono::steady_clock::time_point start;
+            std::chrono::steady_clock::time_point end;
+            std::size_t thread = 0; // Hash of the worker's thread id.
+        };
+
+        explicit FakeProcessor(FakeProfile profile, std::uint64_t seed = 1)
+            : profile(profile), seed(seed) {}
+
+        /// @brief Start recording up to capacity calls (drops the previous trace).
+        void trace(std::size_t capacity) {
+            calls.assign(capacity, {});
+            traced.store(0, std::memory_order_relaxed);
+        }
+
+        /// @brief Recorded calls, in completion order.
+        std::vector<Call> trace_result() const {
+            const auto n = std::min(traced.load(std::memory_order_acquire), calls.size());
+            return { calls.begin(), calls.begin() + static_cast<std::ptrdiff_t>(n) };
+        }
+
+        std::size_t call_count() const { return count.load(std::memory_order_relaxed); }
+
+        utils::ProcessResult compress(const std::filesystem::path&, const std::filesystem::path&) override {
+            // Per worker thread (shared by all instances); sampling needs no lock.
+            thread_local std::mt19937_64 rng(seed ^ std::hash<std::thread::id>{}(std::this_thread::get_id()));
+            const auto start = std::chrono::steady_clock::now();
+
+            std::unique_ptr<char[]> held;
+            if (const auto kb = static_cast<std::size_t>(std::max(0.0, profile.memory_kb.sample(rng)))) {
+                held.reset(new char[kb * 1024]);
+                for (std::size_t off = 0; off < kb * 1024; off += 4096) held[off] = 1; // Fault the pages in.
+            }
+
+            const auto latency = std::chrono::duration<double, std::micro>(std::max(0.0, profile.latency_us.sample(rng)));
+            if (latency.count() > 0.0) {
+                if (profile.burn_cpu) {
+                    const auto until = start + std::chrono::duration_cast<std::chrono::nanoseconds>(latency);
+                    while (std::chrono::steady_clock::now() < until) {}
+                }
+                else {
+                    std::this_thread::sleep_for(latency);
+                }
+            }
+            const bool fail = profile.failure_rate > 0.0 && std::uniform_real_distribution<double>(0.0, 1.0)(rng) < profile.failure_rate;
+
+            count.fetch_add(1, std::memory_order_relaxed);
+            const auto slot = traced.fetch_add(1, std::memory_order_relaxed);
+            if (slot < calls.size())
+                calls[slot] = { start, std::chrono::steady_clock::now(), std::hash<std::thread::id>{}(std::this_thread::get_id()) };
+
+            return fail ? utils::ProcessResult::Error("simulated failure") : utils::ProcessResult::OK();
+        }
+
+    private:
+        FakeProfile profile;
+        std::uint64_t seed;
+        std::atomic<std::size_t> count{ 0 };
+        std::atomic<std::size_t> traced{ 0 };
+        std::vector<Call> calls;
+    };
+
+} // namespace media_handler::tests
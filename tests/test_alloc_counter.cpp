@@ -0,0 +1,220 @@
+#include <gtest/gtest.h>
+#include "alloc_counter.h"
+#include "compressor/image_processor.h"
+#include "compressor/video_processor.h"
+#include "tools/synthetic_media.h"
+#include "test_common.h"
+#include <cstdlib>
+#include <latch>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace media_handler::tests {
+
+    namespace fs = std::filesystem;
+
+    // Worker-thread allocations per frame the video loop may cost over a bare FFmpeg transcode of the same
+    // clip, which is measured in the test on the FFmpeg build it runs against (demuxed packet, encoder output,
+    // muxer interleave entry vary by version). The slack absorbs codec-thread scheduling; a loop that
+    // allocates anything per frame of its own lands a whole allocation above the reference.
+    constexpr double max_extra_allocs_per_frame = 0.5;
+
+    // Extra allocations a 16x larger image may cost over a small one: libjpeg's pools grow in large
+    // blocks, so anything proportional to rows or pixels shows up far above this.
+    constexpr std::uint64_t max_allocs_growth_per_image = 8;
+
+    class AllocCounterTest : public TestCommon {
+    protected:
+        std::shared_ptr<spdlog::logger> quiet_logger() {
+            auto logger = spdlog::default_logger()->clone("alloc_test");
+            logger->set_level(spdlog::level::off);
+            return logger;
+        }
+
+        /// @brief Reference for the video loop: decode `in` and encode its video stream with `codec` into `out`
+        /// with the bare FFmpeg calls, reusing one packet and frame each, and the processor's threading.
+        static bool ffmpeg_transcode(const fs::path& in, const fs::path& out, const char* codec) {
+            struct Transcode {
+                AVFormatContext* ic = nullptr;
+                AVFormatContext* oc = nullptr;
+                AVCodecContext* dec = nullptr;
+                AVCodecContext* enc = nullptr;
+                AVPacket* pkt = nullptr;
+                AVPacket* out_pkt = nullptr;
+                AVFrame* frame = nullptr;
+                ~Transcode() {
+                    av_frame_free(&frame);
+                    av_packet_free(&out_pkt);
+                    av_packet_free(&pkt);
+                    avcodec_free_context(&enc);
+                    avcodec_free_context(&dec);
+                    if (oc && oc->pb) avio_closep(&oc->pb);
+                    avformat_free_context(oc);
+                    avformat_close_input(&ic);
+                }
+            } t;
+
+            const auto in_utf8 = utils::path_to_utf8(in), out_utf8 = utils::path_to_utf8(out);
+            if (avformat_open_input(&t.ic, in_utf8.c_str(), nullptr, nullptr) < 0) return false;
+            if (avformat_find_stream_info(t.ic, nullptr) < 0 || t.ic->nb_streams != 1) return false;
+            AVStream* in_stream = t.ic->streams[0];
+
+            const AVCodec* decoder = avcodec_find_decoder(in_stream->codecpar->codec_id);
+            const AVCodec* encoder = avcodec_find_encoder_by_name(codec);
+            if (!decoder || !encoder) return false;
+            t.dec = avcodec_alloc_context3(decoder);
+            if (!t.dec || avcodec_parameters_to_context(t.dec, in_stream->codecpar) < 0) return false;
+            t.dec->thread_count = 0;
+            t.dec->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+            if (avcodec_open2(t.dec, decoder, nullptr) < 0) return false;
+
+            if (avformat_alloc_output_context2(&t.oc, nullptr, nullptr, out_utf8.c_str()) < 0 || !t.oc) return false;
+            AVStream* out_stream = avformat_new_stream(t.oc, nullptr);
+            t.enc = avcodec_alloc_context3(encoder);
+            if (!out_stream || !t.enc) return false;
+            t.enc->width = t.dec->width;
+            t.enc->height = t.dec->height;
+            t.enc->pix_fmt = AV_PIX_FMT_YUV420P;
+            t.enc->time_base = { 1, 90000 };
+            t.enc->framerate = in_stream->avg_frame_rate;
+            t.enc->thread_count = 0;
+            if (t.oc->oformat->flags & AVFMT_GLOBALHEADER) t.enc->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+            if (avcodec_open2(t.enc, encoder, nullptr) < 0) return false;
+            if (avcodec_parameters_from_context(out_stream->codecpar, t.enc) < 0) return false;
+            out_stream->time_base = t.enc->time_base;
+            if (!(t.oc->oformat->flags & AVFMT_NOFILE) && avio_open(&t.oc->pb, out_utf8.c_str(), AVIO_FLAG_WRITE) < 0) return false;
+            if (avformat_write_header(t.oc, nullptr) < 0) return false;
+
+            t.pkt = av_packet_alloc();
+            t.out_pkt = av_packet_alloc();
+            t.frame = av_frame_alloc();
+            if (!t.pkt || !t.out_pkt || !t.frame) return false;
+
+            auto drain = [&] {
+                while (avcodec_receive_packet(t.enc, t.out_pkt) >= 0) {
+                    av_packet_rescale_ts(t.out_pkt, t.enc->time_base, out_stream->time_base);
+                    t.out_pkt->stream_index = out_stream->index;
+                    av_interleaved_write_frame(t.oc, t.out_pkt);
+                }
+            };
+            while (av_read_frame(t.ic, t.pkt) >= 0) {
+                if (avcodec_send_packet(t.dec, t.pkt) >= 0) {
+                    while (avcodec_receive_frame(t.dec, t.frame) >= 0) {
+                        t.frame->pict_type = AV_PICTURE_TYPE_NONE;
+                        t.frame->pts = av_rescale_q(t.frame->best_effort_timestamp, in_stream->time_base, t.enc->time_base);
+                        if (avcodec_send_frame(t.enc, t.frame) < 0) return false;
+                        drain();
+                    }
+                }
+                av_packet_unref(t.pkt);
+            }
+            avcodec_send_frame(t.enc, nullptr);
+            drain();
+            return av_write_trailer(t.oc) >= 0;
+        }
+    };
+
+    TEST_F(AllocCounterTest, CountsOperatorNew) {
+        AllocScope scope;
+        auto p = std::make_unique<int>(1);
+        std::vector<char> v(1000);
+        EXPECT_EQ(scope.stats().count, 2u);
+        EXPECT_GE(scope.stats().bytes, 1000u + sizeof(int));
+    }
+
+    TEST_F(AllocCounterTest, NoAllocations_IsZero) {
+        int x = 0;
+        AllocScope scope;
+        for (int i = 0; i < 100; ++i) x += i;
+        EXPECT_EQ(scope.stats().count, 0u);
+        EXPECT_EQ(x, 4950);
+    }
+
+    TEST_F(AllocCounterTest, CountsMalloc) {
+        if (!counts_c_allocations()) GTEST_SKIP() << "C allocations are not hooked on this platform";
+        AllocScope scope;
+        void* volatile p = std::malloc(64); // volatile: keep the compiler from eliding the malloc/free pair.
+        void* q = nullptr;
+        const int rc = posix_memalign(&q, 64, 128);
+        const auto stats = scope.stats(); // Before any gtest assertion allocates.
+        std::free(p);
+        std::free(q);
+        EXPECT_EQ(rc, 0);
+        EXPECT_EQ(stats.count, 2u);
+        EXPECT_EQ(stats.bytes, 192u);
+    }
+
+    /// @brief Allocations on other threads are not attributed to this thread's scope.
+    TEST_F(AllocCounterTest, IgnoresOtherThreads) {
+        std::latch start(1), done(1);
+        std::thread t([&] {
+            start.wait();
+            for (int i = 0; i < 100; ++i) std::vector<int> v(16);
+            done.count_down();
+            });
+        {
+            AllocScope scope;
+            start.count_down();
+            done.wait();
+            EXPECT_EQ(scope.stats().count, 0u);
+        }
+        t.join();
+    }
+
+    /// @brief A JPEG costs a fixed number of allocations, independent of its size, and the same every time.
+    TEST_F(AllocCounterTest, Jpeg_FixedAllocationsPerImage) {
+        if (!counts_c_allocations()) GTEST_SKIP() << "libjpeg allocations are not visible without the malloc hook";
+        ASSERT_TRUE(tools::write_jpeg(path("small.jpg"), 256, 192, 95, 1));
+        ASSERT_TRUE(tools::write_jpeg(path("large.jpg"), 1024, 768, 95, 1));
+
+        utils::Config cfg;
+        compressor::ImageProcessor proc(cfg, quiet_logger());
+        auto count = [&](const char* in, const char* out) {
+            AllocScope scope;
+            auto r = proc.compress(path(in), path(out));
+            EXPECT_TRUE(r.success) << r.message;
+            return scope.stats().count;
+        };
+
+        count("small.jpg", "warm.jpg"); // First call pays one-time library initialization.
+        const auto small1 = count("small.jpg", "s1.jpg");
+        const auto small2 = count("small.jpg", "s2.jpg");
+        const auto large = count("large.jpg", "l.jpg");
+
+        EXPECT_EQ(small1, small2);
+        EXPECT_LE(large, small1 + max_allocs_growth_per_image) << "allocations grow with image size";
+    }
+
+    /// @brief The video loop allocates nothing per frame beyond what FFmpeg itself needs for the same transcode.
+    TEST_F(AllocCounterTest, Video_SteadyStateAllocationsPerFrame) {
+        if (!counts_c_allocations()) GTEST_SKIP() << "av_malloc allocations are not visible without the malloc hook";
+        if (!tools::write_video(path("short.mp4"), 320, 240, 30, 30, "mpeg4", 1)
+            || !tools::write_video(path("long.mp4"), 320, 240, 90, 30, "mpeg4", 1))
+            GTEST_SKIP() << "no mpeg4 encoder available";
+
+        utils::Config cfg;
+        cfg.video_codec = "mpeg4"; // Same encoder as the reference, whatever this FFmpeg build was configured with.
+        compressor::VideoProcessor proc(cfg, quiet_logger());
+        auto count = [&](const char* in, const char* out) {
+            AllocScope scope;
+            auto r = proc.compress(path(in), path(out));
+            EXPECT_TRUE(r.success) << r.message;
+            return scope.stats().count;
+        };
+        auto count_reference = [&](const char* in, const char* out) {
+            AllocScope scope;
+            EXPECT_TRUE(ffmpeg_transcode(path(in), path(out), "mpeg4")) << in;
+            return scope.stats().count;
+        };
+        auto per_frame = [](std::uint64_t short_clip, std::uint64_t long_clip) {
+            return (static_cast<double>(long_clip) - static_cast<double>(short_clip)) / 60.0;
+        };
+
+        const double ffmpeg_per_frame = per_frame(count_reference("short.mp4", "rs.mp4"), count_reference("long.mp4", "rl.mp4"));
+        const double loop_per_frame = per_frame(count("short.mp4", "s.mp4"), count("long.mp4", "l.mp4"));
+        EXPECT_LE(loop_per_frame, ffmpeg_per_frame + max_extra_allocs_per_frame)
+            << "FFmpeg alone needs " << ffmpeg_per_frame << " allocations per frame";
+    }
+
+} // namespace media_handler::tests
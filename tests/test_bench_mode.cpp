@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+#include "compressor/bench_mode.h"
+#include "test_common.h"
+#include <filesystem>
+#include <fstream>
+
+namespace media_handler::tests {
+
+    namespace fs = std::filesystem;
+    using namespace media_handler::compressor;
+
+    class BenchModeTest : public TestCommon {};
+
+    /// @brief Verify mean and sample standard deviation of the derived metrics.
+    TEST_F(BenchModeTest, Summarize_MeanAndStddev) {
+        std::vector<BenchRun> runs = {
+            { 1.0, 10, 10 * 1'048'576, 5 * 1'048'576, 100 * 1'048'576 },
+            { 2.0, 10, 10 * 1'048'576, 5 * 1'048'576, 200 * 1'048'576 },
+        };
+        auto s = summarize(runs);
+        EXPECT_EQ(s.runs, 2u);
+        EXPECT_DOUBLE_EQ(s.files_per_sec.mean, 7.5);
+        EXPECT_NEAR(s.files_per_sec.stddev, 3.5355, 1e-3);
+        EXPECT_DOUBLE_EQ(s.mb_per_sec.mean, 7.5);
+        EXPECT_DOUBLE_EQ(s.ratio.mean, 0.5);
+        EXPECT_DOUBLE_EQ(s.ratio.stddev, 0.0);
+        EXPECT_DOUBLE_EQ(s.peak_rss_mb.mean, 150.0);
+
+        auto one = summarize({ runs[0] });
+        EXPECT_DOUBLE_EQ(one.files_per_sec.stddev, 0.0);
+    }
+
+    TEST_F(BenchModeTest, ParseCache) {
+        EXPECT_EQ(parse_bench_cache("warm"), BenchCache::Warm);
+        EXPECT_EQ(parse_bench_cache("cold"), BenchCache::Cold);
+        EXPECT_EQ(parse_bench_cache("drop"), BenchCache::Drop);
+        EXPECT_FALSE(parse_bench_cache("hot"));
+    }
+
+    /// @brief Verify every run processes the whole corpus, and neither state nor outputs are left behind.
+    TEST_F(BenchModeTest, RunBench_RepeatsWithoutState) {
+        fs::create_directories(path("in"));
+        for (int i = 0; i < 5; ++i) std::ofstream(path("in/clip" + std::to_string(i) + ".mp4")) << "fake";
+
+        utils::Config cfg;
+        cfg.input_dir = path("in").string();
+        cfg.output_dir = path("out").string();
+        cfg.threads = 2;
+        cfg.heartbeat_interval = 0;
+        fs::create_directories(cfg.output_dir);
+
+        auto result = run_bench(cfg, { 2, BenchCache::Cold }, spdlog::default_logger());
+        ASSERT_TRUE(result.has_value()) << result.error();
+        EXPECT_EQ(result->runs, 2u);
+        EXPECT_GT(result->files_per_sec.mean, 0.0);
+        EXPECT_TRUE(fs::is_empty(cfg.output_dir)); // No scratch dir, no .mediahandler_state.
+    }
+
+    TEST_F(BenchModeTest, RunBench_EmptyInputFails) {
+        fs::create_directories(path("in"));
+        utils::Config cfg;
+        cfg.input_dir = path("in").string();
+        cfg.output_dir = path("out").string();
+        EXPECT_FALSE(run_bench(cfg, {}, spdlog::default_logger()).has_value());
+    }
+
+} // namespace media_handler::tests
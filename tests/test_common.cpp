@@ -1,5 +1,7 @@
 #include "test_common.h"
 #include <chrono>
+#include <cstdint>
+#include <fstream>
 
 namespace media_handler::tests{
 
@@ -31,4 +33,16 @@ void TestCommon::TearDown() {
 std::filesystem::path TestCommon::path(const std::string& filename) const {
     return test_dir / filename;
 }
+
+void TestCommon::make_file(const std::filesystem::path& path, std::size_t bytes) {
+    std::ofstream f(path, std::ios::binary);
+    std::string data(bytes, 'x');
+    f.write(data.data(), data.size());
+}
+
+void TestCommon::burn_cpu(std::chrono::milliseconds d) {
+    volatile std::uint64_t x = 0;
+    auto until = std::chrono::steady_clock::now() + d;
+    while (std::chrono::steady_clock::now() < until) x = x + 1;
+}
 } // namespace media_handler::tests
\ No newline at end of file
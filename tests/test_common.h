@@ -1,5 +1,7 @@
 #pragma once
 #include <gtest/gtest.h>
+#include <chrono>
+#include <cstddef>
 #include <filesystem>
 #include <string>
 #include <utils/utils.h>
@@ -17,5 +19,11 @@ namespace media_handler::tests {
 
         /// @brief Get full path to a file in the test temp directory
         std::filesystem::path path(const std::string& filename) const;
+
+        /// @brief Create (or overwrite) a file of `bytes` filler bytes
+        static void make_file(const std::filesystem::path& path, std::size_t bytes);
+
+        /// @brief Spin on the calling thread for roughly the given wall time
+        static void burn_cpu(std::chrono::milliseconds d);
     };
 } // namespace media_handler::tests
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include "compressor/compression_engine.h"
 #include "utils/config.h"
 #include "utils/utils.h"
+#include "fake_processor.h"
 #include <fstream>
 
 namespace media_handler::tests {
@@ -45,4 +46,32 @@ namespace media_handler::tests {
 
         SUCCEED();  // no crash = success
     }
-} // namespace mediahandler::tests
\ No newline at end of file
+
+    /// @brief Test that migrate dispatches to injected processors by kind and counts their outcomes
+    TEST_F(CompressionEngineTest, MigrateUsesInjectedProcessors) {
+        utils::Config cfg;
+        cfg.threads = 3;
+        cfg.input_dir = path("in").string();
+        cfg.output_dir = path("out").string();
+        cfg.heartbeat_interval = 0;
+
+        auto image = std::make_shared<FakeProcessor>(FakeProfile{ Distribution::uniform(0, 200), Distribution::fixed(64) });
+        auto video = std::make_shared<FakeProcessor>(FakeProfile{ Distribution::fixed(50), {}, true, 1.0 });
+        compressor::CompressionEngine engine(cfg, { image, video });
+
+        // Files need not exist: the fakes never open them.
+        std::vector<fs::path> files;
+        for (int i = 0; i < 30; ++i) files.push_back(path("in/img" + std::to_string(i) + ".jpg"));
+        for (int i = 0; i < 10; ++i) files.push_back(path("in/clip" + std::to_string(i) + ".mov"));
+        image->trace(files.size());
+
+        auto snap = engine.migrate(files, { .ignore_state = true });
+
+        EXPECT_EQ(image->call_count(), 30u);
+        EXPECT_EQ(video->call_count(), 10u);
+        EXPECT_EQ(snap.completed, 30u);
+        EXPECT_EQ(snap.failed, 10u);
+        EXPECT_EQ(image->trace_result().size(), 30u);
+        EXPECT_FALSE(fs::exists(path("out/.mediahandler_state")));
+    }
+} // namespace mediahandler::tests
@@ -123,4 +123,143 @@ namespace media_handler::tests {
         EXPECT_TRUE(result.error().find("type_error.302") != std::string::npos);
         EXPECT_TRUE(result.error().find("type must be number") != std::string::npos);
     }
+
+    /// @brief log_overflow must name a known policy
+    TEST_F(ConfigTest, UnknownLogOverflow_ReturnsError) {
+        auto logger = media_handler::utils::Logger::create("UnknownLogOverflow", spdlog::level::info, true);
+
+        {
+            std::ofstream f(CONFIG_FILE);
+            f << R"({ "general": { "log_overflow": "drop-new" } })";
+        }
+        auto result = media_handler::utils::Config::load(CONFIG_FILE, logger);
+        ASSERT_TRUE(result.has_value()) << result.error();
+        EXPECT_EQ(result->log_overflow, "drop-new");
+
+        {
+            std::ofstream f(CONFIG_FILE);
+            f << R"({ "general": { "log_overflow": "sometimes" } })";
+        }
+        result = media_handler::utils::Config::load(CONFIG_FILE, logger);
+        ASSERT_FALSE(result.has_value());
+        EXPECT_NE(result.error().find("log_overflow"), std::string::npos);
+    }
+
+    /// @brief image.jpeg_mode is read from its own section and must name a known mode
+    TEST_F(ConfigTest, JpegMode_ReadAndValidated) {
+        auto logger = media_handler::utils::Logger::create("JpegMode", spdlog::level::info, true);
+
+        {
+            std::ofstream f(CONFIG_FILE);
+            f << R"({ "image": { "jpeg_mode": "auto" } })";
+        }
+        auto result = media_handler::utils::Config::load(CONFIG_FILE, logger);
+        ASSERT_TRUE(result.has_value()) << result.error();
+        EXPECT_EQ(result->jpeg_mode, "auto");
+
+        {
+            std::ofstream f(CONFIG_FILE);
+            f << R"({ "image": { "jpeg_mode": "jpegtran" } })";
+        }
+        result = media_handler::utils::Config::load(CONFIG_FILE, logger);
+        ASSERT_FALSE(result.has_value());
+        EXPECT_NE(result.error().find("jpeg_mode"), std::string::npos);
+    }
+
+    TEST_F(ConfigTest, JpegProfile_ReadAndValidated) {
+        auto logger = media_handler::utils::Logger::create("JpegProfile", spdlog::level::info, true);
+
+        {
+            std::ofstream f(CONFIG_FILE);
+            f << R"({ "image": { "jpeg_profile": "max-compression" } })";
+        }
+        auto result = media_handler::utils::Config::load(CONFIG_FILE, logger);
+        ASSERT_TRUE(result.has_value()) << result.error();
+        EXPECT_EQ(result->jpeg_profile, "max-compression");
+
+        {
+            std::ofstream f(CONFIG_FILE);
+            f << R"({ "image": { "jpeg_profile": "turbo" } })";
+        }
+        result = media_handler::utils::Config::load(CONFIG_FILE, logger);
+        ASSERT_FALSE(result.has_value());
+        EXPECT_NE(result.error().find("jpeg_profile"), std::string::npos);
+    }
+
+    TEST_F(ConfigTest, JpegTargets_ReadAndValidated) {
+        auto logger = media_handler::utils::Logger::create("JpegTargets", spdlog::level::info, true);
+
+        {
+            std::ofstream f(CONFIG_FILE);
+            f << R"({ "image": { "jpeg_target_ssim": 0.95 } })";
+        }
+        auto result = media_handler::utils::Config::load(CONFIG_FILE, logger);
+        ASSERT_TRUE(result.has_value()) << result.error();
+        EXPECT_DOUBLE_EQ(result->jpeg_target_ssim, 0.95);
+        EXPECT_DOUBLE_EQ(result->jpeg_target_bpp, 0.0);
+
+        {
+            std::ofstream f(CONFIG_FILE);
+            f << R"({ "image": { "jpeg_target_bpp": 1.5 } })";
+        }
+        result = media_handler::utils::Config::load(CONFIG_FILE, logger);
+        ASSERT_TRUE(result.has_value()) << result.error();
+        EXPECT_DOUBLE_EQ(result->jpeg_target_bpp, 1.5);
+
+        {
+            std::ofstream f(CONFIG_FILE);
+            f << R"({ "image": { "jpeg_target_ssim": 0.95, "jpeg_target_bpp": 1.5 } })";
+        }
+        result = media_handler::utils::Config::load(CONFIG_FILE, logger);
+        ASSERT_FALSE(result.has_value());
+        EXPECT_NE(result.error().find("not both"), std::string::npos);
+
+        {
+            std::ofstream f(CONFIG_FILE);
+            f << R"({ "image": { "jpeg_target_ssim": 1.2 } })";
+        }
+        result = media_handler::utils::Config::load(CONFIG_FILE, logger);
+        ASSERT_FALSE(result.has_value());
+        EXPECT_NE(result.error().find("jpeg_target_ssim"), std::string::npos);
+    }
+
+    TEST_F(ConfigTest, JpegVerifySsim_ReadAndValidated) {
+        auto logger = media_handler::utils::Logger::create("JpegVerifySsim", spdlog::level::info, true);
+
+        {
+            std::ofstream f(CONFIG_FILE);
+            f << R"({ "image": { "jpeg_verify_ssim": 0.9, "jpeg_target_ssim": 0.95 } })";
+        }
+        auto result = media_handler::utils::Config::load(CONFIG_FILE, logger);
+        ASSERT_TRUE(result.has_value()) << result.error();
+        EXPECT_DOUBLE_EQ(result->jpeg_verify_ssim, 0.9);
+
+        {
+            std::ofstream f(CONFIG_FILE);
+            f << R"({ "image": { "jpeg_verify_ssim": 1.0 } })";
+        }
+        result = media_handler::utils::Config::load(CONFIG_FILE, logger);
+        ASSERT_FALSE(result.has_value());
+        EXPECT_NE(result.error().find("jpeg_verify_ssim"), std::string::npos);
+    }
+
+    TEST_F(ConfigTest, JpegMinSavings_ReadAndValidated) {
+        auto logger = media_handler::utils::Logger::create("JpegMinSavings", spdlog::level::info, true);
+
+        {
+            std::ofstream f(CONFIG_FILE);
+            f << R"({ "image": { "jpeg_min_savings": 0.1 } })";
+        }
+        auto result = media_handler::utils::Config::load(CONFIG_FILE, logger);
+        ASSERT_TRUE(result.has_value()) << result.error();
+        EXPECT_DOUBLE_EQ(result->jpeg_min_savings, 0.1);
+
+        {
+            std::ofstream f(CONFIG_FILE);
+            f << R"({ "image": { "jpeg_min_savings": 1.5 } })";
+        }
+        result = media_handler::utils::Config::load(CONFIG_FILE, logger);
+        ASSERT_FALSE(result.has_value());
+        EXPECT_NE(result.error().find("jpeg_min_savings"), std::string::npos);
+    }
 } // namespace media_handler::tests
\ No newline at end of file
@@ -0,0 +1,160 @@
+#include <gtest/gtest.h>
+#include "utils/control_server.h"
+#include "compressor/compression_engine.h"
+#include "fake_processor.h"
+#include "test_common.h"
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <thread>
+#include <nlohmann/json.hpp>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace media_handler::tests {
+
+    namespace fs = std::filesystem;
+    using utils::ControlServer;
+
+    class ControlServerTest : public TestCommon {
+    protected:
+        std::shared_ptr<spdlog::logger> logger = spdlog::default_logger();
+
+        void SetUp() override {
+            TestCommon::SetUp();
+#ifdef _WIN32
+            GTEST_SKIP() << "Unix-domain control socket";
+#endif
+        }
+
+        nlohmann::json send(const std::string& command) {
+            auto response = ControlServer::request(path("ctl.sock"), command);
+            EXPECT_TRUE(response) << response.error();
+            return response ? nlohmann::json::parse(*response) : nlohmann::json();
+        }
+    };
+
+    TEST_F(ControlServerTest, RequestGetsHandlerResponse) {
+        auto server = ControlServer::start(path("ctl.sock"), [](std::string_view cmd) {
+            return "echo:" + std::string(cmd);
+            }, logger);
+        ASSERT_TRUE(server) << server.error();
+        EXPECT_EQ((fs::status(path("ctl.sock")).permissions() & fs::perms::all), fs::perms::owner_read | fs::perms::owner_write);
+
+        auto r1 = ControlServer::request(path("ctl.sock"), "status");
+        ASSERT_TRUE(r1) << r1.error();
+        EXPECT_EQ(*r1, "echo:status");
+        auto r2 = ControlServer::request(path("ctl.sock"), "workers 2");
+        ASSERT_TRUE(r2) << r2.error();
+        EXPECT_EQ(*r2, "echo:workers 2");
+    }
+
+    TEST_F(ControlServerTest, Start_OwnerOnlyWithoutChangingUmask) {
+#ifndef _WIN32
+        const auto saved = ::umask(0);
+        auto server = ControlServer::start(path("ctl.sock"), [](std::string_view) { return std::string("x"); }, logger);
+        const auto during = ::umask(saved);
+        ASSERT_TRUE(server) << server.error();
+        EXPECT_EQ(during, 0u); // Files other threads create meanwhile keep the process's own mode.
+        EXPECT_EQ((fs::status(path("ctl.sock")).permissions() & fs::perms::all), fs::perms::owner_read | fs::perms::owner_write);
+#endif
+    }
+
+    TEST_F(ControlServerTest, StopRemovesSocket) {
+        {
+            auto server = ControlServer::start(path("ctl.sock"), [](std::string_view) { return std::string("x"); }, logger);
+            ASSERT_TRUE(server) << server.error();
+            EXPECT_TRUE(fs::exists(path("ctl.sock")));
+        }
+        EXPECT_FALSE(fs::exists(path("ctl.sock")));
+        EXPECT_FALSE(ControlServer::request(path("ctl.sock"), "status"));
+    }
+
+    TEST_F(ControlServerTest, RefusesSocketInUseOrOtherFile) {
+        auto first = ControlServer::start(path("ctl.sock"), [](std::string_view) { return std::string("first"); }, logger);
+        ASSERT_TRUE(first) << first.error();
+        EXPECT_FALSE(ControlServer::start(path("ctl.sock"), [](std::string_view) { return std::string("second"); }, logger));
+
+        std::ofstream(path("plain.txt")) << "not a socket";
+        EXPECT_FALSE(ControlServer::start(path("plain.txt"), [](std::string_view) { return std::string(); }, logger));
+    }
+
+#ifndef _WIN32
+    /// @brief A socket file left behind by a crashed run (nobody listening) is replaced.
+    TEST_F(ControlServerTest, ReplacesStaleSocket) {
+        {
+            const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+            sockaddr_un addr{};
+            addr.sun_family = AF_UNIX;
+            std::strncpy(addr.sun_path, path("ctl.sock").c_str(), sizeof(addr.sun_path) - 1);
+            ASSERT_EQ(::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0);
+            ::close(fd);
+        }
+        ASSERT_TRUE(fs::is_socket(path("ctl.sock")));
+
+        auto server = ControlServer::start(path("ctl.sock"), [](std::string_view) { return std::string("fresh"); }, logger);
+        ASSERT_TRUE(server) << server.error();
+        auto r = ControlServer::request(path("ctl.sock"), "status");
+        ASSERT_TRUE(r) << r.error();
+        EXPECT_EQ(*r, "fresh");
+    }
+#endif
+
+    /// @brief Pause stops new dispatch without touching running files; resume and a lower worker count apply live.
+    TEST_F(ControlServerTest, Engine_PauseResumeAndWorkers) {
+        utils::Config cfg;
+        cfg.threads = 4;
+        cfg.input_dir = path("in").string();
+        cfg.output_dir = path("out").string();
+        cfg.heartbeat_interval = 0;
+        cfg.control_socket = path("ctl.sock").string();
+
+        auto fake = std::make_shared<FakeProcessor>(FakeProfile{ Distribution::fixed(20'000), {} }); // 20 ms per file.
+        compressor::CompressionEngine engine(cfg, { fake, fake });
+
+        std::vector<fs::path> files;
+        for (int i = 0; i < 200; ++i) files.push_back(path("in/img" + std::to_string(i) + ".jpg"));
+        auto run = std::async(std::launch::async, [&] { return engine.migrate(files, { .ignore_state = true }); });
+
+        // Wait for the socket and some progress.
+        while (!fs::exists(path("ctl.sock"))) std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        while (fake->call_count() < 8) std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+        auto paused = send("pause");
+        EXPECT_EQ(paused["ok"], true);
+        std::this_thread::sleep_for(std::chrono::milliseconds(100)); // In-flight files finish.
+        const auto at_pause = fake->call_count();
+        std::this_thread::sleep_for(std::chrono::milliseconds(150));
+        EXPECT_EQ(fake->call_count(), at_pause) << "files were started while paused";
+
+        auto status = send("status");
+        EXPECT_EQ(status["paused"], true);
+        EXPECT_EQ(status["active"], 0);
+        EXPECT_EQ(status["total"], 200);
+        EXPECT_EQ(status["pool"], 4);
+        EXPECT_GT(status["queued"].get<int>(), 0);
+
+        EXPECT_EQ(send("workers 0")["ok"], false);
+        EXPECT_EQ(send("workers 5")["ok"], false);
+        EXPECT_EQ(send("workers 1")["workers"], 1);
+        EXPECT_EQ(send("bogus")["ok"], false);
+        EXPECT_EQ(send("flush")["ok"], true);
+        EXPECT_EQ(send("resume")["paused"], false);
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        auto running = send("status");
+        EXPECT_LE(running["active"].get<int>(), 1);
+        EXPECT_EQ(send("workers 4")["workers"], 4);
+
+        auto snap = run.get();
+        EXPECT_EQ(snap.completed, 200u);
+        EXPECT_EQ(fake->call_count(), 200u);
+        EXPECT_FALSE(fs::exists(path("ctl.sock")));
+    }
+
+} // namespace media_handler::tests
@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+#include "tools/corpus_generator.h"
+#include "test_common.h"
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+namespace media_handler::tests {
+
+    namespace fs = std::filesystem;
+    using namespace media_handler::tools;
+
+    class CorpusGeneratorTest : public TestCommon {
+    protected:
+        /// @brief Small JPEG/PNG-only spec; HEIC and video need encoders not every build has.
+        CorpusSpec small_spec(const fs::path& root, std::uint32_t seed) {
+            CorpusSpec spec;
+            spec.root = root;
+            spec.seed = seed;
+            spec.jpeg = 4;
+            spec.png = 2;
+            spec.heic = 0;
+            spec.video = 0;
+            spec.corrupt = 1;
+            spec.truncated = 1;
+            spec.resolutions = { { 64, 48 }, { 96, 64 } };
+            return spec;
+        }
+
+        static std::string read_all(const fs::path& file) {
+            std::ifstream f(file, std::ios::binary);
+            return { std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>() };
+        }
+    };
+
+    /// @brief Verify the same spec and seed produce byte-identical files at the same paths.
+    TEST_F(CorpusGeneratorTest, SameSeed_IsByteIdentical) {
+        auto a = generate_corpus(small_spec(path("a"), 7));
+        auto b = generate_corpus(small_spec(path("b"), 7));
+        ASSERT_TRUE(a.has_value()) << a.error();
+        ASSERT_TRUE(b.has_value()) << b.error();
+        ASSERT_EQ(a->size(), 8u);
+        ASSERT_EQ(a->size(), b->size());
+
+        for (std::size_t i = 0; i < a->size(); ++i) {
+            EXPECT_EQ((*a)[i].path, (*b)[i].path);
+            EXPECT_EQ(read_all(path("a") / (*a)[i].path), read_all(path("b") / (*b)[i].path)) << (*a)[i].path;
+        }
+        EXPECT_EQ(read_all(path("a") / "manifest.ndjson"), read_all(path("b") / "manifest.ndjson"));
+    }
+
+    /// @brief Verify a different seed changes the content.
+    TEST_F(CorpusGeneratorTest, DifferentSeed_Differs) {
+        auto a = generate_corpus(small_spec(path("a"), 1));
+        auto b = generate_corpus(small_spec(path("b"), 2));
+        ASSERT_TRUE(a.has_value() && b.has_value());
+        EXPECT_NE(read_all(path("a") / "manifest.ndjson"), read_all(path("b") / "manifest.ndjson"));
+    }
+
+    /// @brief Verify defects are present and damaged, and nesting stays within depth.
+    TEST_F(CorpusGeneratorTest, Defects_AndDepth) {
+        auto spec = small_spec(path("c"), 3);
+        spec.depth = 1;
+        auto files = generate_corpus(spec);
+        ASSERT_TRUE(files.has_value()) << files.error();
+
+        std::size_t corrupt = 0, truncated = 0;
+        for (const auto& f : *files) {
+            const auto abs = path("c") / f.path;
+            ASSERT_TRUE(fs::exists(abs)) << f.path;
+            EXPECT_EQ(fs::file_size(abs), f.size);
+            EXPECT_LE(std::distance(f.path.begin(), f.path.end()), 2) << f.path;
+            if (f.defect == "corrupt") ++corrupt;
+            if (f.defect == "truncated") {
+                ++truncated;
+                // A truncated JPEG loses its EOI marker.
+                const auto bytes = read_all(abs);
+                ASSERT_GE(bytes.size(), 2u);
+                EXPECT_FALSE(bytes[bytes.size() - 2] == '\xFF' && bytes.back() == '\xD9');
+            }
+        }
+        EXPECT_EQ(corrupt, 1u);
+        EXPECT_EQ(truncated, 1u);
+    }
+
+    /// @brief Verify WIDTHxHEIGHT parsing.
+    TEST_F(CorpusGeneratorTest, ParseResolution) {
+        EXPECT_EQ(parse_resolution("1920x1080"), (std::pair{ 1920, 1080 }));
+        EXPECT_EQ(parse_resolution("640X360"), (std::pair{ 640, 360 }));
+        EXPECT_FALSE(parse_resolution("1920"));
+        EXPECT_FALSE(parse_resolution("0x10"));
+        EXPECT_FALSE(parse_resolution("12x34px"));
+    }
+
+} // namespace media_handler::tests
@@ -0,0 +1,62 @@
+#include <gtest/gtest.h>
+#include "compressor/dct_requantize.h"
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace media_handler::tests {
+
+    using namespace media_handler::compressor;
+
+    class DctRequantizeTest : public ::testing::Test {
+    protected:
+        static std::vector<std::int16_t> random_blocks(std::size_t blocks, std::uint32_t seed) {
+            std::mt19937 rng(seed);
+            std::uniform_int_distribution<int> value(-1024, 1023);
+            std::vector<std::int16_t> c(blocks * DCT_BLOCK);
+            for (auto& v : c) v = static_cast<std::int16_t>(value(rng));
+            return c;
+        }
+
+        static RequantTable table(std::uint16_t source, std::uint16_t target) {
+            std::uint16_t s[DCT_BLOCK], t[DCT_BLOCK];
+            std::fill(std::begin(s), std::end(s), source);
+            std::fill(std::begin(t), std::end(t), target);
+            return make_requant_table(s, t);
+        }
+    };
+
+    /// @brief The SIMD kernel produces exactly what the scalar reference does, ties included.
+    TEST_F(DctRequantizeTest, Simd_MatchesScalar) {
+        std::uint16_t s[DCT_BLOCK], t[DCT_BLOCK];
+        for (std::size_t k = 0; k < DCT_BLOCK; ++k) {
+            s[k] = static_cast<std::uint16_t>(2 + k % 17);
+            t[k] = static_cast<std::uint16_t>(s[k] + k % 5 * 3);
+        }
+        const auto factors = make_requant_table(s, t);
+        auto simd = random_blocks(257, 11);
+        auto scalar = simd;
+        requantize_blocks(simd.data(), 257, factors);
+        requantize_blocks_scalar(scalar.data(), 257, factors);
+        EXPECT_EQ(simd, scalar) << "kernel: " << requantize_kernel();
+    }
+
+    /// @brief Equal tables leave every coefficient untouched.
+    TEST_F(DctRequantizeTest, SameTable_IsIdentity) {
+        auto c = random_blocks(16, 3);
+        const auto before = c;
+        requantize_blocks(c.data(), 16, table(7, 7));
+        EXPECT_EQ(c, before);
+    }
+
+    /// @brief Doubling the step halves the coefficient, rounding to nearest (ties to even).
+    TEST_F(DctRequantizeTest, DoubleStep_HalvesAndRounds) {
+        std::vector<std::int16_t> c(DCT_BLOCK, 0);
+        const std::int16_t in[] = { 0, 1, 2, 3, 4, 5, -1, -3, -5, 100, -101, 1023 };
+        const std::int16_t out[] = { 0, 0, 1, 2, 2, 2, 0, -2, -2, 50, -50, 512 };
+        std::copy(std::begin(in), std::end(in), c.begin());
+        requantize_blocks(c.data(), 1, table(4, 8));
+        for (std::size_t i = 0; i < std::size(in); ++i) EXPECT_EQ(c[i], out[i]) << "input " << in[i];
+    }
+
+} // namespace media_handler::tests
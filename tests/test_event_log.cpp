@@ -0,0 +1,180 @@
+#include <gtest/gtest.h>
+#include "utils/event_log.h"
+#include "utils/progress_tracker.h"
+#include "test_common.h"
+#include <fstream>
+#include <latch>
+#include <map>
+#include <thread>
+#include <vector>
+
+namespace media_handler::tests {
+
+    using utils::EventLog;
+    using utils::EventRecord;
+    using utils::EventType;
+
+    class EventLogTest : public TestCommon {
+    protected:
+        std::shared_ptr<spdlog::logger> logger = spdlog::default_logger();
+
+        void TearDown() override {
+            EventLog::stop();
+            TestCommon::TearDown();
+        }
+
+        EventRecord record(EventType type, std::string_view text, std::uint64_t a = 0, std::uint64_t b = 0, std::uint32_t c = 0) {
+            EventRecord e;
+            e.time_ns = 1'714'557'600'123'456'000ull; // 2024-05-01T10:00:00.123456Z
+            e.thread = 3;
+            e.type = type;
+            e.a = a;
+            e.b = b;
+            e.c = c;
+            e.text_len = static_cast<std::uint16_t>(text.size());
+            std::copy(text.begin(), text.end(), e.text);
+            return e;
+        }
+    };
+
+    TEST_F(EventLogTest, Disabled_EmitIsNoop) {
+        EXPECT_FALSE(EventLog::enabled());
+        EventLog::emit(EventType::FileStart, "a.jpg"); // No ring is touched, nothing to drain later.
+
+        ASSERT_TRUE(EventLog::start(path("events.bin"), logger));
+        EventLog::stop();
+        auto events = utils::read_events(path("events.bin"));
+        ASSERT_TRUE(events) << events.error();
+        EXPECT_TRUE(events->empty());
+    }
+
+    TEST_F(EventLogTest, ConcurrentEmit_AllRecordsWrittenInThreadOrder) {
+        constexpr int threads = 4, per_thread = 1000;
+        ASSERT_TRUE(EventLog::start(path("events.bin"), logger));
+
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; ++t)
+            workers.emplace_back([t] {
+            for (int i = 0; i < per_thread; ++i) EventLog::emit(EventType::FileOk, "f.jpg", t, i);
+                });
+        for (auto& w : workers) w.join();
+        EventLog::stop();
+
+        EXPECT_EQ(EventLog::dropped(), 0u);
+        EXPECT_EQ(EventLog::written(), static_cast<std::uint64_t>(threads * per_thread));
+
+        auto events = utils::read_events(path("events.bin"));
+        ASSERT_TRUE(events) << events.error();
+        ASSERT_EQ(events->size(), static_cast<std::size_t>(threads * per_thread));
+
+        // Records of one thread keep their emit order.
+        std::map<std::uint64_t, std::uint64_t> next;
+        for (const auto& e : *events) {
+            EXPECT_EQ(e.b, next[e.a]++);
+        }
+    }
+
+    TEST_F(EventLogTest, Drain_MergesThreadsByTime) {
+        ASSERT_TRUE(EventLog::start(path("events.bin"), logger));
+        std::latch first(1), second(1);
+        std::jthread worker([&] {
+            EventLog::emit(EventType::FileStart, "1.jpg");
+            first.count_down();
+            second.wait();
+            EventLog::emit(EventType::FileStart, "3.jpg");
+            });
+        first.wait();
+        EventLog::emit(EventType::FileStart, "2.jpg");
+        second.count_down();
+        worker.join();
+        EventLog::stop();
+
+        auto events = utils::read_events(path("events.bin"));
+        ASSERT_TRUE(events) << events.error();
+        ASSERT_EQ(events->size(), 3u);
+        for (std::size_t i = 1; i < events->size(); ++i) EXPECT_LE((*events)[i - 1].time_ns, (*events)[i].time_ns);
+        EXPECT_EQ(std::string((*events)[1].text, (*events)[1].text_len), "2.jpg");
+    }
+
+    TEST_F(EventLogTest, Drain_FreesRingsOfExitedThreads) {
+        ASSERT_TRUE(EventLog::start(path("events.bin"), logger));
+        EventLog::emit(EventType::FileStart, "main.jpg"); // The test thread's ring stays: it is still running.
+        const auto before = EventLog::rings();
+        for (int round = 0; round < 3; ++round) {
+            std::vector<std::jthread> workers;
+            for (int t = 0; t < 8; ++t) workers.emplace_back([] { EventLog::emit(EventType::FileStart, "w.jpg"); });
+        }
+        EventLog::stop();
+
+        EXPECT_LE(EventLog::rings(), before); // Rings left by earlier tests may be freed too.
+        auto events = utils::read_events(path("events.bin"));
+        ASSERT_TRUE(events) << events.error();
+        EXPECT_EQ(events->size(), 25u); // Freed only after their records were written.
+    }
+
+    TEST_F(EventLogTest, RestartTruncatesFile) {
+        ASSERT_TRUE(EventLog::start(path("events.bin"), logger));
+        EventLog::emit(EventType::FileStart, "first.jpg");
+        EventLog::stop();
+        ASSERT_TRUE(EventLog::start(path("events.bin"), logger));
+        EventLog::emit(EventType::FileStart, "second.jpg");
+        EventLog::stop();
+
+        auto events = utils::read_events(path("events.bin"));
+        ASSERT_TRUE(events) << events.error();
+        ASSERT_EQ(events->size(), 1u);
+        EXPECT_EQ(std::string_view((*events)[0].text, (*events)[0].text_len), "second.jpg");
+    }
+
+    TEST_F(EventLogTest, LongName_KeepsTail) {
+        ASSERT_TRUE(EventLog::start(path("events.bin"), logger));
+        EventLog::emit(EventType::FileStart, "a_very_long_directory_like_name_IMG_0001.jpg");
+        EventLog::stop();
+
+        auto events = utils::read_events(path("events.bin"));
+        ASSERT_TRUE(events) << events.error();
+        ASSERT_EQ(events->size(), 1u);
+        EXPECT_EQ(std::string_view((*events)[0].text, (*events)[0].text_len), "y_like_name_IMG_0001.jpg");
+    }
+
+    TEST_F(EventLogTest, ReadEvents_RejectsOtherFiles) {
+        std::ofstream(path("other.bin"), std::ios::binary) << "not an event log at all";
+        EXPECT_FALSE(utils::read_events(path("other.bin")));
+        EXPECT_FALSE(utils::read_events(path("missing.bin")));
+    }
+
+    TEST_F(EventLogTest, FormatText) {
+        EXPECT_EQ(utils::format_event_text(record(EventType::FileOk, "IMG_0001.jpg", 4'194'304, 1'258'291, 120)),
+            "2024-05-01T10:00:00.123456Z [T3] OK    IMG_0001.jpg 4.0MB -> 1.2MB 120ms");
+        EXPECT_EQ(utils::format_event_text(record(EventType::VideoBitrate, "", 8000, 2500, 5000)),
+            "2024-05-01T10:00:00.123456Z [T3] VIDEO source 8000kbps -> target 2500kbps max 5000kbps");
+    }
+
+    TEST_F(EventLogTest, FormatJson_EscapesName) {
+        EXPECT_EQ(utils::format_event_json(record(EventType::FileFail, "a\"b\\c.jpg", 100, 0, 7)),
+            R"({"timestamp": "2024-05-01T10:00:00.123456Z", "thread": 3, "event": "fail", "size_in": 100, "elapsed_ms": 7, "file": "a\"b\\c.jpg"})");
+    }
+
+    TEST_F(EventLogTest, ProgressTracker_EmitsStartAndOutcome) {
+        std::ofstream(path("in.jpg"), std::ios::binary) << std::string(2048, 'x');
+        std::ofstream(path("out.jpg"), std::ios::binary) << std::string(1024, 'x');
+
+        ASSERT_TRUE(EventLog::start(path("events.bin"), logger));
+        utils::ProgressTracker tracker(2, logger);
+        auto token = tracker.begin_file(path("in.jpg"), utils::MediaKind::Image);
+        tracker.finish_file(token, path("out.jpg"), true);
+        tracker.skip_file(path("done.jpg"));
+        EventLog::stop();
+
+        auto events = utils::read_events(path("events.bin"));
+        ASSERT_TRUE(events) << events.error();
+        ASSERT_EQ(events->size(), 3u);
+        EXPECT_EQ((*events)[0].type, EventType::FileStart);
+        EXPECT_EQ((*events)[1].type, EventType::FileOk);
+        EXPECT_EQ((*events)[1].a, 2048u);
+        EXPECT_EQ((*events)[1].b, 1024u);
+        EXPECT_EQ((*events)[2].type, EventType::FileSkip);
+        EXPECT_EQ(std::string_view((*events)[2].text, (*events)[2].text_len), "done.jpg");
+    }
+
+} // namespace media_handler::tests
@@ -1,9 +1,15 @@
 ﻿#include <gtest/gtest.h>
 #include "compressor/image_processor.h"
 #include "utils/utils.h"
+#include "utils/work_context.h"
 #include "test_common.h"
+#include "tools/synthetic_media.h"
+#include <jpeglib.h>
+#include <algorithm>
 #include <filesystem>
+#include <format>
 #include <fstream>
+#include <map>
 #include <cstdlib>
 
 namespace fs = std::filesystem;
@@ -189,4 +195,420 @@ TEST_F(ImageCompressionTest, CaseInsensitiveExtensions) {
     ASSERT_TRUE(result.success);
     EXPECT_TRUE(verify_jpeg_signature(output));
     verify_size(upper_input, output);
-}
\ No newline at end of file
+}
+
+/// @brief The JPEG path on synthetic images, so it runs without the sample directory.
+class JpegCompressTest : public media_handler::tests::TestCommon {
+protected:
+    struct Decoded {
+        unsigned width = 0;
+        unsigned height = 0;
+        double mean = 0.0; // Mean sample value over all channels.
+        bool progressive = false;
+        std::vector<JSAMPLE> pixels;
+    };
+
+    static Decoded decode(const fs::path& file) {
+        Decoded d;
+        FILE* f = media_handler::utils::fopen_path(file, "rb");
+        if (!f) return d;
+        jpeg_decompress_struct cinfo;
+        jpeg_error_mgr jerr;
+        cinfo.err = jpeg_std_error(&jerr);
+        jpeg_create_decompress(&cinfo);
+        jpeg_stdio_src(&cinfo, f);
+        jpeg_read_header(&cinfo, TRUE);
+        jpeg_start_decompress(&cinfo);
+        d.width = cinfo.output_width;
+        d.height = cinfo.output_height;
+        d.progressive = cinfo.progressive_mode;
+        const std::size_t stride = static_cast<std::size_t>(cinfo.output_width) * cinfo.output_components;
+        d.pixels.resize(stride * cinfo.output_height);
+        while (cinfo.output_scanline < cinfo.output_height) {
+            JSAMPROW rows[1] = { d.pixels.data() + stride * cinfo.output_scanline };
+            jpeg_read_scanlines(&cinfo, rows, 1);
+        }
+        double sum = 0.0;
+        for (auto v : d.pixels) sum += v;
+        d.mean = sum / static_cast<double>(d.pixels.size());
+        jpeg_finish_decompress(&cinfo);
+        jpeg_destroy_decompress(&cinfo);
+        fclose(f);
+        return d;
+    }
+
+    /// @brief EXIF- and XMP-like APP1 payloads; they need not be valid EXIF/XMP to be kept.
+    static std::vector<std::string> sample_app1() {
+        return { std::string("Exif\0\0II*\0\x08\0\0\0opaque maker note \xff\x01", 34), "http://ns.adobe.com/xap/1.0/\0<x:xmpmeta/>" };
+    }
+
+    /// @brief Copy the JPEG `from` to `to` with an APP1 segment per payload spliced in right after SOI.
+    static void splice_app1(const fs::path& from, const fs::path& to, const std::vector<std::string>& payloads) {
+        auto bytes = media_handler::utils::read_file_bytes(from);
+        ASSERT_GT(bytes.size(), 2u);
+        std::vector<unsigned char> spliced(bytes.begin(), bytes.begin() + 2);
+        for (const auto& payload : payloads) {
+            const auto len = payload.size() + 2;
+            spliced.insert(spliced.end(), { 0xFF, 0xE1, static_cast<unsigned char>(len >> 8), static_cast<unsigned char>(len & 0xFF) });
+            spliced.insert(spliced.end(), payload.begin(), payload.end());
+        }
+        spliced.insert(spliced.end(), bytes.begin() + 2, bytes.end());
+        std::ofstream(to, std::ios::binary).write(reinterpret_cast<const char*>(spliced.data()), spliced.size());
+    }
+
+    /// @brief Payloads of the APP1 (EXIF/XMP) markers, in file order.
+    static std::vector<std::string> app1_markers(const fs::path& file) {
+        std::vector<std::string> markers;
+        FILE* f = media_handler::utils::fopen_path(file, "rb");
+        if (!f) return markers;
+        jpeg_decompress_struct cinfo;
+        jpeg_error_mgr jerr;
+        cinfo.err = jpeg_std_error(&jerr);
+        jpeg_create_decompress(&cinfo);
+        jpeg_stdio_src(&cinfo, f);
+        jpeg_save_markers(&cinfo, JPEG_APP0 + 1, 0xFFFF);
+        jpeg_read_header(&cinfo, TRUE);
+        for (auto* m = cinfo.marker_list; m; m = m->next)
+            markers.emplace_back(reinterpret_cast<const char*>(m->data), m->data_length);
+        jpeg_destroy_decompress(&cinfo);
+        fclose(f);
+        return markers;
+    }
+
+    static media_handler::compressor::ImageProcessor processor(const media_handler::utils::Config& config) {
+        auto logger = spdlog::default_logger()->clone("jpeg_compress_test");
+        logger->set_level(spdlog::level::off);
+        return media_handler::compressor::ImageProcessor(config, logger);
+    }
+
+    media_handler::compressor::ImageProcessor processor(const std::string& jpeg_mode = "reencode",
+        double min_savings = media_handler::utils::Config{}.jpeg_min_savings) {
+        media_handler::utils::Config config;
+        config.jpeg_mode = jpeg_mode;
+        config.jpeg_min_savings = min_savings;
+        return processor(config);
+    }
+
+    Decoded compress(int width, int height, int quality = 95, const std::string& jpeg_mode = "reencode",
+        double min_savings = media_handler::utils::Config{}.jpeg_min_savings) {
+        auto written = media_handler::tools::write_jpeg(path("in.jpg"), width, height, quality, 3);
+        EXPECT_TRUE(written.has_value()) << written.error();
+        auto result = processor(jpeg_mode, min_savings).compress(path("in.jpg"), path("out.jpg"));
+        EXPECT_TRUE(result.success) << result.message;
+        return decode(path("out.jpg"));
+    }
+};
+
+/// @brief A landscape photo above the trim box is scaled to fit its height, keeping the aspect ratio.
+TEST_F(JpegCompressTest, Landscape_FitsTrimBox) {
+    auto out = compress(4000, 3000);
+    EXPECT_EQ(out.width, 1440u);
+    EXPECT_EQ(out.height, 1080u);
+}
+
+/// @brief A portrait photo is limited by height as well.
+TEST_F(JpegCompressTest, Portrait_FitsTrimBox) {
+    auto out = compress(1500, 4000);
+    EXPECT_EQ(out.width, 405u);
+    EXPECT_EQ(out.height, 1080u);
+}
+
+/// @brief A photo more than 8x the trim box needs the full 1/8 DCT scale plus a resample.
+TEST_F(JpegCompressTest, Huge_FitsTrimBox) {
+    auto out = compress(16000, 2000);
+    EXPECT_EQ(out.width, 1920u);
+    EXPECT_EQ(out.height, 240u);
+}
+
+/// @brief Images inside the trim box keep their size.
+TEST_F(JpegCompressTest, Small_KeepsSize) {
+    auto out = compress(800, 600);
+    EXPECT_EQ(out.width, 800u);
+    EXPECT_EQ(out.height, 600u);
+}
+
+/// @brief Area averaging keeps overall brightness; dropping or duplicating rows would shift it.
+TEST_F(JpegCompressTest, Resample_PreservesMean) {
+    auto out = compress(2500, 1875);
+    const auto source = decode(path("in.jpg"));
+    EXPECT_EQ(out.width, 1440u);
+    EXPECT_NEAR(out.mean, source.mean, 1.5);
+}
+
+/// @brief APP1 segments (EXIF and XMP) are copied from the source byte for byte.
+TEST_F(JpegCompressTest, App1_CopiedUnchanged) {
+    ASSERT_TRUE(media_handler::tools::write_jpeg(path("plain.jpg"), 320, 240, 95, 3).has_value());
+    splice_app1(path("plain.jpg"), path("in.jpg"), sample_app1());
+
+    auto result = processor().compress(path("in.jpg"), path("out.jpg"));
+    ASSERT_TRUE(result.success) << result.message;
+    const auto in = app1_markers(path("in.jpg"));
+    ASSERT_EQ(in, sample_app1());
+    EXPECT_EQ(app1_markers(path("out.jpg")), in);
+
+    // Verified outputs are encoded from the whole decoded image, and keep them too.
+    media_handler::utils::Config verified;
+    verified.jpeg_verify_ssim = 0.5;
+    result = processor(verified).compress(path("in.jpg"), path("verified.jpg"));
+    ASSERT_TRUE(result.success) << result.message;
+    EXPECT_EQ(app1_markers(path("verified.jpg")), in);
+}
+
+/// @brief The reused per-thread buffers carry nothing over from a larger image to a smaller one.
+TEST_F(JpegCompressTest, BufferReuse_LargeThenSmall) {
+    compress(1600, 1200);
+    auto small = compress(64, 48);
+    EXPECT_EQ(small.width, 64u);
+    EXPECT_EQ(small.height, 48u);
+    EXPECT_LT(fs::file_size(path("out.jpg")), fs::file_size(path("in.jpg")) * 2);
+}
+
+/// @brief A truncated JPEG fails without leaving a partial output file behind.
+TEST_F(JpegCompressTest, Truncated_FailsWithoutOutput) {
+    ASSERT_TRUE(media_handler::tools::write_jpeg(path("full.jpg"), 640, 480, 95, 5).has_value());
+    fs::copy_file(path("full.jpg"), path("cut.jpg"));
+    fs::resize_file(path("cut.jpg"), 600);
+    auto result = processor().compress(path("cut.jpg"), path("cut_out.jpg"));
+    EXPECT_FALSE(result.success);
+    EXPECT_FALSE(fs::exists(path("cut_out.jpg")));
+}
+
+/// @brief Lossless mode keeps every decoded pixel, writes progressive scans and is smaller than the source.
+TEST_F(JpegCompressTest, Lossless_SamePixelsSmallerFile) {
+    auto out = compress(640, 480, 90, "lossless");
+    const auto source = decode(path("in.jpg"));
+    EXPECT_TRUE(out.progressive);
+    EXPECT_EQ(out.pixels, source.pixels);
+    EXPECT_LT(fs::file_size(path("out.jpg")), fs::file_size(path("in.jpg")));
+}
+
+/// @brief Lossless mode cannot resize, so oversized photos are still re-encoded to the trim box.
+TEST_F(JpegCompressTest, Lossless_OversizedStillResized) {
+    auto out = compress(2500, 1875, 90, "lossless");
+    EXPECT_FALSE(out.progressive);
+    EXPECT_EQ(out.width, 1440u);
+}
+
+/// @brief Requantize moves a fine source onto the quality-80 tables: smaller, same size, little drift.
+TEST_F(JpegCompressTest, Requantize_SmallerAtQuality80) {
+    auto out = compress(640, 480, 95, "requantize");
+    const auto source = decode(path("in.jpg"));
+    EXPECT_EQ(out.width, 640u);
+    EXPECT_FALSE(out.progressive);
+    EXPECT_NE(out.pixels, source.pixels);
+    EXPECT_NEAR(out.mean, source.mean, 1.0);
+    EXPECT_LT(fs::file_size(path("out.jpg")), fs::file_size(path("in.jpg")) * 3 / 4);
+}
+
+/// @brief Requantize never makes a step finer, so a source coarser than quality 80 keeps its pixels.
+TEST_F(JpegCompressTest, Requantize_CoarseSourceUnchanged) {
+    auto out = compress(640, 480, 50, "requantize", 0.0);
+    EXPECT_EQ(out.pixels, decode(path("in.jpg")).pixels);
+}
+
+/// @brief Auto keeps the coefficients of a source coarser than quality 80 and requantizes a finer one.
+TEST_F(JpegCompressTest, Auto_ChoosesBySourceQuantization) {
+    auto coarse = compress(640, 480, 60, "auto");
+    EXPECT_TRUE(coarse.progressive);
+    EXPECT_EQ(coarse.pixels, decode(path("in.jpg")).pixels);
+
+    auto fine = compress(640, 480, 95, "auto");
+    EXPECT_FALSE(fine.progressive);
+    EXPECT_NE(fine.pixels, decode(path("in.jpg")).pixels);
+}
+
+/// @brief A source at or below the target quality is predicted not to shrink and is copied byte for byte.
+TEST_F(JpegCompressTest, Passthrough_CoarseSourceCopied) {
+    ASSERT_TRUE(media_handler::tools::write_jpeg(path("in.jpg"), 640, 480, 60, 3).has_value());
+    auto result = processor("reencode", 0.05).compress(path("in.jpg"), path("out.jpg"));
+    ASSERT_TRUE(result.success) << result.message;
+    EXPECT_TRUE(result.passthrough);
+    EXPECT_NE(result.message.find("quality ~60"), std::string::npos) << result.message;
+    EXPECT_EQ(media_handler::utils::read_file_bytes(path("out.jpg")), media_handler::utils::read_file_bytes(path("in.jpg")));
+}
+
+/// @brief A fine source is still compressed, and the default threshold of 0 compresses even a coarse one.
+TEST_F(JpegCompressTest, Passthrough_OnlyBelowThreshold) {
+    ASSERT_TRUE(media_handler::tools::write_jpeg(path("in.jpg"), 640, 480, 95, 3).has_value());
+    auto fine = processor("reencode", 0.05).compress(path("in.jpg"), path("out.jpg"));
+    ASSERT_TRUE(fine.success) << fine.message;
+    EXPECT_FALSE(fine.passthrough);
+
+    ASSERT_TRUE(media_handler::tools::write_jpeg(path("in.jpg"), 640, 480, 60, 3).has_value());
+    auto forced = processor().compress(path("in.jpg"), path("out.jpg"));
+    ASSERT_TRUE(forced.success) << forced.message;
+    EXPECT_FALSE(forced.passthrough);
+}
+
+/// @brief Downscaling counts towards the predicted saving, so an oversized coarse photo is still resized.
+TEST_F(JpegCompressTest, Passthrough_OversizedStillResized) {
+    auto out = compress(2500, 1875, 60, "reencode", 0.05);
+    EXPECT_EQ(out.width, 1440u);
+}
+
+/// @brief With idle workers the photo is encoded in parallel strips: restart markers, same size and content.
+TEST_F(JpegCompressTest, ParallelStrips_WhenWorkersIdle) {
+    media_handler::utils::IdleWorkers::set(3);
+    auto out = compress(2500, 1875);
+    media_handler::utils::IdleWorkers::set(0);
+    const auto source = decode(path("in.jpg"));
+    EXPECT_EQ(out.width, 1440u);
+    EXPECT_EQ(out.height, 1080u);
+    EXPECT_NEAR(out.mean, source.mean, 1.5);
+
+    const auto bytes = media_handler::utils::read_file_bytes(path("out.jpg"));
+    const unsigned char dri[] = { 0xFF, 0xDD };
+    EXPECT_NE(std::search(bytes.begin(), bytes.end(), std::begin(dri), std::end(dri)), bytes.end());
+}
+
+/// @brief Files running at once share the idle workers: each reserves what is left and hands it back.
+TEST(IdleWorkersTest, ReservationsShareIdleCores) {
+    using media_handler::utils::IdleWorkers;
+    IdleWorkers::set(3);
+    {
+        auto first = IdleWorkers::reserve(2);
+        auto second = IdleWorkers::reserve(8);
+        auto third = IdleWorkers::reserve(8);
+        EXPECT_EQ(first.size(), 2u);
+        EXPECT_EQ(second.size(), 1u);
+        EXPECT_EQ(third.size(), 0u);
+        EXPECT_EQ(IdleWorkers::get(), 0u);
+        first.release();
+        EXPECT_EQ(IdleWorkers::get(), 2u);
+    }
+    EXPECT_EQ(IdleWorkers::get(), 3u);
+    IdleWorkers::set(0);
+}
+
+/// @brief A photo above jpeg_parallel_pixels is encoded in strips on its own worker when no core is idle,
+/// and the idle cores a strip encode reserves are handed back when it finishes.
+TEST_F(JpegCompressTest, ParallelStrips_ThresholdTakesNoUnreservedCores) {
+    ASSERT_TRUE(media_handler::tools::write_jpeg(path("in.jpg"), 1280, 960, 95, 3).has_value());
+    media_handler::utils::Config config;
+    config.jpeg_parallel_pixels = 1'000'000;
+    auto result = processor(config).compress(path("in.jpg"), path("out.jpg"));
+    ASSERT_TRUE(result.success) << result.message;
+    const auto bytes = media_handler::utils::read_file_bytes(path("out.jpg"));
+    const unsigned char dri[] = { 0xFF, 0xDD };
+    EXPECT_NE(std::search(bytes.begin(), bytes.end(), std::begin(dri), std::end(dri)), bytes.end());
+    EXPECT_EQ(media_handler::utils::IdleWorkers::get(), 0u);
+
+    media_handler::utils::IdleWorkers::set(3);
+    result = processor(config).compress(path("in.jpg"), path("out.jpg"));
+    ASSERT_TRUE(result.success) << result.message;
+    EXPECT_EQ(media_handler::utils::IdleWorkers::get(), 3u);
+    media_handler::utils::IdleWorkers::set(0);
+}
+
+/// @brief The strip path copies APP1 segments too: the source's saved markers outlive the whole-image decode.
+TEST_F(JpegCompressTest, ParallelStrips_KeepApp1) {
+    ASSERT_TRUE(media_handler::tools::write_jpeg(path("plain.jpg"), 1280, 960, 95, 3).has_value());
+    splice_app1(path("plain.jpg"), path("in.jpg"), sample_app1());
+
+    media_handler::utils::IdleWorkers::set(3);
+    auto result = processor().compress(path("in.jpg"), path("out.jpg"));
+    media_handler::utils::IdleWorkers::set(0);
+    ASSERT_TRUE(result.success) << result.message;
+    const auto bytes = media_handler::utils::read_file_bytes(path("out.jpg"));
+    const unsigned char dri[] = { 0xFF, 0xDD };
+    ASSERT_NE(std::search(bytes.begin(), bytes.end(), std::begin(dri), std::end(dri)), bytes.end()); // Strips were used.
+    EXPECT_EQ(app1_markers(path("out.jpg")), sample_app1());
+}
+
+/// @brief max-compression writes optimized progressive scans, smaller than balanced; fast stays close to it.
+TEST_F(JpegCompressTest, Profiles_TradeSpeedForSize) {
+    ASSERT_TRUE(media_handler::tools::write_jpeg(path("in.jpg"), 1280, 960, 95, 3).has_value());
+    const auto source = decode(path("in.jpg"));
+    std::map<std::string, std::uintmax_t> sizes;
+    for (const std::string profile : { "fast", "balanced", "max-compression" }) {
+        media_handler::utils::Config config;
+        config.jpeg_profile = profile;
+        const auto out = path(profile + ".jpg");
+        auto result = processor(config).compress(path("in.jpg"), out);
+        ASSERT_TRUE(result.success) << profile << ": " << result.message;
+        const auto decoded = decode(out);
+        EXPECT_EQ(decoded.width, 1280u) << profile;
+        EXPECT_NEAR(decoded.mean, source.mean, 1.0) << profile;
+        EXPECT_EQ(decoded.progressive, profile == "max-compression") << profile;
+        sizes[profile] = fs::file_size(out);
+    }
+    EXPECT_LT(sizes["max-compression"], sizes["balanced"]);
+}
+
+/// @brief A bit budget picks each image's quality: the output lands near the budget, from either side of quality 80.
+TEST_F(JpegCompressTest, TargetBpp_PicksQualityPerImage) {
+    ASSERT_TRUE(media_handler::tools::write_jpeg(path("in.jpg"), 1280, 960, 95, 3).has_value());
+    const auto fixed = processor().compress(path("in.jpg"), path("fixed.jpg"));
+    ASSERT_TRUE(fixed.success) << fixed.message;
+    for (const double bpp : { 0.5, 1.2 }) {
+        media_handler::utils::Config config;
+        config.jpeg_target_bpp = bpp;
+        const auto out = path(std::format("bpp{}.jpg", bpp));
+        auto result = processor(config).compress(path("in.jpg"), out);
+        ASSERT_TRUE(result.success) << result.message;
+        EXPECT_FALSE(result.passthrough);
+        EXPECT_EQ(decode(out).width, 1280u);
+        const double actual = fs::file_size(out) * 8.0 / (1280.0 * 960.0);
+        EXPECT_NEAR(actual, bpp, bpp * 0.1) << bpp;
+    }
+    EXPECT_LT(fs::file_size(path("bpp0.5.jpg")), fs::file_size(path("fixed.jpg")));
+    EXPECT_GT(fs::file_size(path("bpp1.2.jpg")), fs::file_size(path("fixed.jpg")));
+}
+
+/// @brief A searched quality is encoded from the whole decoded image in one pass, and still keeps APP1 segments.
+TEST_F(JpegCompressTest, TargetQuality_KeepsApp1) {
+    ASSERT_TRUE(media_handler::tools::write_jpeg(path("plain.jpg"), 640, 480, 95, 3).has_value());
+    splice_app1(path("plain.jpg"), path("in.jpg"), sample_app1());
+    media_handler::utils::Config ssim_target, bpp_target;
+    ssim_target.jpeg_target_ssim = 0.95;
+    bpp_target.jpeg_target_bpp = 1.0;
+    for (const auto& config : { ssim_target, bpp_target }) {
+        auto result = processor(config).compress(path("in.jpg"), path("out.jpg"));
+        ASSERT_TRUE(result.success) << result.message;
+        ASSERT_FALSE(result.passthrough) << result.message;
+        EXPECT_EQ(app1_markers(path("out.jpg")), sample_app1()) << config.jpeg_target_ssim;
+    }
+}
+
+/// @brief Verification records the output's SSIM; a threshold just above it forces a better re-encode,
+/// and one no quality reaches leaves the source copied unchanged.
+TEST_F(JpegCompressTest, VerifySsim_RetriesThenCopiesSource) {
+    ASSERT_TRUE(media_handler::tools::write_jpeg(path("in.jpg"), 1280, 960, 95, 3).has_value());
+    auto& context = media_handler::utils::WorkContext::current();
+    media_handler::utils::Config config;
+    config.jpeg_verify_ssim = 0.5;
+
+    context.reset();
+    auto result = processor(config).compress(path("in.jpg"), path("first.jpg"));
+    ASSERT_TRUE(result.success) << result.message;
+    EXPECT_FALSE(result.passthrough);
+    const double first = context.ssim;
+    EXPECT_GT(first, 0.5);
+    EXPECT_LT(first, 1.0);
+
+    config.jpeg_verify_ssim = first + 0.002;
+    context.reset();
+    result = processor(config).compress(path("in.jpg"), path("retried.jpg"));
+    ASSERT_TRUE(result.success) << result.message;
+    EXPECT_FALSE(result.passthrough) << result.message;
+    EXPECT_GE(context.ssim, config.jpeg_verify_ssim);
+    EXPECT_GT(fs::file_size(path("retried.jpg")), fs::file_size(path("first.jpg")));
+
+    config.jpeg_verify_ssim = 0.9999;
+    context.reset();
+    result = processor(config).compress(path("in.jpg"), path("copied.jpg"));
+    ASSERT_TRUE(result.success) << result.message;
+    EXPECT_TRUE(result.passthrough);
+    EXPECT_NE(result.message.find("SSIM"), std::string::npos) << result.message;
+    EXPECT_EQ(media_handler::utils::read_file_bytes(path("copied.jpg")), media_handler::utils::read_file_bytes(path("in.jpg")));
+    EXPECT_EQ(context.ssim, 0.0);
+
+    // An oversized photo is never copied: it keeps the resized output, with its score.
+    ASSERT_TRUE(media_handler::tools::write_jpeg(path("big.jpg"), 2500, 1875, 95, 3).has_value());
+    context.reset();
+    result = processor(config).compress(path("big.jpg"), path("big_out.jpg"));
+    ASSERT_TRUE(result.success) << result.message;
+    EXPECT_FALSE(result.passthrough);
+    EXPECT_EQ(decode(path("big_out.jpg")).width, 1440u);
+    EXPECT_GT(context.ssim, 0.0);
+}
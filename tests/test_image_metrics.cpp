@@ -0,0 +1,106 @@
+#include <gtest/gtest.h>
+#include "compressor/image_metrics.h"
+#include "tools/synthetic_media.h"
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace media_handler::tests {
+
+    using namespace media_handler::compressor;
+
+    class ImageMetricsTest : public ::testing::Test {
+    protected:
+        static constexpr unsigned W = 200, H = 120;
+
+        static std::vector<std::uint8_t> luma_of_synthetic(std::uint32_t seed) {
+            const auto rgb = tools::synthetic_rgb(W, H, seed);
+            std::vector<std::uint8_t> luma;
+            luma_plane(rgb.data(), W * 3, W, H, 3, luma);
+            return luma;
+        }
+
+        static std::vector<std::uint8_t> with_noise(std::vector<std::uint8_t> plane, int amplitude, std::uint32_t seed) {
+            std::mt19937 rng(seed);
+            std::uniform_int_distribution<int> noise(-amplitude, amplitude);
+            for (auto& v : plane) v = static_cast<std::uint8_t>(std::clamp(v + noise(rng), 0, 255));
+            return plane;
+        }
+
+        static LumaView view(const std::vector<std::uint8_t>& plane) { return { plane.data(), W, W, H }; }
+    };
+
+    /// @brief RGB primaries map to libjpeg's own luma values; CMYK has none.
+    TEST_F(ImageMetricsTest, Luma_MatchesLibjpegWeights) {
+        const std::uint8_t rgb[] = { 255, 0, 0, 0, 255, 0, 0, 0, 255, 255, 255, 255, 0, 0, 0 };
+        std::vector<std::uint8_t> luma;
+        luma_plane(rgb, sizeof(rgb), 5, 1, 3, luma);
+        EXPECT_EQ(luma, (std::vector<std::uint8_t>{ 76, 150, 29, 255, 0 }));
+
+        const std::uint8_t cmyk[] = { 1, 2, 3, 4 };
+        luma_plane(cmyk, 4, 1, 1, 4, luma);
+        EXPECT_TRUE(luma.empty());
+    }
+
+    /// @brief A plane scores 1 against itself, and lower the more noise is added.
+    TEST_F(ImageMetricsTest, Ssim_FallsWithNoise) {
+        const auto plane = luma_of_synthetic(4);
+        EXPECT_DOUBLE_EQ(ssim(view(plane), view(plane)), 1.0);
+
+        const auto light = with_noise(plane, 4, 1);
+        const auto heavy = with_noise(plane, 40, 1);
+        const double s_light = ssim(view(plane), view(light));
+        const double s_heavy = ssim(view(plane), view(heavy));
+        EXPECT_LT(s_light, 1.0);
+        EXPECT_GT(s_light, 0.8);
+        EXPECT_LT(s_heavy, s_light);
+        EXPECT_DOUBLE_EQ(ssim(view(light), view(plane)), s_light); // Symmetric.
+    }
+
+    /// @brief Strides larger than the width are honoured; mismatched sizes score 0; a tiny plane is one window.
+    TEST_F(ImageMetricsTest, Ssim_StrideSizeAndTinyPlanes) {
+        const auto plane = luma_of_synthetic(9);
+        std::vector<std::uint8_t> padded(static_cast<std::size_t>(W + 7) * H, 0xAA);
+        for (unsigned y = 0; y < H; ++y) std::copy_n(plane.data() + y * W, W, padded.data() + y * (W + 7));
+        EXPECT_DOUBLE_EQ(ssim(view(plane), { padded.data(), W + 7, W, H }), 1.0);
+
+        EXPECT_EQ(ssim(view(plane), { plane.data(), W, W, H - 1 }), 0.0);
+
+        const std::uint8_t a[] = { 10, 20, 30, 40, 50, 60 }, b[] = { 10, 20, 30, 40, 50, 90 };
+        EXPECT_DOUBLE_EQ(ssim({ a, 3, 3, 2 }, { a, 3, 3, 2 }), 1.0);
+        EXPECT_LT(ssim({ a, 3, 3, 2 }, { b, 3, 3, 2 }), 1.0);
+    }
+
+    /// @brief Every kernel the CPU runs scores like the scalar code, on widths that leave SIMD tails.
+    TEST_F(ImageMetricsTest, Simd_MatchesScalar) {
+        const auto plane = luma_of_synthetic(21);
+        const auto noisy = with_noise(plane, 25, 3);
+        const auto black = std::vector<std::uint8_t>(plane.size(), 0), white = std::vector<std::uint8_t>(plane.size(), 255);
+        for (const auto kernel : { SsimKernel::Sse41, SsimKernel::Avx2, SsimKernel::Neon }) {
+            if (!ssim_kernel_supported(kernel)) continue;
+            SCOPED_TRACE(to_string(kernel));
+            for (unsigned width : { W, W - 4, 37u, 8u }) {
+                const LumaView a{ plane.data(), W, width, H }, b{ noisy.data(), W, width, H };
+                EXPECT_NEAR(ssim(a, b, kernel), ssim(a, b, SsimKernel::Scalar), 1e-5);
+            }
+            // Extremes of the integer range.
+            EXPECT_NEAR(ssim(view(black), view(white), kernel), ssim(view(black), view(white), SsimKernel::Scalar), 1e-5);
+            EXPECT_DOUBLE_EQ(ssim(view(white), view(white), kernel), 1.0);
+        }
+        // Luma is bit-exact, including the scalar tail of a row.
+        const auto rgb = tools::synthetic_rgb(W, H, 5);
+        std::vector<std::uint8_t> scalar, simd;
+        for (const auto kernel : { SsimKernel::Sse41, SsimKernel::Avx2, SsimKernel::Neon }) {
+            if (!ssim_kernel_supported(kernel)) continue;
+            for (unsigned width : { W, W - 3, 5u }) {
+                luma_plane(rgb.data(), W * 3, width, H, 3, scalar, SsimKernel::Scalar);
+                luma_plane(rgb.data(), W * 3, width, H, 3, simd, kernel);
+                EXPECT_EQ(simd, scalar) << to_string(kernel) << " " << width;
+            }
+        }
+        EXPECT_TRUE(ssim_kernel_supported(best_ssim_kernel()));
+        EXPECT_TRUE(ssim_kernel_supported(SsimKernel::Scalar));
+    }
+
+} // namespace media_handler::tests
@@ -0,0 +1,97 @@
+#include <gtest/gtest.h>
+#include "compressor/jpeg_strip_encoder.h"
+#include "tools/synthetic_media.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace media_handler::tests {
+
+    using namespace media_handler::compressor;
+
+    class JpegStripEncoderTest : public ::testing::Test {
+    protected:
+        struct Decoded {
+            unsigned width = 0;
+            unsigned height = 0;
+            long warnings = 0; // A misnumbered restart marker makes libjpeg warn and resync.
+            unsigned restart_interval = 0;
+            std::vector<JSAMPLE> pixels;
+            std::vector<std::string> app1;
+        };
+
+        static Decoded decode(const std::vector<JOCTET>& jpeg, std::size_t size) {
+            Decoded d;
+            jpeg_decompress_struct cinfo;
+            jpeg_error_mgr jerr;
+            cinfo.err = jpeg_std_error(&jerr);
+            jerr.emit_message = [](j_common_ptr c, int level) { if (level < 0) ++c->err->num_warnings; };
+            jpeg_create_decompress(&cinfo);
+            jpeg_mem_src(&cinfo, jpeg.data(), static_cast<unsigned long>(size));
+            jpeg_save_markers(&cinfo, JPEG_APP0 + 1, 0xFFFF);
+            jpeg_read_header(&cinfo, TRUE);
+            for (auto* m = cinfo.marker_list; m; m = m->next)
+                d.app1.emplace_back(reinterpret_cast<const char*>(m->data), m->data_length);
+            d.restart_interval = cinfo.restart_interval;
+            jpeg_start_decompress(&cinfo);
+            d.width = cinfo.output_width;
+            d.height = cinfo.output_height;
+            const std::size_t stride = static_cast<std::size_t>(cinfo.output_width) * cinfo.output_components;
+            d.pixels.resize(stride * cinfo.output_height);
+            while (cinfo.output_scanline < cinfo.output_height) {
+                JSAMPROW rows[1] = { d.pixels.data() + stride * cinfo.output_scanline };
+                jpeg_read_scanlines(&cinfo, rows, 1);
+            }
+            jpeg_finish_decompress(&cinfo);
+            d.warnings = jerr.num_warnings;
+            jpeg_destroy_decompress(&cinfo);
+            return d;
+        }
+
+        static Decoded encode(const StripImage& image, unsigned threads, const JpegMarkerWriter& markers = {}) {
+            std::vector<JOCTET> out;
+            auto size = encode_jpeg_strips(image, 80, utils::JpegProfile::Balanced, threads, markers, out);
+            EXPECT_TRUE(size.has_value()) << size.error();
+            return size ? decode(out, *size) : Decoded{};
+        }
+    };
+
+    /// @brief Strips joined with renumbered restart markers decode cleanly and exactly like one strip.
+    TEST_F(JpegStripEncoderTest, Parallel_DecodesLikeSingleStrip) {
+        constexpr int W = 1000, H = 700; // Neither a multiple of the 16-pixel MCU.
+        const auto rgb = tools::synthetic_rgb(W, H, 7);
+        const StripImage image{ rgb.data(), W * 3u, W, H, 3, JCS_RGB };
+
+        const auto single = encode(image, 1);
+        const auto parallel = encode(image, 4);
+        EXPECT_EQ(parallel.width, static_cast<unsigned>(W));
+        EXPECT_EQ(parallel.height, static_cast<unsigned>(H));
+        EXPECT_EQ(parallel.warnings, 0);
+        EXPECT_EQ(parallel.restart_interval, (W + 15) / 16u); // One MCU row per interval.
+        EXPECT_EQ(parallel.pixels, single.pixels);
+    }
+
+    /// @brief More threads than MCU rows still yields one valid image; grayscale uses 8-row MCUs.
+    TEST_F(JpegStripEncoderTest, Grayscale_MoreThreadsThanRows) {
+        constexpr int W = 50, H = 20;
+        std::vector<JSAMPLE> gray(W * H);
+        for (int i = 0; i < W * H; ++i) gray[i] = static_cast<JSAMPLE>(i * 7);
+        const auto out = encode({ gray.data(), W, W, H, 1, JCS_GRAYSCALE }, 8);
+        EXPECT_EQ(out.width, static_cast<unsigned>(W));
+        EXPECT_EQ(out.height, static_cast<unsigned>(H));
+        EXPECT_EQ(out.warnings, 0);
+    }
+
+    /// @brief APP markers are written once, into the headers, not once per strip.
+    TEST_F(JpegStripEncoderTest, Markers_WrittenOnce) {
+        constexpr int W = 256, H = 256;
+        const auto rgb = tools::synthetic_rgb(W, H, 3);
+        const std::string payload = "Exif\0\0strip test";
+        const auto out = encode({ rgb.data(), W * 3u, W, H, 3, JCS_RGB }, 4, [&](j_compress_ptr cinfo) {
+            jpeg_write_marker(cinfo, JPEG_APP0 + 1, reinterpret_cast<const JOCTET*>(payload.data()), static_cast<unsigned>(payload.size()));
+            });
+        EXPECT_EQ(out.app1, std::vector<std::string>{ payload });
+        EXPECT_EQ(out.warnings, 0);
+    }
+
+} // namespace media_handler::tests
@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+#include "utils/lock_stats.h"
+#include "utils/utils.h"
+#include <condition_variable>
+#include <thread>
+
+namespace media_handler::tests {
+
+    using namespace media_handler::utils;
+    using namespace std::chrono_literals;
+
+    /// @brief Stats for a lock name, or an empty snapshot if it was never acquired.
+    static LockStats::Snapshot stats_of(const std::string& name) {
+        for (auto& s : LockStats::all())
+            if (s.name == name) return s;
+        return {};
+    }
+
+    /// @brief Verify uncontended acquisitions are counted and hold time accumulates.
+    TEST(LockStatsTest, Uncontended_CountsAcquisitionsAndHold) {
+        InstrumentedMutex m("test_uncontended");
+        for (int i = 0; i < 3; ++i) {
+            std::lock_guard lock(m);
+            std::this_thread::sleep_for(5ms);
+        }
+
+        auto s = stats_of("test_uncontended");
+        EXPECT_EQ(s.acquisitions, 3u);
+        EXPECT_EQ(s.contended, 0u);
+        EXPECT_EQ(s.wait, 0ns);
+        EXPECT_GE(s.hold, 15ms);
+    }
+
+    /// @brief Verify a thread blocked on a held lock records its wait.
+    TEST(LockStatsTest, Contended_RecordsWait) {
+        InstrumentedMutex m("test_contended");
+        std::unique_lock held(m);
+
+        std::thread waiter([&] { std::lock_guard lock(m); });
+        std::this_thread::sleep_for(30ms);
+        held.unlock();
+        waiter.join();
+
+        auto s = stats_of("test_contended");
+        EXPECT_EQ(s.acquisitions, 2u);
+        EXPECT_EQ(s.contended, 1u);
+        EXPECT_GE(s.wait, 20ms);
+        EXPECT_EQ(s.max_wait, s.wait);
+    }
+
+    /// @brief Verify time asleep in a condition wait is not charged as hold time.
+    TEST(LockStatsTest, ConditionWait_NotCountedAsHold) {
+        InstrumentedMutex m("test_cv");
+        std::condition_variable_any cv;
+        std::unique_lock lock(m);
+        cv.wait_for(lock, 30ms, [] { return false; });
+        lock.unlock();
+
+        EXPECT_LT(stats_of("test_cv").hold, 20ms);
+    }
+
+    /// @brief Verify mutexes with the same name share stats and reset_all() zeroes them.
+    TEST(LockStatsTest, SameName_SharesStats) {
+        InstrumentedMutex a("test_shared");
+        InstrumentedMutex b("test_shared");
+        { std::lock_guard lock(a); }
+        { std::lock_guard lock(b); }
+        EXPECT_EQ(stats_of("test_shared").acquisitions, 2u);
+
+        LockStats::reset_all();
+        EXPECT_EQ(stats_of("test_shared").acquisitions, 0u);
+    }
+
+    /// @brief Verify the application logger reports its async queue enqueues.
+    TEST(LockStatsTest, Logger_RecordsQueueEnqueues) {
+        auto logger = Logger::create("LockStatsTest");
+        const auto before = stats_of("log queue").acquisitions;
+        logger->info("one");
+        logger->info("two");
+        logger->debug("filtered out"); // Below the level: never enqueued.
+        logger->flush();
+
+        EXPECT_EQ(stats_of("log queue").acquisitions, before + 2);
+    }
+
+} // namespace media_handler::tests
@@ -0,0 +1,155 @@
+#include <gtest/gtest.h>
+#include "utils/log_event.h"
+#include "utils/utils.h"
+#include "test_common.h"
+#include <nlohmann/json.hpp>
+#include <spdlog/formatter.h>
+#include <spdlog/sinks/base_sink.h>
+#include <string>
+
+namespace media_handler::tests {
+
+    using utils::FixedBuffer;
+    using utils::JsonWriter;
+    using utils::LogEvent;
+
+    class LogEventTest : public TestCommon {
+    protected:
+        /// @brief One record through the JSON or text line formatter, as a sink would write it.
+        std::string format(bool json, std::string_view payload, spdlog::level::level_enum level = spdlog::level::info) {
+            spdlog::details::log_msg msg("test", level, spdlog::string_view_t(payload.data(), payload.size()));
+            spdlog::memory_buf_t out;
+            utils::Logger::formatter(json)->format(msg, out);
+            return std::string(out.data(), out.size());
+        }
+
+        /// @brief Logger that captures the raw payload of the last record.
+        class CaptureSink final : public spdlog::sinks::base_sink<std::mutex> {
+        public:
+            std::string payload;
+        protected:
+            void sink_it_(const spdlog::details::log_msg& msg) override { payload.assign(msg.payload.data(), msg.payload.size()); }
+            void flush_() override {}
+        };
+    };
+
+    TEST_F(LogEventTest, JsonWriter_EscapesStrings) {
+        FixedBuffer<128> buf;
+        JsonWriter json(buf);
+        json.string("a\"b\\c\nd\te\x01" "f/é");
+        EXPECT_EQ(std::string_view(buf.data(), buf.size()), R"("a\"b\\c\nd\te\u0001f/é")");
+    }
+
+    TEST_F(LogEventTest, JsonWriter_NumbersAndKeys) {
+        FixedBuffer<128> buf;
+        JsonWriter json(buf);
+        json.key("a");
+        json.number(std::uint64_t{ 18'446'744'073'709'551'615ull });
+        json.key("b");
+        json.number(-1.5);
+        json.key("c");
+        json.number(0.0 / 0.0);
+        json.key("d");
+        json.boolean(true);
+        EXPECT_EQ(std::string_view(buf.data(), buf.size()), R"("a": 18446744073709551615, "b": -1.5, "c": null, "d": true)");
+    }
+
+    TEST_F(LogEventTest, FixedBuffer_RejectsWhatDoesNotFit) {
+        FixedBuffer<4> buf;
+        const char text[] = "abcdef";
+        buf.append(text, text + 3);
+        buf.append(text, text + 3);
+        EXPECT_EQ(buf.size(), 3u);
+        EXPECT_TRUE(buf.overflowed());
+        buf.truncate(1);
+        EXPECT_EQ(buf.size(), 1u);
+        EXPECT_FALSE(buf.overflowed());
+    }
+
+    TEST_F(LogEventTest, Format_PayloadCarriesFieldsAndMessage) {
+        LogEvent event("file_ok");
+        event.field("file", "a.jpg").field("size_in", 10).field("ok", true);
+
+        std::string_view fields, message;
+        ASSERT_TRUE(LogEvent::split(event.format("OK {} {}", "a.jpg", 10), fields, message));
+        EXPECT_EQ(fields, R"("event": "file_ok", "file": "a.jpg", "size_in": 10, "ok": true)");
+        EXPECT_EQ(message, "OK a.jpg 10");
+        EXPECT_FALSE(LogEvent::split("plain message", fields, message));
+    }
+
+    /// @brief A logger that does not come from Logger::create() gets only the message.
+    TEST_F(LogEventTest, Log_OtherLoggersGetPlainMessage) {
+        auto sink = std::make_shared<CaptureSink>();
+        spdlog::logger logger("capture", sink);
+        EXPECT_FALSE(utils::Logger::structured(logger));
+
+        LogEvent("file_ok").field("size_in", 10).log(logger, spdlog::level::info, "OK {}", "a.jpg");
+        EXPECT_EQ(sink->payload, "OK a.jpg");
+
+        sink->payload.clear();
+        logger.set_level(spdlog::level::info);
+        LogEvent("file_ok").log(logger, spdlog::level::debug, "hidden");
+        EXPECT_TRUE(sink->payload.empty());
+    }
+
+    TEST_F(LogEventTest, Log_CreatedLoggersAreStructured) {
+        auto logger = utils::Logger::create("LogEventStructured", spdlog::level::info, true);
+        EXPECT_TRUE(utils::Logger::structured(*logger));
+    }
+
+    /// @brief Fields that would not leave room for the message are left out whole; the message is cut short.
+    TEST_F(LogEventTest, Format_OversizedInputStaysWellFormed) {
+        const std::string huge(4000, 'x');
+        LogEvent event("big");
+        event.field("first", 1).field("huge", huge).field("last", 2);
+        const auto payload = event.format("{}", huge);
+
+        std::string_view fields, message;
+        ASSERT_TRUE(LogEvent::split(payload, fields, message));
+        EXPECT_EQ(fields, R"("event": "big", "first": 1, "last": 2)");
+        EXPECT_FALSE(message.empty());
+        EXPECT_LE(payload.size(), LogEvent::CAPACITY);
+
+        auto j = nlohmann::json::parse(format(true, payload));
+        EXPECT_EQ(j["last"], 2);
+    }
+
+    /// @brief Quotes, backslashes and control characters in a message still give a parseable line.
+    TEST_F(LogEventTest, JsonFormatter_EscapesPlainMessages) {
+        const std::string text = "Cannot open C:\\photos\\\"odd\".jpg\n\tretrying";
+        auto line = format(true, text, spdlog::level::warn);
+        ASSERT_FALSE(line.empty());
+        EXPECT_EQ(line.back(), '\n');
+
+        auto j = nlohmann::json::parse(line);
+        EXPECT_EQ(j["message"], text);
+        EXPECT_EQ(j["level"], "warning");
+        EXPECT_TRUE(j["thread"].is_string());
+        EXPECT_EQ(j["timestamp"].get<std::string>().size(), std::string("2024-05-01T10:00:00.123Z").size());
+        EXPECT_FALSE(j.contains("event"));
+    }
+
+    TEST_F(LogEventTest, JsonFormatter_WritesEventFieldsAsKeys) {
+        LogEvent event("file_fail");
+        event.field("file", "/in/\"a\".jpg").field("elapsed_ms", 12);
+
+        auto line = format(true, event.format("FAIL {}", "\"a\".jpg"), spdlog::level::err);
+        EXPECT_NE(line.find(R"("message": "FAIL \"a\".jpg", "event": "file_fail")"), std::string::npos) << line;
+
+        auto j = nlohmann::json::parse(line);
+        EXPECT_EQ(j["event"], "file_fail");
+        EXPECT_EQ(j["file"], "/in/\"a\".jpg");
+        EXPECT_EQ(j["elapsed_ms"], 12);
+    }
+
+    TEST_F(LogEventTest, TextFormatter_ShowsOnlyTheMessage) {
+        LogEvent event("file_ok");
+        event.field("size_in", 10);
+
+        auto line = format(false, event.format("OK {}", "a.jpg"));
+        EXPECT_NE(line.find("] OK a.jpg"), std::string::npos) << line;
+        EXPECT_EQ(line.find("size_in"), std::string::npos) << line;
+        EXPECT_EQ(line.find(LogEvent::SEPARATOR), std::string::npos);
+    }
+
+} // namespace media_handler::tests
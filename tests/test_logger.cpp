@@ -7,6 +7,9 @@
 #include <future>
 #include <string>
 #include <nlohmann/json.hpp>
+#include <spdlog/async.h>
+#include <spdlog/sinks/base_sink.h>
+#include <latch>
 #include "utils/utils.h"
 #include "test_common.h"
 
@@ -32,6 +35,39 @@ namespace media_handler::tests {
 			TestCommon::TearDown();
 		}
 
+		/// @brief Sink that holds the (single) spdlog worker thread until released, so the async queue fills up.
+		class StallSink final : public spdlog::sinks::base_sink<std::mutex> {
+		public:
+			std::latch entered{ 1 }, release{ 1 };
+		protected:
+			void sink_it_(const spdlog::details::log_msg&) override {
+				entered.count_down();
+				release.wait();
+			}
+			void flush_() override {}
+		};
+
+		/// @brief Log `n` messages while the queue is stalled; returns how long the calls took.
+		std::chrono::milliseconds log_while_stalled(utils::LogOverflow policy, int n) {
+			auto logger = utils::Logger::create("Overflow", spdlog::level::info);
+			for (auto& sink : logger->sinks()) sink->set_level(spdlog::level::off); // Keep the test output quiet.
+
+			auto stall = std::make_shared<StallSink>();
+			auto blocker = std::make_shared<spdlog::async_logger>("OverflowBlocker", stall, spdlog::thread_pool());
+			blocker->info("stall");
+			stall->entered.wait();
+
+			utils::Logger::set_overflow(policy);
+			const auto t0 = std::chrono::steady_clock::now();
+			for (int i = 0; i < n; ++i) logger->info("Overflow {}", i);
+			const auto took = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - t0);
+			utils::Logger::set_overflow(utils::LogOverflow::Block);
+
+			stall->release.count_down();
+			utils::Logger::flush_all();
+			return took;
+		}
+
 		/// @brief Return content as string
 		std::string read_file(const std::string& path) {
 			if (!std::filesystem::exists(path)) return "";
@@ -197,4 +233,65 @@ namespace media_handler::tests {
 		EXPECT_TRUE(content.find("Third") != std::string::npos);
 		EXPECT_TRUE(content.find("Fourth") != std::string::npos);
 	}
+
+	TEST_F(LoggerTest, ParseLogOverflow) {
+		EXPECT_EQ(utils::parse_log_overflow("block"), utils::LogOverflow::Block);
+		EXPECT_EQ(utils::parse_log_overflow("drop-oldest"), utils::LogOverflow::DropOldest);
+		EXPECT_EQ(utils::parse_log_overflow("drop-new"), utils::LogOverflow::DropNew);
+		EXPECT_FALSE(utils::parse_log_overflow("drop"));
+	}
+
+	/// @brief With a stalled consumer, drop-new discards what does not fit instead of blocking the caller.
+	TEST_F(LoggerTest, DropNew_NeverBlocksAndCounts) {
+		const auto before = utils::Logger::drops();
+		const auto took = log_while_stalled(utils::LogOverflow::DropNew, 20'000);
+		const auto after = utils::Logger::drops();
+
+		EXPECT_LT(took.count(), 5'000);
+		// The queue holds 8192 messages; the rest is dropped.
+		EXPECT_GE(after.newest + after.oldest - before.newest - before.oldest, 20'000u - 8192u);
+		EXPECT_GT(after.newest, before.newest);
+	}
+
+	TEST_F(LoggerTest, DropOldest_NeverBlocksAndCounts) {
+		const auto before = utils::Logger::drops();
+		const auto took = log_while_stalled(utils::LogOverflow::DropOldest, 20'000);
+		const auto after = utils::Logger::drops();
+
+		EXPECT_LT(took.count(), 5'000);
+		EXPECT_GE(after.oldest - before.oldest, 20'000u - 8192u);
+		EXPECT_EQ(after.newest, before.newest);
+	}
+
+	/// @brief A LogSite lets a burst through, then holds messages back and reports how many on the next one.
+	TEST_F(LoggerTest, LogSite_BurstThenSuppressed) {
+		utils::LogSite site(3, 20.0); // 3 at once, then one per 50 ms.
+		const auto before = utils::LogSite::suppressed_total();
+
+		for (int i = 0; i < 3; ++i) {
+			auto held = site.allow();
+			ASSERT_TRUE(held);
+			EXPECT_EQ(*held, 0u);
+		}
+		for (int i = 0; i < 5; ++i) EXPECT_FALSE(site.allow());
+		EXPECT_EQ(utils::LogSite::suppressed_total() - before, 5u);
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(60));
+		auto held = site.allow();
+		ASSERT_TRUE(held);
+		EXPECT_EQ(*held, 5u);
+		EXPECT_EQ(utils::LogSite::note(*held), " (5 similar suppressed)");
+		EXPECT_EQ(utils::LogSite::note(0), "");
+	}
+
+	/// @brief Concurrent callers never get more than the burst through within one interval.
+	TEST_F(LoggerTest, LogSite_ConcurrentCallersShareTheBudget) {
+		utils::LogSite site(10, 0.001); // Effectively no refill during the test.
+		std::atomic<int> allowed{ 0 };
+		std::vector<std::thread> threads;
+		for (int t = 0; t < 4; ++t)
+			threads.emplace_back([&] { for (int i = 0; i < 1000; ++i) if (site.allow()) ++allowed; });
+		for (auto& t : threads) t.join();
+		EXPECT_EQ(allowed.load(), 10);
+	}
 } // namespace media_handler::tests
\ No newline at end of file
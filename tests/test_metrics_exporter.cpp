@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+#include "utils/metrics_exporter.h"
+#include "test_common.h"
+#include <spdlog/sinks/ostream_sink.h>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace media_handler::tests {
+
+    namespace fs = std::filesystem;
+    using namespace media_handler::utils;
+
+    class MetricsExporterTest : public TestCommon {
+    protected:
+        std::string read_file(const fs::path& path) {
+            std::ifstream f(path);
+            return { std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>() };
+        }
+    };
+
+    /// @brief Verify counters, byte totals and per-kind histogram counts are rendered from tracker state.
+    TEST_F(MetricsExporterTest, Render_ReflectsTrackerCounters) {
+        ProgressTracker tracker(3, spdlog::default_logger());
+        tracker.set_workers(4);
+        tracker.set_queue_depth(7);
+        make_file(path("in.jpg"), 1000);
+        make_file(path("out.jpg"), 400);
+
+        auto t0 = tracker.begin_file(path("in.jpg"), MediaKind::Image);
+        tracker.finish_file(t0, path("out.jpg"), true);
+        auto t1 = tracker.begin_file(path("in.jpg"), MediaKind::Video);
+        tracker.finish_file(t1, {}, false, "codec failure");
+        tracker.record_state_commit(std::chrono::milliseconds(3));
+
+        auto text = MetricsExporter::render(tracker.snapshot());
+
+        EXPECT_NE(text.find("media_handler_files_total{outcome=\"ok\"} 1\n"), std::string::npos);
+        EXPECT_NE(text.find("media_handler_files_total{outcome=\"failed\"} 1\n"), std::string::npos);
+        EXPECT_NE(text.find("media_handler_bytes_in_total 1000\n"), std::string::npos);
+        EXPECT_NE(text.find("media_handler_bytes_out_total 400\n"), std::string::npos);
+        EXPECT_NE(text.find("media_handler_processing_seconds_count{kind=\"image\"} 1\n"), std::string::npos);
+        EXPECT_NE(text.find("media_handler_processing_seconds_count{kind=\"video\"} 1\n"), std::string::npos);
+        EXPECT_NE(text.find("media_handler_queue_depth 7\n"), std::string::npos);
+        EXPECT_NE(text.find("media_handler_workers{state=\"idle\"} 4\n"), std::string::npos);
+        EXPECT_NE(text.find("media_handler_state_commit_seconds_bucket{le=\"0.005\"} 1\n"), std::string::npos);
+        EXPECT_NE(text.find("media_handler_state_commit_seconds_bucket{le=\"+Inf\"} 1\n"), std::string::npos);
+    }
+
+    /// @brief Verify busy workers are reported while a WorkerScope is alive.
+    TEST_F(MetricsExporterTest, WorkerScope_TracksBusyWorkers) {
+        ProgressTracker tracker(1, spdlog::default_logger());
+        tracker.set_workers(2);
+        {
+            ProgressTracker::WorkerScope busy(tracker);
+            EXPECT_EQ(tracker.snapshot().busy_workers, 1u);
+        }
+        EXPECT_EQ(tracker.snapshot().busy_workers, 0u);
+    }
+
+    /// @brief Verify the exporter writes the file on start and leaves no temporary file behind.
+    TEST_F(MetricsExporterTest, Write_IsAtomicAndLeavesNoTmpFile) {
+        ProgressTracker tracker(1, spdlog::default_logger());
+        const auto file = path("media_handler.prom");
+        {
+            MetricsExporter exporter(tracker, file, std::chrono::seconds(60), spdlog::default_logger());
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            EXPECT_TRUE(fs::exists(file));
+        }
+
+        EXPECT_FALSE(fs::exists(path("media_handler.prom.tmp")));
+        EXPECT_NE(read_file(file).find("# TYPE media_handler_files_total counter"), std::string::npos);
+    }
+
+    /// @brief Verify write() from other threads (the control socket's flush) never races the export thread on the tmp file.
+    TEST_F(MetricsExporterTest, Write_ConcurrentCallersAreSerialized) {
+        std::ostringstream out;
+        auto capture = std::make_shared<spdlog::logger>("metrics_capture", std::make_shared<spdlog::sinks::ostream_sink_mt>(out));
+        ProgressTracker tracker(1, spdlog::default_logger());
+        const auto file = path("media_handler.prom");
+        {
+            MetricsExporter exporter(tracker, file, std::chrono::seconds(1), capture);
+            std::vector<std::jthread> writers;
+            for (int t = 0; t < 4; ++t)
+                writers.emplace_back([&exporter] { for (int i = 0; i < 200; ++i) exporter.write(); });
+        }
+        capture->flush();
+
+        // A racing writer finds the tmp file already renamed away, or renames one still being written.
+        EXPECT_EQ(out.str(), "");
+        EXPECT_FALSE(fs::exists(path("media_handler.prom.tmp")));
+        EXPECT_NE(read_file(file).find("# TYPE media_handler_files_total counter"), std::string::npos);
+    }
+
+    /// @brief Verify a failed write (here ENOSPC through /dev/full) keeps the previous file instead of replacing it.
+    TEST_F(MetricsExporterTest, Write_FailedStreamKeepsPreviousFile) {
+        if (!fs::exists("/dev/full")) GTEST_SKIP() << "no /dev/full to fail writes with";
+        ProgressTracker tracker(1, spdlog::default_logger());
+        const auto file = path("media_handler.prom");
+        {
+            std::ofstream f(file);
+            f << "previous\n";
+        }
+        fs::create_symlink("/dev/full", path("media_handler.prom.tmp"));
+
+        MetricsExporter exporter(tracker, file, std::chrono::seconds(60), spdlog::default_logger());
+        exporter.write();
+
+        ASSERT_FALSE(fs::is_symlink(file)); // Committed over the good file; reading it would never end.
+        EXPECT_EQ(read_file(file), "previous\n");
+    }
+
+    /// @brief Verify the final snapshot is written when the exporter is destroyed.
+    TEST_F(MetricsExporterTest, Destructor_WritesFinalSnapshot) {
+        ProgressTracker tracker(1, spdlog::default_logger());
+        const auto file = path("media_handler.prom");
+        {
+            MetricsExporter exporter(tracker, file, std::chrono::seconds(60), spdlog::default_logger());
+            tracker.skip_file(path("done.jpg"));
+        }
+
+        EXPECT_NE(read_file(file).find("media_handler_files_total{outcome=\"skipped\"} 1\n"), std::string::npos);
+    }
+
+} // namespace media_handler::tests
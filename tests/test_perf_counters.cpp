@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+#include "utils/perf_counters.h"
+#include "utils/work_context.h"
+#include "utils/progress_tracker.h"
+#include "test_common.h"
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <spdlog/sinks/ostream_sink.h>
+
+namespace media_handler::tests {
+
+    namespace fs = std::filesystem;
+    using namespace media_handler::utils;
+
+    class PerfCountersTest : public TestCommon {};
+
+    /// @brief Verify counter deltas and IPC.
+    TEST_F(PerfCountersTest, PerfValues_Arithmetic) {
+        PerfValues a{ 1000, 2500, 10, 5 };
+        PerfValues b{ 400, 1000, 4, 2 };
+
+        auto d = a - b;
+        EXPECT_EQ(d.cycles, 600u);
+        EXPECT_EQ(d.instructions, 1500u);
+        EXPECT_DOUBLE_EQ(d.ipc(), 2.5);
+
+        d += b;
+        EXPECT_EQ(d.cycles, a.cycles);
+        EXPECT_EQ(d.branch_misses, a.branch_misses);
+        EXPECT_DOUBLE_EQ(PerfValues{}.ipc(), 0.0);
+    }
+
+    /// @brief Verify StageTimer charges wall time to its stage of the current file only.
+    TEST_F(PerfCountersTest, StageTimer_AccumulatesWallTime) {
+        WorkContext::current().reset();
+        {
+            StageTimer t(Stage::Encode);
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+        {
+            StageTimer t(Stage::Encode);
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+
+        const auto& stages = WorkContext::current().stages;
+        EXPECT_GE(stages[static_cast<std::size_t>(Stage::Encode)].wall, std::chrono::milliseconds(30));
+        EXPECT_EQ(stages[static_cast<std::size_t>(Stage::Decode)].wall, std::chrono::nanoseconds(0));
+    }
+
+    /// @brief Verify counters either work or are refused gracefully, and are attributed per stage.
+    TEST_F(PerfCountersTest, Enable_CountsCyclesOrDeclines) {
+        auto logger = spdlog::default_logger();
+        if (!PerfCounters::enable(logger)) {
+            EXPECT_FALSE(PerfCounters::enabled());
+            EXPECT_EQ(PerfCounters::read().cycles, 0u);
+            GTEST_SKIP() << "perf_event_open not permitted here";
+        }
+
+        auto before = PerfCounters::read();
+        burn_cpu(std::chrono::milliseconds(20));
+        auto after = PerfCounters::read();
+        EXPECT_GT(after.cycles, before.cycles);
+        EXPECT_GT(after.instructions, before.instructions);
+
+        // The tracker reports a per-stage cycle split in its summary.
+        std::ostringstream out;
+        auto sink = std::make_shared<spdlog::sinks::ostream_sink_mt>(out);
+        auto capture = std::make_shared<spdlog::logger>("perf_capture", sink);
+        std::ofstream(path("in.jpg")) << "data";
+        std::ofstream(path("out.jpg")) << "d";
+
+        ProgressTracker tracker(1, capture);
+        auto token = tracker.begin_file(path("in.jpg"), MediaKind::Image);
+        WorkContext::current().pixels = 1'000'000;
+        {
+            StageTimer t(Stage::Encode);
+            burn_cpu(std::chrono::milliseconds(20));
+        }
+        tracker.finish_file(token, path("out.jpg"), true);
+        tracker.print_summary();
+
+        EXPECT_NE(out.str().find("IPC"), std::string::npos);
+        EXPECT_NE(out.str().find("encode"), std::string::npos);
+    }
+
+} // namespace media_handler::tests
@@ -5,6 +5,8 @@
 #include <thread>
 #include <vector>
 #include <future>
+#include <sstream>
+#include <spdlog/sinks/ostream_sink.h>
 
 namespace fs = std::filesystem;
 using namespace media_handler::utils;
@@ -85,6 +87,20 @@ TEST_F(ProgressTrackerTest, skip_file_DoesNotThrow) {
     EXPECT_NO_THROW(tracker.skip_file(file_in));
 }
 
+/// @brief Verify a passthrough result is counted on its own, not as OK or skipped, and still counts as done
+TEST_F(ProgressTrackerTest, finish_file_Passthrough_CountedSeparately) {
+    ProgressTracker tracker(1, logger);
+    auto token = tracker.begin_file(file_in);
+    tracker.finish_file(token, file_in, true, "predicted saving 2% < 5%", true);
+
+    const auto snap = tracker.snapshot();
+    EXPECT_EQ(snap.passthrough, 1u);
+    EXPECT_EQ(snap.completed, 0u);
+    EXPECT_EQ(snap.skipped, 0u);
+    EXPECT_EQ(snap.bytes_in, snap.bytes_out);
+    EXPECT_EQ(tracker.progress(0).files_done, 1u);
+}
+
 /// @brief Verify that after a single successful file, the completed counter is correct as reflected in print_summary() output
 TEST_F(ProgressTrackerTest, SingleSuccess_CountersCorrect) {    
     ProgressTracker tracker(1, logger);
@@ -220,4 +236,62 @@ TEST_F(ProgressTrackerTest, ElapsedTime_IsNonNegative) {
     tracker.finish_file(token, file_out, true);
 
     EXPECT_NO_THROW(tracker.print_summary());
-}
\ No newline at end of file
+}
+
+/// @brief Verify a skipped file's bytes land under its own kind, so that kind's ETA drops out.
+TEST_F(ProgressTrackerTest, finish_file_Skipped_CountsBytesUnderKind) {
+    ProgressTracker tracker(1, logger);
+    make_file(dir / "small.jpg", 1024);
+    tracker.add_planned(MediaKind::Image, 1024);
+
+    auto token = tracker.begin_file(dir / "small.jpg", MediaKind::Image);
+    tracker.finish_file(token, file_out, true, "skipped (already compressed)");
+
+    auto p = tracker.progress(0);
+    EXPECT_EQ(p.bytes_done, 1024u);
+    EXPECT_DOUBLE_EQ(p.percent, 100.0);
+    // Nothing left to process; under MediaKind::Other the image bytes would still look pending with no rate.
+    ASSERT_TRUE(p.eta.has_value());
+    EXPECT_EQ(p.eta->count(), 0);
+}
+
+/// @brief Verify the heartbeat reports byte-weighted progress rather than file counts.
+TEST_F(ProgressTrackerTest, log_heartbeat_UsesByteWeightedProgress) {
+    std::ostringstream out;
+    auto sink = std::make_shared<spdlog::sinks::ostream_sink_mt>(out);
+    auto capture = std::make_shared<spdlog::logger>("heartbeat_capture", sink);
+
+    ProgressTracker tracker(2, capture);
+    make_file(dir / "small.jpg", 1024);
+    make_file(dir / "large.mp4", 3 * 1024);
+    tracker.add_planned(MediaKind::Image, 1024);
+    tracker.add_planned(MediaKind::Video, 3 * 1024);
+
+    // One of two files done, but only a quarter of the bytes.
+    auto t0 = tracker.begin_file(dir / "small.jpg", MediaKind::Image);
+    tracker.finish_file(t0, file_out, true);
+    tracker.begin_file(dir / "large.mp4", MediaKind::Video);
+
+    tracker.log_heartbeat();
+    capture->flush();
+
+    auto line = out.str();
+    EXPECT_NE(line.find("1/2 files"), std::string::npos) << line;
+    EXPECT_NE(line.find("(25.0%)"), std::string::npos) << line;
+    EXPECT_NE(line.find("in flight: large.mp4"), std::string::npos) << line;
+}
+
+/// @brief Verify per-file OK lines are debug-level and suppressed at info.
+TEST_F(ProgressTrackerTest, finish_file_OkLineIsDebugLevel) {
+    std::ostringstream out;
+    auto sink = std::make_shared<spdlog::sinks::ostream_sink_mt>(out);
+    auto capture = std::make_shared<spdlog::logger>("ok_line_capture", sink);
+    capture->set_level(spdlog::level::info);
+
+    ProgressTracker tracker(1, capture);
+    auto token = tracker.begin_file(file_in);
+    tracker.finish_file(token, file_out, true);
+    capture->flush();
+
+    EXPECT_EQ(out.str().find("OK input.mp4"), std::string::npos);
+}
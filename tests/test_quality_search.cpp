@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+#include "compressor/quality_search.h"
+#include "compressor/image_metrics.h"
+#include "tools/synthetic_media.h"
+#include <cstdint>
+#include <vector>
+
+namespace media_handler::tests {
+
+    using namespace media_handler::compressor;
+
+    class QualitySearchTest : public ::testing::Test {
+    protected:
+        static constexpr unsigned W = 1280, H = 960; // Large enough to be probed through tiles.
+
+        std::vector<std::uint8_t> rgb = tools::synthetic_rgb(W, H, 12);
+
+        StripImage image() const { return { rgb.data(), W * 3u, W, H, 3, JCS_RGB }; }
+
+        static QualitySearch search(const StripImage& image, QualityTarget target) {
+            auto found = search_jpeg_quality(image, target, utils::JpegProfile::Balanced);
+            EXPECT_TRUE(found.has_value()) << found.error();
+            return found.value_or(QualitySearch{});
+        }
+
+        /// @brief Bytes of a full-size encode at `quality`.
+        static std::size_t encode_full(const StripImage& image, int quality, std::vector<JOCTET>& out) {
+            auto size = encode_jpeg_strips(image, quality, utils::JpegProfile::Balanced, 1, {}, out);
+            EXPECT_TRUE(size.has_value());
+            return size.value_or(0);
+        }
+
+        /// @brief Luma SSIM of a full-size grayscale encode at `quality`.
+        double full_ssim(int quality) const {
+            std::vector<std::uint8_t> luma;
+            luma_plane(rgb.data(), W * 3, W, H, 3, luma);
+            std::vector<JOCTET> jpeg;
+            const std::size_t size = encode_full({ luma.data(), W, W, H, 1, JCS_GRAYSCALE }, quality, jpeg);
+
+            jpeg_decompress_struct cinfo;
+            jpeg_error_mgr jerr;
+            cinfo.err = jpeg_std_error(&jerr);
+            jpeg_create_decompress(&cinfo);
+            jpeg_mem_src(&cinfo, jpeg.data(), static_cast<unsigned long>(size));
+            jpeg_read_header(&cinfo, TRUE);
+            jpeg_start_decompress(&cinfo);
+            std::vector<std::uint8_t> decoded(luma.size());
+            while (cinfo.output_scanline < cinfo.output_height) {
+                JSAMPROW row = decoded.data() + static_cast<std::size_t>(cinfo.output_scanline) * W;
+                jpeg_read_scanlines(&cinfo, &row, 1);
+            }
+            jpeg_finish_decompress(&cinfo);
+            jpeg_destroy_decompress(&cinfo);
+            return ssim({ luma.data(), W, W, H }, { decoded.data(), W, W, H });
+        }
+    };
+
+    /// @brief The probe's pick lands the full-size image close to the SSIM target, and a higher target costs quality.
+    TEST_F(QualitySearchTest, SsimTarget_FullImageNearTarget) {
+        const auto low = search(image(), { .ssim = 0.90 });
+        const auto high = search(image(), { .ssim = 0.95 });
+        EXPECT_TRUE(low.reached);
+        EXPECT_TRUE(high.reached);
+        EXPECT_GE(low.ssim, 0.90);
+        EXPECT_LT(low.quality, high.quality);
+        EXPECT_LE(high.probes, 8);
+        EXPECT_NEAR(full_ssim(high.quality), 0.95, 0.01);
+    }
+
+    /// @brief The picked quality keeps the full-size colour encode near the bit budget.
+    TEST_F(QualitySearchTest, BppTarget_FullImageNearBudget) {
+        const auto found = search(image(), { .bpp = 1.0 });
+        EXPECT_TRUE(found.reached);
+        EXPECT_LE(found.bpp, 1.0);
+        std::vector<JOCTET> out;
+        const double full_bpp = encode_full(image(), found.quality, out) * 8.0 / (static_cast<double>(W) * H);
+        EXPECT_NEAR(full_bpp, 1.0, 0.08);
+    }
+
+    /// @brief Targets outside what the quality range can deliver settle on the nearest end and say so.
+    TEST_F(QualitySearchTest, UnreachableTarget_ClampsToRange) {
+        const auto fine = search(image(), { .ssim = 0.9999 });
+        EXPECT_EQ(fine.quality, SEARCH_QUALITY_MAX);
+        EXPECT_FALSE(fine.reached);
+
+        const auto tiny = search(image(), { .bpp = 0.01 });
+        EXPECT_EQ(tiny.quality, SEARCH_QUALITY_MIN);
+        EXPECT_FALSE(tiny.reached);
+    }
+
+    /// @brief Small images are searched whole; an SSIM target on CMYK pixels has no luma to score.
+    TEST_F(QualitySearchTest, SmallImageAndCmyk) {
+        const auto small = tools::synthetic_rgb(100, 60, 2);
+        const auto found = search({ small.data(), 300, 100, 60, 3, JCS_RGB }, { .ssim = 0.9 });
+        EXPECT_GE(found.quality, SEARCH_QUALITY_MIN);
+        EXPECT_LE(found.quality, SEARCH_QUALITY_MAX);
+
+        const std::vector<std::uint8_t> cmyk(64 * 64 * 4, 128);
+        EXPECT_FALSE(search_jpeg_quality({ cmyk.data(), 256, 64, 64, 4, JCS_CMYK }, { .ssim = 0.9 }, utils::JpegProfile::Balanced).has_value());
+        EXPECT_FALSE(search_jpeg_quality(image(), {}, utils::JpegProfile::Balanced).has_value());
+    }
+
+} // namespace media_handler::tests
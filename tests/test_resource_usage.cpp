@@ -0,0 +1,81 @@
+#include <gtest/gtest.h>
+#include "utils/resource_usage.h"
+#include "utils/work_context.h"
+#include "utils/progress_tracker.h"
+#include "test_common.h"
+#include <atomic>
+#include <fstream>
+#include <thread>
+
+namespace media_handler::tests {
+
+    namespace fs = std::filesystem;
+    using namespace media_handler::utils;
+
+    class ResourceUsageTest : public TestCommon {};
+
+    /// @brief Verify thread CPU time advances while the thread is busy.
+    TEST_F(ResourceUsageTest, Sample_CpuAdvancesWhenBusy) {
+        auto before = ResourceSample::now();
+        burn_cpu(std::chrono::milliseconds(30));
+        auto after = ResourceSample::now();
+
+        EXPECT_GT(after.cpu - before.cpu, std::chrono::milliseconds(5));
+    }
+
+#ifdef __linux__
+    /// @brief Verify bytes written by this thread show up in the I/O counters.
+    TEST_F(ResourceUsageTest, Sample_CountsBytesWritten) {
+        auto before = ResourceSample::now();
+        {
+            std::ofstream f(path("io.bin"), std::ios::binary);
+            std::string data(256 * 1024, 'x');
+            f.write(data.data(), data.size());
+        }
+        auto after = ResourceSample::now();
+
+        EXPECT_GE(after.write_bytes - before.write_bytes, 256u * 1024u);
+    }
+
+    /// @brief Verify CPU of a thread spawned inside the scope is attributed to the current file.
+    TEST_F(ResourceUsageTest, HelperThreadCpu_AttributesSpawnedThread) {
+        WorkContext::current().reset();
+        HelperThreadCpu helpers;
+
+        std::atomic<bool> adopted{ false }, collected{ false };
+        std::thread helper([&] {
+            while (!adopted) std::this_thread::yield();
+            burn_cpu(std::chrono::milliseconds(50));
+            while (!collected) std::this_thread::yield();
+            });
+
+        helpers.adopt();
+        adopted = true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        helpers.collect();
+        collected = true;
+        helper.join();
+
+        // /proc stat granularity is one clock tick (usually 10ms).
+        EXPECT_GE(WorkContext::current().attributed_cpu, std::chrono::milliseconds(10));
+    }
+#endif
+
+    /// @brief Verify the tracker charges CPU spent between begin_file() and finish_file() to the file's kind.
+    TEST_F(ResourceUsageTest, Tracker_AccumulatesCpuPerKind) {
+        std::ofstream(path("in.mp4")) << "data";
+        std::ofstream(path("out.mp4")) << "d";
+
+        ProgressTracker tracker(1, spdlog::default_logger());
+        auto token = tracker.begin_file(path("in.mp4"), MediaKind::Video);
+        burn_cpu(std::chrono::milliseconds(30));
+        WorkContext::current().attributed_cpu += std::chrono::seconds(2);
+        tracker.finish_file(token, path("out.mp4"), true);
+
+        auto snap = tracker.snapshot();
+        EXPECT_GT(snap.cpu_seconds[static_cast<std::size_t>(MediaKind::Video)], 2.0);
+        EXPECT_EQ(snap.cpu_seconds[static_cast<std::size_t>(MediaKind::Image)], 0.0);
+        EXPECT_NO_THROW(tracker.print_summary());
+    }
+
+} // namespace media_handler::tests
@@ -0,0 +1,145 @@
+#include <gtest/gtest.h>
+#include "utils/run_report.h"
+#include "utils/report_compare.h"
+#include "test_common.h"
+#include <filesystem>
+#include <fstream>
+
+namespace media_handler::tests {
+
+    namespace fs = std::filesystem;
+    using namespace media_handler::utils;
+
+    class RunReportTest : public TestCommon {
+    protected:
+        /// @brief Run one OK image and one failed video through a tracker streaming to the report.
+        void write_run(const fs::path& report_path) {
+            make_file(path("a,b.jpg"), 1000);
+            make_file(path("out.jpg"), 400);
+            make_file(path("clip.mp4"), 5000);
+
+            auto report = RunReport::open(report_path);
+            ASSERT_TRUE(report.has_value()) << report.error();
+
+            ProgressTracker tracker(2, spdlog::default_logger());
+            tracker.set_report(report->get());
+            auto t0 = tracker.begin_file(path("a,b.jpg"), MediaKind::Image);
+            { StageTimer t(Stage::Encode); }
+            WorkContext::current().ssim = 0.9612;
+            tracker.finish_file(t0, path("out.jpg"), true);
+            auto t1 = tracker.begin_file(path("clip.mp4"), MediaKind::Video);
+            tracker.finish_file(t1, {}, false, "codec \"x\" failed, giving up");
+            (*report)->write_summary(tracker.snapshot());
+        }
+
+        static Report make_report(double image_ms, std::uintmax_t image_out, const std::string& video_outcome) {
+            Report r;
+            r.files.push_back({ "/in/a.jpg", "image", "ok", 1'048'576, image_out, image_ms, "" });
+            r.files.push_back({ "/in/b.jpg", "image", "ok", 1'048'576, image_out, 100.0, "" });
+            r.files.push_back({ "/in/c.mp4", "video", video_outcome, 10'485'760, 5'242'880, 1000.0, "" });
+            r.wall_seconds = 2.0;
+            return r;
+        }
+    };
+
+    /// @brief Verify an NDJSON report round-trips per-file records and the summary.
+    TEST_F(RunReportTest, NdJson_RoundTrips) {
+        write_run(path("run.ndjson"));
+
+        auto r = load_report(path("run.ndjson"));
+        ASSERT_TRUE(r.has_value()) << r.error();
+        ASSERT_EQ(r->files.size(), 2u);
+        EXPECT_EQ(r->files[0].kind, "image");
+        EXPECT_EQ(r->files[0].outcome, "ok");
+        EXPECT_EQ(r->files[0].size_in, 1000u);
+        EXPECT_EQ(r->files[0].size_out, 400u);
+        EXPECT_EQ(r->files[1].outcome, "failed");
+        EXPECT_EQ(r->files[1].error, "codec \"x\" failed, giving up");
+        EXPECT_TRUE(r->wall_seconds.has_value());
+
+        std::ifstream in(path("run.ndjson"));
+        std::string first;
+        std::getline(in, first);
+        EXPECT_NE(first.find("\"stages_ms\":{\"encode\""), std::string::npos);
+        EXPECT_NE(first.find("\"ssim\":0.9612"), std::string::npos);
+        std::string second;
+        std::getline(in, second);
+        EXPECT_EQ(second.find("ssim"), std::string::npos); // Only verified outputs carry a score.
+    }
+
+    /// @brief Verify a file copied unchanged is reported with its own outcome and reason.
+    TEST_F(RunReportTest, Passthrough_RecordedAsOwnOutcome) {
+        make_file(path("in.jpg"), 1000);
+        auto report = RunReport::open(path("run.ndjson"));
+        ASSERT_TRUE(report.has_value()) << report.error();
+
+        ProgressTracker tracker(1, spdlog::default_logger());
+        tracker.set_report(report->get());
+        auto t0 = tracker.begin_file(path("in.jpg"), MediaKind::Image);
+        tracker.finish_file(t0, path("in.jpg"), true, "source quality ~60", true);
+        (*report)->write_summary(tracker.snapshot());
+
+        auto r = load_report(path("run.ndjson"));
+        ASSERT_TRUE(r.has_value()) << r.error();
+        ASSERT_EQ(r->files.size(), 1u);
+        EXPECT_EQ(r->files[0].outcome, "passthrough");
+        EXPECT_EQ(r->files[0].size_out, 1000u);
+        EXPECT_EQ(r->files[0].error, "source quality ~60");
+    }
+
+    /// @brief Verify CSV quoting survives commas and quotes in paths and errors.
+    TEST_F(RunReportTest, Csv_RoundTripsQuotedFields) {
+        write_run(path("run.csv"));
+
+        auto r = load_report(path("run.csv"));
+        ASSERT_TRUE(r.has_value()) << r.error();
+        ASSERT_EQ(r->files.size(), 2u);
+        EXPECT_EQ(fs::path(r->files[0].path).filename().string(), "a,b.jpg");
+        EXPECT_EQ(r->files[1].error, "codec \"x\" failed, giving up");
+        EXPECT_TRUE(r->wall_seconds.has_value());
+
+        std::ifstream in(path("run.csv"));
+        std::string header, first;
+        std::getline(in, header);
+        std::getline(in, first);
+        EXPECT_NE(header.find(",ssim,error"), std::string::npos);
+        EXPECT_NE(first.find(",0.9612,"), std::string::npos);
+    }
+
+    /// @brief Verify identical runs produce no regressions.
+    TEST_F(RunReportTest, Compare_IdenticalRunsClean) {
+        auto a = make_report(100.0, 524'288, "ok");
+        auto c = compare_reports(a, a);
+        EXPECT_TRUE(c.regressions.empty());
+        EXPECT_TRUE(c.slower.empty());
+        ASSERT_EQ(c.kinds.size(), 2u);
+        EXPECT_DOUBLE_EQ(c.kinds[0].throughput_change_pct, 0.0);
+    }
+
+    /// @brief Verify throughput, savings and newly failing files are flagged and slow files listed.
+    TEST_F(RunReportTest, Compare_FlagsRegressions) {
+        auto a = make_report(100.0, 524'288, "ok");
+        auto b = make_report(300.0, 734'003, "failed"); // a.jpg 3x slower, savings 50% -> 30%
+
+        auto c = compare_reports(a, b);
+        ASSERT_EQ(c.slower.size(), 1u);
+        EXPECT_EQ(c.slower[0].path, "/in/a.jpg");
+        EXPECT_NEAR(c.slower[0].change_pct, 200.0, 0.01);
+        ASSERT_EQ(c.newly_failed.size(), 1u);
+        EXPECT_EQ(c.newly_failed[0], "/in/c.mp4");
+
+        ASSERT_EQ(c.kinds.size(), 1u); // Video has no OK files in b.
+        EXPECT_NEAR(c.kinds[0].throughput_change_pct, -50.0, 0.01);
+        EXPECT_NEAR(c.kinds[0].saved_change_points, -20.0, 0.01);
+        EXPECT_EQ(c.regressions.size(), 3u);
+
+        auto text = format_comparison(c);
+        EXPECT_NE(text.find("REGRESSIONS"), std::string::npos);
+    }
+
+    /// @brief Verify an unreadable report is an error, not an empty run.
+    TEST_F(RunReportTest, Load_MissingFileIsError) {
+        EXPECT_FALSE(load_report(path("missing.ndjson")).has_value());
+    }
+
+} // namespace media_handler::tests